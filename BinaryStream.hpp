@@ -0,0 +1,58 @@
+#pragma once
+
+#include "FileStamp.hpp"
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+/// Native endian binary fields of the persistent caches.
+struct BinaryStream
+{
+  template <typename T>
+  static void writeValue(std::ostream& stream, T const& value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types could be written as is");
+    stream.write(reinterpret_cast<char const*>(&value), sizeof(value));
+  }
+
+  template <typename T>
+  static bool readValue(std::istream& stream, T& value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types could be read as is");
+    return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(value)));
+  }
+
+  static void writeString(std::ostream& stream, std::string const& value)
+  {
+    writeValue(stream, static_cast<uint32_t>(value.size()));
+    stream.write(value.data(), value.size());
+  }
+
+  static bool readString(std::istream& stream, std::string& value)
+  {
+    uint32_t size{};
+    if (!readValue(stream, size))
+    {
+      return false;
+    }
+    value.resize(size);
+    return static_cast<bool>(stream.read(&value[0], size));
+  }
+
+  static void writeStamp(std::ostream& stream, FileStamp const& stamp)
+  {
+    writeValue(stream, stamp.modificationTime);
+    writeValue(stream, stamp.size);
+    writeValue(stream, stamp.contentHash);
+  }
+
+  static bool readStamp(std::istream& stream, FileStamp& stamp)
+  {
+    return readValue(stream, stamp.modificationTime) &&
+           readValue(stream, stamp.size) &&
+           readValue(stream, stamp.contentHash);
+  }
+};
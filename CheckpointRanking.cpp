@@ -0,0 +1,112 @@
+#include "CheckpointRanking.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+auto CheckpointRanking::rank(ValidationSet const& set,
+                             std::vector<std::string> const& weightsFilePaths,
+                             ValidationOptions const& options,
+                             size_t checkpointsInParallel,
+                             std::atomic<bool> const& isCanceled,
+                             ProgressCallback const& onProgress) -> std::vector<CheckpointScore>
+{
+  std::vector<CheckpointScore> scores(weightsFilePaths.size());
+  auto const threadsCount = (options.threadsCount != 0)
+                            ? options.threadsCount
+                            : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  auto const workersCount = std::max<size_t>(std::min(checkpointsInParallel, weightsFilePaths.size()), 1);
+  auto checkpointOptions = options;
+  checkpointOptions.threadsCount = std::max<size_t>(threadsCount / workersCount, 1);
+  /// The cache belongs to one network, a ranking of many writes none
+  checkpointOptions.probabilityCachePath.clear();
+
+  std::atomic<size_t> next{0};
+  std::mutex progressMutex;
+  size_t evaluated = 0;
+  auto work = [&]() {
+    for (auto index = next++; (index < weightsFilePaths.size()) && !isCanceled; index = next++)
+    {
+      auto& score = scores[index];
+      score.weightsFilePath = weightsFilePaths[index];
+      auto networkOptions = checkpointOptions;
+      networkOptions.network.weightsFilePath = score.weightsFilePath;
+      std::unique_ptr<RoiDetector> detector;
+      try
+      {
+        detector = std::make_unique<RoiDetector>(networkOptions.network);
+      }
+      catch (std::exception const&)
+      {
+        detector.reset();
+      }
+      score.isLoaded = static_cast<bool>(detector);
+      try
+      {
+        if (score.isLoaded)
+        {
+          score.report = ValidationMetrics::evaluate(set, *detector, networkOptions, isCanceled, [](size_t, size_t) {});
+          score.report.images.clear();
+        }
+      }
+      catch (std::exception const&)
+      {
+        /// An exception must not leave the worker thread, the checkpoint is ranked as not evaluated
+        score.isLoaded = false;
+      }
+      detector.reset();
+
+      std::lock_guard<std::mutex> lock(progressMutex);
+      onProgress(score, ++evaluated, weightsFilePaths.size());
+    }
+  };
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < workersCount; ++i)
+  {
+    workers.emplace_back(work);
+  }
+  work();
+  for (auto& worker : workers)
+  {
+    worker.join();
+  }
+
+  /// Checkpoints skipped on cancel have no path, they are not ranked
+  scores.erase(std::remove_if(scores.begin(), scores.end(), [](auto const& score) { return score.weightsFilePath.empty(); }), scores.end());
+  std::stable_sort(scores.begin(), scores.end(), [](auto const& a, auto const& b) {
+    if (a.isLoaded != b.isLoaded)
+    {
+      return a.isLoaded;
+    }
+    return a.report.meanIou() > b.report.meanIou();
+  });
+  return scores;
+}
+
+void CheckpointRanking::saveLeaderboard(bp::ptree& tree, std::vector<CheckpointScore> const& scores)
+{
+  bp::ptree items;
+  for (auto const& score : scores)
+  {
+    bp::ptree item;
+    item.put("weightsFilePath", score.weightsFilePath);
+    item.put("isLoaded", score.isLoaded);
+    if (score.isLoaded)
+    {
+      item.put("meanIou", score.report.meanIou());
+      item.put("failedSamplesCount", score.report.failedSamples.size());
+      bp::ptree classes;
+      for (size_t i = 0; i < score.report.classes.size(); ++i)
+      {
+        bp::ptree classItem;
+        classItem.put("className", score.report.classNames[i]);
+        classItem.put("iou", score.report.classes[i].iou());
+        classes.push_back(bp::ptree::value_type("", classItem));
+      }
+      item.put_child("classes", classes);
+    }
+    items.push_back(bp::ptree::value_type("", item));
+  }
+  tree.put_child("leaderboard", items);
+}
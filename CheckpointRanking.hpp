@@ -0,0 +1,43 @@
+#pragma once
+
+#include "ValidationMetrics.hpp"
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bp = boost::property_tree;
+
+struct CheckpointScore
+{
+  std::string weightsFilePath;
+  /// False when the weights could not be loaded or evaluated
+  bool isLoaded{};
+  /// Totals only, the per image metrics are dropped
+  ValidationReport report;
+};
+
+/**
+ * Ranks the checkpoints of a training by the mean IoU on the validation set. The set is decoded once and shared,
+ * several checkpoints are evaluated at once, each by its own detector with its share of the threads, so the
+ * forward passes of different weights run side by side. Detectors are built outside of RoiModelRegistry and
+ * released after their checkpoint, at most checkpointsInParallel networks are loaded at a time.
+ */
+struct CheckpointRanking
+{
+  /// Called after every evaluated checkpoint, calls are serialized.
+  using ProgressCallback = std::function<void(CheckpointScore const& score, size_t evaluated, size_t total)>;
+
+  /// Best first; checkpoints which could not be loaded go last. options.network gives everything but the weights.
+  static auto rank(ValidationSet const& set,
+                   std::vector<std::string> const& weightsFilePaths,
+                   ValidationOptions const& options,
+                   size_t checkpointsInParallel,
+                   std::atomic<bool> const& isCanceled,
+                   ProgressCallback const& onProgress) -> std::vector<CheckpointScore>;
+  /// The "leaderboard" section of the project: weightsFilePath, meanIou and the per class IoU of every checkpoint in order.
+  static void saveLeaderboard(bp::ptree& tree, std::vector<CheckpointScore> const& scores);
+};
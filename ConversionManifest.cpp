@@ -0,0 +1,129 @@
+#include "ConversionManifest.hpp"
+#include "BinaryStream.hpp"
+
+#ifdef _MSC_VER
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <system_error>
+
+namespace {
+constexpr char manifestMagic[] = {'U', 'T', 'T', 'C', 'M', 'F'};
+constexpr uint32_t manifestVersion = 1;
+} /// end namespace anonymous
+
+ConversionManifest::ConversionManifest(std::string outputDirectoryPath, std::string parametersKey, bool isContentHashed)
+  : _manifestFilePath{outputDirectoryPath + "/" + fileName}
+  , _parametersKey{std::move(parametersKey)}
+  , _isContentHashed{isContentHashed}
+{
+}
+
+bool ConversionManifest::load()
+{
+  _entries.clear();
+  std::ifstream file(_manifestFilePath, std::ios::binary);
+  if (!file)
+  {
+    return false;
+  }
+  char magic[sizeof(manifestMagic)]{};
+  uint32_t version{};
+  std::string parametersKey;
+  uint64_t entriesCount{};
+  if (!file.read(magic, sizeof(magic)) ||
+      !std::equal(std::begin(magic), std::end(magic), std::begin(manifestMagic)) ||
+      !BinaryStream::readValue(file, version) ||
+      (version != manifestVersion) ||
+      !BinaryStream::readString(file, parametersKey) ||
+      (parametersKey != _parametersKey) ||
+      !BinaryStream::readValue(file, entriesCount))
+  {
+    return false;
+  }
+  for (uint64_t i = 0; i < entriesCount; ++i)
+  {
+    std::string outputName;
+    Entry entry;
+    if (!BinaryStream::readString(file, outputName) ||
+        !BinaryStream::readString(file, entry.imagePath) ||
+        !BinaryStream::readString(file, entry.annotationPath) ||
+        !BinaryStream::readStamp(file, entry.imageStamp) ||
+        !BinaryStream::readStamp(file, entry.annotationStamp))
+    {
+      _entries.clear();
+      return false;
+    }
+    _entries.emplace(std::move(outputName), std::move(entry));
+  }
+  return true;
+}
+
+bool ConversionManifest::save(bool isPruned) const
+{
+  auto const temporaryFilePath = _manifestFilePath + ".tmp";
+  {
+    std::ofstream file(temporaryFilePath, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+      return false;
+    }
+    auto const entriesCount = static_cast<uint64_t>(std::count_if(_entries.cbegin(), _entries.cend(), [isPruned](auto const& entry) {
+      return entry.second.isUsed || !isPruned;
+    }));
+    file.write(manifestMagic, sizeof(manifestMagic));
+    BinaryStream::writeValue(file, manifestVersion);
+    BinaryStream::writeString(file, _parametersKey);
+    BinaryStream::writeValue(file, entriesCount);
+    for (auto const& entry : _entries)
+    {
+      if (!entry.second.isUsed && isPruned)
+      {
+        continue;
+      }
+      BinaryStream::writeString(file, entry.first);
+      BinaryStream::writeString(file, entry.second.imagePath);
+      BinaryStream::writeString(file, entry.second.annotationPath);
+      BinaryStream::writeStamp(file, entry.second.imageStamp);
+      BinaryStream::writeStamp(file, entry.second.annotationStamp);
+    }
+    if (!file.flush())
+    {
+      return false;
+    }
+  }
+  std::error_code errorCode;
+  fs::rename(temporaryFilePath, _manifestFilePath, errorCode);
+  return !errorCode;
+}
+
+bool ConversionManifest::isFresh(std::string const& outputName, std::string const& imagePath, std::string const& annotationPath)
+{
+  auto entryIt = _entries.find(outputName);
+  if ((entryIt == _entries.end()) ||
+      (entryIt->second.imagePath != imagePath) ||
+      (entryIt->second.annotationPath != annotationPath) ||
+      !entryIt->second.imageStamp.isFreshFor(imagePath, _isContentHashed) ||
+      !entryIt->second.annotationStamp.isFreshFor(annotationPath, _isContentHashed))
+  {
+    return false;
+  }
+  entryIt->second.isUsed = true;
+  return true;
+}
+
+void ConversionManifest::store(std::string const& outputName, std::string const& imagePath, std::string const& annotationPath)
+{
+  auto& entry = _entries[outputName];
+  entry.imagePath = imagePath;
+  entry.annotationPath = annotationPath;
+  entry.imageStamp = FileStamp::of(imagePath, _isContentHashed);
+  entry.annotationStamp = FileStamp::of(annotationPath, _isContentHashed);
+  entry.isUsed = true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "FileStamp.hpp"
+
+#include <map>
+#include <string>
+
+/**
+ * Record of a converted dataset kept in its output directory: for every output (e.g. "T/image.png")
+ * the source image and annotation stamps it has been made from, plus the preprocessing parameters
+ * of the whole conversion. An output stays up to date while its sources and the parameters are the same.
+ */
+class ConversionManifest
+{
+public:
+  static constexpr char const* fileName = "conversion.manifest";
+
+  ConversionManifest(std::string outputDirectoryPath, std::string parametersKey, bool isContentHashed = false);
+
+  /// Returns false when there is no manifest or it has been written with other parameters, the manifest is empty then.
+  bool load();
+  /// When pruned, only outputs checked as fresh or stored since load are saved.
+  bool save(bool isPruned = true) const;
+
+  /// True when the output has been made from the same sources, the output files themselves are not checked.
+  bool isFresh(std::string const& outputName, std::string const& imagePath, std::string const& annotationPath);
+  void store(std::string const& outputName, std::string const& imagePath, std::string const& annotationPath);
+
+private:
+  struct Entry
+  {
+    std::string imagePath;
+    std::string annotationPath;
+    FileStamp imageStamp;
+    FileStamp annotationStamp;
+    bool isUsed{};
+  };
+
+  std::string _manifestFilePath;
+  std::string _parametersKey;
+  bool _isContentHashed{};
+  std::map<std::string, Entry> _entries;
+};
@@ -0,0 +1,364 @@
+#include "DatasetConverter.hpp"
+#include "ConversionManifest.hpp"
+#include "ProcessingPipeline.hpp"
+#include "LabelMeReader.hpp"
+#include "MaskRasterizer.hpp"
+#include "SampleCache.hpp"
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#ifdef _MSC_VER
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <thread>
+
+namespace {
+struct ConversionItem
+{
+  ConversionSample sample;
+  /// Decoded once and shared by the ROI inference and the export
+  cv::Mat image;
+  cv::Mat mask;
+  cv::Rect unionBox;
+  /// Size of the downscaled image before cropping and the crop in it, the mask is rasterized right into the crop
+  cv::Size targetSize;
+  cv::Rect cropRect;
+  std::string cacheKey;
+  /// Image and mask are taken from the cache, preprocessing is skipped
+  bool isCached{};
+  bool isFailed{};
+};
+
+/// The biggest power of two (up to 8) dividing both downscales, such reduction is done by the decoder
+/// itself (libjpeg DCT scaling for JPEG), so the full resolution image is never materialized.
+auto decoderReduction(ConversionOptions const& options) -> uint32_t
+{
+  uint32_t reduction = 8;
+  while ((reduction > 1) && (((options.widthDownscale % reduction) != 0) || ((options.heightDownscale % reduction) != 0)))
+  {
+    reduction /= 2;
+  }
+  return reduction;
+}
+
+auto decoderFlags(uint32_t reduction) -> int
+{
+  switch (reduction)
+  {
+    case 2:
+      return cv::IMREAD_REDUCED_COLOR_2;
+    case 4:
+      return cv::IMREAD_REDUCED_COLOR_4;
+    case 8:
+      return cv::IMREAD_REDUCED_COLOR_8;
+    default:
+      return cv::IMREAD_COLOR;
+  }
+}
+
+/// Path of the sample image and mask under the images/masks directories prefix, e.g. "T/image.png"
+auto outputName(ConversionSample const& sample) -> std::string
+{
+  return std::string(sample.isTraining ? "T/" : "V/") + fs::path(sample.imagePath).filename().replace_extension("png").string();
+}
+
+/// Removes the PNGs which are not outputs of the current samples: samples removed from the project,
+/// moved to the other split or failed this time.
+auto removeOrphans(std::string const& outputDirectoryPath, std::set<std::string> const& outputNames) -> size_t
+{
+  size_t removedCount = 0;
+  for (auto const& split : {"T", "V"})
+  {
+    for (auto const& directory : {"/images", "/masks"})
+    {
+      std::error_code errorCode;
+      for (fs::directory_iterator it(outputDirectoryPath + directory + split, errorCode), end; !errorCode && (it != end); it.increment(errorCode))
+      {
+        auto const name = std::string(split) + "/" + it->path().filename().string();
+        std::error_code removeErrorCode;
+        if ((it->path().extension().string() == ".png") && (outputNames.count(name) == 0) && fs::remove(it->path(), removeErrorCode))
+        {
+          ++removedCount;
+        }
+      }
+    }
+  }
+  return removedCount;
+}
+
+/// Everything which changes the preprocessed sample besides the source files
+auto preprocessingKey(ConversionOptions const& options) -> std::string
+{
+  std::ostringstream key;
+  key << options.widthDownscale << ' ' << options.heightDownscale << ' '
+      << options.initialFeatureCount << ' ' << options.isClahe << ' '
+      << static_cast<int>(options.maskFormat) << '\n'
+      << options.roiModelKey;
+  for (auto const& classColor : options.colorToClass)
+  {
+    key << '\n' << classColor.first << ' ' << classColor.second[0] << ' ' << classColor.second[1] << ' ' << classColor.second[2];
+  }
+  return key.str();
+}
+
+/// Exceptions must not leave the pipeline threads, the sample is just marked as failed.
+auto guarded(std::function<void(ConversionItem&)> stage) -> std::function<void(ConversionItem&)>
+{
+  return [stage = std::move(stage)](ConversionItem& item) {
+    if (item.isFailed)
+    {
+      return;
+    }
+    try
+    {
+      stage(item);
+    }
+    catch (std::exception const&)
+    {
+      item.isFailed = true;
+    }
+  };
+}
+
+void resizeAndCrop(ConversionItem& item, ConversionOptions const& options, uint32_t reduction)
+{
+  if (item.isCached)
+  {
+    return;
+  }
+  /// The image is already reduced by the decoder, only the rest of the downscale is left
+  auto const widthDownscale = options.widthDownscale / reduction;
+  auto const heightDownscale = options.heightDownscale / reduction;
+  auto const initialFeatureCount = options.initialFeatureCount;
+  auto& image = item.image;
+  auto unionBox = item.unionBox;
+
+  auto const targetSize = cv::Size(image.cols / widthDownscale, image.rows / heightDownscale);
+  if (image.size() != targetSize)
+  {
+    cv::resize(image, image, targetSize, 0, 0, cv::INTER_NEAREST);
+  }
+  unionBox.x /= widthDownscale;
+  unionBox.y /= heightDownscale;
+  unionBox.width /= widthDownscale;
+  unionBox.height /= heightDownscale;
+  auto truncatedCols = targetSize.width & (~(initialFeatureCount - 1));
+  auto truncatedRows = targetSize.height & (~(initialFeatureCount - 1));
+  auto const fractWidth = initialFeatureCount - (unionBox.width % initialFeatureCount);
+  auto const fractHeight = initialFeatureCount - (unionBox.height % initialFeatureCount);
+  unionBox.width -= initialFeatureCount - fractWidth;
+  unionBox.height += fractHeight;
+  auto const sizeSubY = 0;
+  auto const sizeSubX = 0;
+  auto const offsetX = 0;
+  auto const offsetY = 0;
+  auto roi = unionBox.empty()
+          ? cv::Rect(((targetSize.width - truncatedCols) / 2) + offsetX,
+                     ((targetSize.height - truncatedRows) / 2) + offsetY,
+                     truncatedCols - sizeSubX,
+                     truncatedRows - sizeSubY)
+          : unionBox;
+
+  if (options.isClahe)
+  {
+    auto clahe = cv::createCLAHE();
+    cv::cvtColor(image, image, cv::COLOR_BGR2GRAY);
+    clahe->apply(image, image);
+  }
+  image = roi.empty() ? image : image(roi);
+  item.targetSize = targetSize;
+  item.cropRect = roi.empty() ? cv::Rect(cv::Point(), targetSize) : roi;
+}
+
+void rasterizeMask(ConversionItem& item, ConversionOptions const& options)
+{
+  if (item.isCached)
+  {
+    return;
+  }
+  LabelMeAnnotation annotation;
+  if (!LabelMeReader::read(item.sample.annotationPath, annotation, LabelMeReader::ImageSize | LabelMeReader::Shapes))
+  {
+    item.isFailed = true;
+    return;
+  }
+  /// Annotations without the image size are taken as drawn on the full resolution image
+  auto const sourceSize = ((annotation.imageWidth > 0) && (annotation.imageHeight > 0))
+                          ? cv::Size(annotation.imageWidth, annotation.imageHeight)
+                          : cv::Size(item.targetSize.width * options.widthDownscale, item.targetSize.height * options.heightDownscale);
+  MaskRasterizer::Transform transform;
+  transform.scaleX = static_cast<double>(item.targetSize.width) / sourceSize.width;
+  transform.scaleY = static_cast<double>(item.targetSize.height) / sourceSize.height;
+  transform.offset = item.cropRect.tl();
+  item.mask.create(item.cropRect.size(), (options.maskFormat == MaskFormat::ClassIndex) ? CV_8UC1 : CV_8UC3);
+  MaskRasterizer::rasterize(annotation, options.colorToClass, transform, item.mask);
+  if (options.isSampleCacheUsed)
+  {
+    SampleCache::instance().store(item.cacheKey, item.image, item.mask);
+  }
+}
+} /// end namespace anonymous
+
+auto DatasetConverter::convert(std::vector<ConversionSample> samples,
+                               ConversionOptions const& options,
+                               RoiCallback const& roiDetector,
+                               std::atomic<bool> const& isCanceled,
+                               ProgressCallback const& onProgress) -> Result
+{
+  for (auto const& directory : {"/masksT", "/imagesT", "/masksV", "/imagesV"})
+  {
+    fs::create_directories(options.outputDirectoryPath + directory);
+  }
+
+  if (options.maskFormat == MaskFormat::ClassIndex)
+  {
+    std::ofstream classesFile(options.outputDirectoryPath + "/classes.txt", std::ios::trunc);
+    for (auto const& classIndex : MaskRasterizer::classIndices(options.colorToClass))
+    {
+      classesFile << static_cast<uint32_t>(classIndex.second) << " " << classIndex.first << "\n";
+    }
+  }
+
+  auto const threadsCount = (options.threadsCount != 0)
+                            ? options.threadsCount
+                            : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+  auto const reduction = decoderReduction(options);
+  ProcessingPipeline<ConversionItem> pipeline(options.queueCapacity);
+  auto const parametersKey = preprocessingKey(options);
+  pipeline.addStage(guarded([&](ConversionItem& item) {
+    if (options.isSampleCacheUsed)
+    {
+      item.cacheKey = SampleCache::keyFor(item.sample.imagePath, item.sample.annotationPath, parametersKey);
+      item.isCached = SampleCache::instance().find(item.cacheKey, item.image, item.mask);
+      if (item.isCached)
+      {
+        return;
+      }
+    }
+    item.image = cv::imread(item.sample.imagePath, decoderFlags(reduction));
+    item.isFailed = item.image.empty();
+  }), threadsCount / 2);
+  pipeline.addBatchStage([&](std::vector<ConversionItem*> const& batch) {
+    if (!roiDetector)
+    {
+      return;
+    }
+    std::vector<ConversionItem*> validItems;
+    std::vector<cv::Mat> frames;
+    for (auto item : batch)
+    {
+      if (!item->isFailed && !item->isCached)
+      {
+        validItems.push_back(item);
+        frames.push_back(item->image);
+      }
+    }
+    try
+    {
+      auto const unionBoxes = frames.empty() ? std::vector<cv::Rect>{} : roiDetector(frames);
+      for (size_t i = 0; i < validItems.size(); ++i)
+      {
+        validItems[i]->unionBox = (i < unionBoxes.size()) ? unionBoxes[i] : cv::Rect{};
+      }
+    }
+    catch (std::exception const&)
+    {
+      for (auto item : validItems)
+      {
+        item->isFailed = true;
+      }
+    }
+  }, options.roiBatchSize);
+  pipeline.addStage(guarded([&](ConversionItem& item) {
+    resizeAndCrop(item, options, reduction);
+  }), threadsCount / 4);
+  pipeline.addStage(guarded([&](ConversionItem& item) {
+    rasterizeMask(item, options);
+  }), threadsCount / 4);
+  pipeline.addStage(guarded([&](ConversionItem& item) {
+    auto const suffix = outputName(item.sample);
+    item.isFailed = !cv::imwrite(options.outputDirectoryPath + "/masks" + suffix, item.mask) ||
+                    !cv::imwrite(options.outputDirectoryPath + "/images" + suffix, item.image);
+  }), threadsCount / 2);
+
+  ConversionManifest manifest(options.outputDirectoryPath, parametersKey, options.isContentHashed);
+  if (options.isIncremental)
+  {
+    manifest.load();
+  }
+
+  Result result;
+  std::set<std::string> outputNames;
+  std::vector<ConversionItem> items;
+  items.reserve(samples.size());
+  for (auto& sample : samples)
+  {
+    auto name = outputName(sample);
+    if (options.isIncremental &&
+        manifest.isFresh(name, sample.imagePath, sample.annotationPath) &&
+        fs::exists(options.outputDirectoryPath + "/images" + name) &&
+        fs::exists(options.outputDirectoryPath + "/masks" + name))
+    {
+      ++result.upToDateCount;
+      outputNames.emplace(std::move(name));
+      continue;
+    }
+    items.emplace_back();
+    items.back().sample = std::move(sample);
+  }
+
+  size_t processed = result.upToDateCount;
+  auto const total = samples.size();
+  if (processed != 0)
+  {
+    onProgress(processed, total);
+  }
+  pipeline.run(std::move(items), isCanceled, [&](ConversionItem&& item) {
+    if (item.isFailed)
+    {
+      result.failedAnnotations.emplace_back(item.sample.annotationPath);
+    }
+    else
+    {
+      ++result.convertedCount;
+      auto name = outputName(item.sample);
+      manifest.store(name, item.sample.imagePath, item.sample.annotationPath);
+      outputNames.emplace(std::move(name));
+    }
+    onProgress(++processed, total);
+  });
+  /// A canceled run has not seen every sample, so neither outputs nor manifest entries are dropped
+  if (!isCanceled)
+  {
+    result.removedCount = removeOrphans(options.outputDirectoryPath, outputNames);
+  }
+  manifest.save(!isCanceled);
+  return result;
+}
+
+auto DatasetConverter::unionBoundingBox(std::vector<std::vector<cv::Rect>> const& boundingBoxesAll) -> cv::Rect
+{
+  cv::Rect unionBox;
+  for (auto& boundingBoxesClass : boundingBoxesAll)
+  {
+    auto const biggest = std::max_element(boundingBoxesClass.cbegin(), boundingBoxesClass.cend(), [](cv::Rect const& a, cv::Rect const& b) {
+      return a.area() < b.area();
+    });
+    if (biggest != boundingBoxesClass.cend())
+    {
+      unionBox |= *biggest;
+    }
+  }
+  return unionBox;
+}
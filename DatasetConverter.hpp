@@ -0,0 +1,88 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+struct ConversionSample
+{
+  std::string imagePath;
+  std::string annotationPath;
+  bool isTraining{true};
+};
+
+enum class MaskFormat
+{
+  /// BGR class colors, the trainer maps colors back to classes
+  Color,
+  /// Single channel class indices (MaskRasterizer::classIndices), 0 is the background
+  ClassIndex
+};
+
+struct ConversionOptions
+{
+  std::string outputDirectoryPath;
+  uint32_t widthDownscale{1};
+  uint32_t heightDownscale{1};
+  uint32_t initialFeatureCount{8};
+  bool isClahe{false};
+  std::map<std::string, cv::Scalar> colorToClass;
+  MaskFormat maskFormat{MaskFormat::Color};
+  /// 0 means the count of hardware threads
+  size_t threadsCount{0};
+  size_t queueCapacity{16};
+  /// Count of frames forwarded through the ROI detector at once
+  size_t roiBatchSize{8};
+  /// Identifies the ROI model in the sample cache key, empty without ROI cropping
+  std::string roiModelKey;
+  /// Preprocessed samples are taken from and stored into SampleCache::instance()
+  bool isSampleCacheUsed{false};
+  /// Samples whose outputs are up to date with the manifest of the output directory are not converted again
+  bool isIncremental{true};
+  /// Sources with changed time or size are hashed before they are taken as changed
+  bool isContentHashed{false};
+};
+
+/**
+ * Converts "labelme" annotated images into the training directories layout (imagesT/masksT/imagesV/masksV).
+ * Samples go through decode, ROI inference, resize/crop, rasterize and encode stages, every stage
+ * runs on its own threads and the stages are connected by bounded queues. The mask is rasterized
+ * straight at the downscaled and cropped size, the full resolution mask is never built.
+ * Class index masks come with "classes.txt" (index and class name per line) in the output directory.
+ * Every image is decoded once, at reduced scale when the downscales allow it, and the ROI detector
+ * gets the decoded image, so the ROI is found in the decoded image coordinates.
+ * With the sample cache, cached samples skip every stage up to the encode.
+ * The directories layout is converted incrementally: the output directory keeps a ConversionManifest,
+ * samples with up to date outputs are skipped and PNGs of samples which are gone are removed.
+ */
+struct DatasetConverter
+{
+  /// Gets a batch of frames and returns a ROI per frame. Called on a single thread,
+  /// so the network inside does not need to be thread safe.
+  using RoiCallback = std::function<std::vector<cv::Rect>(std::vector<cv::Mat> const&)>;
+  /// Called on the calling thread in the samples order.
+  using ProgressCallback = std::function<void(size_t processed, size_t total)>;
+
+  struct Result
+  {
+    size_t convertedCount{};
+    /// Skipped, their outputs are up to date
+    size_t upToDateCount{};
+    /// Outputs of samples which are no longer converted into the directory
+    size_t removedCount{};
+    std::vector<std::string> failedAnnotations;
+  };
+
+  static auto convert(std::vector<ConversionSample> samples,
+                      ConversionOptions const& options,
+                      RoiCallback const& roiDetector,
+                      std::atomic<bool> const& isCanceled,
+                      ProgressCallback const& onProgress) -> Result;
+
+  /// Union of the biggest bounding box of every class.
+  static auto unionBoundingBox(std::vector<std::vector<cv::Rect>> const& boundingBoxesAll) -> cv::Rect;
+};
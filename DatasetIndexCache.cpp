@@ -0,0 +1,252 @@
+#include "DatasetIndexCache.hpp"
+#include "BinaryStream.hpp"
+
+#ifdef _MSC_VER
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <system_error>
+
+namespace {
+constexpr char indexMagic[] = {'U', 'T', 'T', 'I', 'D', 'X'};
+constexpr uint32_t indexVersion = 1;
+
+void writeColor(std::ostream& stream, cv::Vec3b const& color)
+{
+  stream.write(reinterpret_cast<char const*>(&color[0]), 3);
+}
+
+bool readColor(std::istream& stream, cv::Vec3b& color)
+{
+  return static_cast<bool>(stream.read(reinterpret_cast<char*>(&color[0]), 3));
+}
+
+void writeSample(std::ostream& stream, DatasetSample const& sample)
+{
+  BinaryStream::writeString(stream, sample.annotationPath);
+  BinaryStream::writeValue(stream, sample.imageFileSize);
+  BinaryStream::writeValue(stream, static_cast<int32_t>(sample.imageSize.width));
+  BinaryStream::writeValue(stream, static_cast<int32_t>(sample.imageSize.height));
+  BinaryStream::writeValue(stream, static_cast<uint8_t>(sample.isValid));
+
+  BinaryStream::writeValue(stream, static_cast<uint32_t>(sample.labelsByName.size()));
+  for (auto const& label : sample.labelsByName)
+  {
+    BinaryStream::writeString(stream, label.first);
+    BinaryStream::writeValue(stream, label.second);
+  }
+
+  BinaryStream::writeValue(stream, static_cast<uint32_t>(sample.maskStatistics.boundingBoxes.size()));
+  for (auto const& rects : sample.maskStatistics.boundingBoxes)
+  {
+    writeColor(stream, rects.first);
+    BinaryStream::writeValue(stream, static_cast<uint32_t>(rects.second.size()));
+    for (auto const& rect : rects.second)
+    {
+      BinaryStream::writeValue(stream, static_cast<int32_t>(rect.x));
+      BinaryStream::writeValue(stream, static_cast<int32_t>(rect.y));
+      BinaryStream::writeValue(stream, static_cast<int32_t>(rect.width));
+      BinaryStream::writeValue(stream, static_cast<int32_t>(rect.height));
+    }
+  }
+  BinaryStream::writeValue(stream, static_cast<uint32_t>(sample.maskStatistics.pixelsCount.size()));
+  for (auto const& count : sample.maskStatistics.pixelsCount)
+  {
+    writeColor(stream, count.first);
+    BinaryStream::writeValue(stream, count.second);
+  }
+}
+
+bool readSample(std::istream& stream, DatasetSample& sample)
+{
+  int32_t width{};
+  int32_t height{};
+  uint8_t isValid{};
+  uint32_t count{};
+  if (!BinaryStream::readString(stream, sample.annotationPath) ||
+      !BinaryStream::readValue(stream, sample.imageFileSize) ||
+      !BinaryStream::readValue(stream, width) ||
+      !BinaryStream::readValue(stream, height) ||
+      !BinaryStream::readValue(stream, isValid) ||
+      !BinaryStream::readValue(stream, count))
+  {
+    return false;
+  }
+  sample.imageSize = cv::Size(width, height);
+  sample.isValid = (isValid != 0);
+
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    std::string name;
+    uint32_t labelsCount{};
+    if (!BinaryStream::readString(stream, name) || !BinaryStream::readValue(stream, labelsCount))
+    {
+      return false;
+    }
+    sample.labelsByName[name] = labelsCount;
+  }
+
+  if (!BinaryStream::readValue(stream, count))
+  {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    cv::Vec3b color;
+    uint32_t rectsCount{};
+    if (!readColor(stream, color) || !BinaryStream::readValue(stream, rectsCount))
+    {
+      return false;
+    }
+    auto& rects = sample.maskStatistics.boundingBoxes[color];
+    rects.resize(rectsCount);
+    for (auto& rect : rects)
+    {
+      int32_t values[4]{};
+      if (!BinaryStream::readValue(stream, values))
+      {
+        return false;
+      }
+      rect = cv::Rect(values[0], values[1], values[2], values[3]);
+    }
+  }
+
+  if (!BinaryStream::readValue(stream, count))
+  {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    cv::Vec3b color;
+    uint64_t pixelsCount{};
+    if (!readColor(stream, color) || !BinaryStream::readValue(stream, pixelsCount))
+    {
+      return false;
+    }
+    sample.maskStatistics.pixelsCount[color] = pixelsCount;
+  }
+  return true;
+}
+
+} /// end namespace anonymous
+
+DatasetIndexCache::DatasetIndexCache(std::string indexFilePath, bool isContentHashed)
+  : _indexFilePath{std::move(indexFilePath)}
+  , _isContentHashed{isContentHashed}
+{
+}
+
+auto DatasetIndexCache::indexFilePathForProject(std::string const& projectFile) -> std::string
+{
+  return fs::path(projectFile).replace_extension("index").string();
+}
+
+bool DatasetIndexCache::load()
+{
+  _entries.clear();
+  std::ifstream file(_indexFilePath, std::ios::binary);
+  if (!file)
+  {
+    return false;
+  }
+  char magic[sizeof(indexMagic)]{};
+  uint32_t version{};
+  uint64_t entriesCount{};
+  if (!file.read(magic, sizeof(magic)) ||
+      !std::equal(std::begin(magic), std::end(magic), std::begin(indexMagic)) ||
+      !BinaryStream::readValue(file, version) ||
+      (version != indexVersion) ||
+      !BinaryStream::readValue(file, entriesCount))
+  {
+    return false;
+  }
+  for (uint64_t i = 0; i < entriesCount; ++i)
+  {
+    std::string imagePath;
+    Entry entry;
+    if (!BinaryStream::readString(file, imagePath) ||
+        !BinaryStream::readStamp(file, entry.imageStamp) ||
+        !BinaryStream::readStamp(file, entry.annotationStamp) ||
+        !readSample(file, entry.sample))
+    {
+      _entries.clear();
+      return false;
+    }
+    entry.sample.imagePath = imagePath;
+    entry.sample.isIndexed = true;
+    _entries.emplace(std::move(imagePath), std::move(entry));
+  }
+  return true;
+}
+
+bool DatasetIndexCache::save(bool isPruned) const
+{
+  auto const temporaryFilePath = _indexFilePath + ".tmp";
+  {
+    std::ofstream file(temporaryFilePath, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+      return false;
+    }
+    uint64_t entriesCount{};
+    for (auto const& entry : _entries)
+    {
+      entriesCount += (entry.second.isUsed || !isPruned) ? 1 : 0;
+    }
+    file.write(indexMagic, sizeof(indexMagic));
+    BinaryStream::writeValue(file, indexVersion);
+    BinaryStream::writeValue(file, entriesCount);
+    for (auto const& entry : _entries)
+    {
+      if (!entry.second.isUsed && isPruned)
+      {
+        continue;
+      }
+      BinaryStream::writeString(file, entry.first);
+      BinaryStream::writeStamp(file, entry.second.imageStamp);
+      BinaryStream::writeStamp(file, entry.second.annotationStamp);
+      writeSample(file, entry.second.sample);
+    }
+    if (!file.flush())
+    {
+      return false;
+    }
+  }
+  std::error_code errorCode;
+  fs::rename(temporaryFilePath, _indexFilePath, errorCode);
+  return !errorCode;
+}
+
+bool DatasetIndexCache::lookup(DatasetSample& sample)
+{
+  auto entryIt = _entries.find(sample.imagePath);
+  if ((entryIt == _entries.end()) ||
+      (entryIt->second.sample.annotationPath != sample.annotationPath) ||
+      !entryIt->second.imageStamp.isFreshFor(sample.imagePath, _isContentHashed) ||
+      !entryIt->second.annotationStamp.isFreshFor(sample.annotationPath, _isContentHashed))
+  {
+    return false;
+  }
+  entryIt->second.isUsed = true;
+  sample = entryIt->second.sample;
+  return true;
+}
+
+void DatasetIndexCache::store(DatasetSample const& sample)
+{
+  auto& entry = _entries[sample.imagePath];
+  if (entry.isUsed)
+  {
+    return;
+  }
+  entry.imageStamp = FileStamp::of(sample.imagePath, _isContentHashed);
+  entry.annotationStamp = FileStamp::of(sample.annotationPath, _isContentHashed);
+  entry.sample = sample;
+  entry.isUsed = true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "DatasetIndexer.hpp"
+#include "FileStamp.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+/**
+ * Persistent index of already processed samples, stored next to the project file.
+ * An entry stays valid while modification time and size of both image and annotation
+ * are the same. When content hashing is enabled, an entry with changed time or size
+ * is still reused if the content hashes are the same.
+ */
+class DatasetIndexCache
+{
+public:
+  explicit DatasetIndexCache(std::string indexFilePath, bool isContentHashed = false);
+
+  static auto indexFilePathForProject(std::string const& projectFile) -> std::string;
+
+  bool load();
+  /// When pruned, only entries which have been looked up or stored since load are saved, so removed samples are dropped.
+  bool save(bool isPruned = true) const;
+
+  /// Restores an indexed sample, returns false when there is no valid entry for it.
+  bool lookup(DatasetSample& sample);
+  void store(DatasetSample const& sample);
+
+private:
+  struct Entry
+  {
+    FileStamp imageStamp;
+    FileStamp annotationStamp;
+    DatasetSample sample;
+    bool isUsed{};
+  };
+
+  std::string _indexFilePath;
+  bool _isContentHashed{};
+  std::map<std::string, Entry> _entries;
+};
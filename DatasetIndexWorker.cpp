@@ -0,0 +1,36 @@
+#include "DatasetIndexWorker.hpp"
+#include "ProjectWorkflow.hpp"
+
+DatasetIndexWorker::DatasetIndexWorker(std::vector<std::pair<std::string, std::string>> datasets,
+                                       std::string indexFilePath,
+                                       bool isContentHashed,
+                                       quint64 generation,
+                                       QObject* parent)
+  : QObject(parent)
+  , _datasets{std::move(datasets)}
+  , _indexFilePath{std::move(indexFilePath)}
+  , _isContentHashed{isContentHashed}
+  , _generation{generation}
+{
+  qRegisterMetaType<std::vector<DatasetSample>>("std::vector<DatasetSample>");
+}
+
+void DatasetIndexWorker::cancel()
+{
+  _isCanceled = true;
+}
+
+void DatasetIndexWorker::run()
+{
+  ProjectWorkflow::indexDatasets(_datasets,
+                                 _indexFilePath,
+                                 _isContentHashed,
+                                 _isCanceled,
+                                 [this](size_t count) {
+                                   emit samplesCounted(static_cast<int>(count));
+                                 },
+                                 [this](std::vector<DatasetSample>&& batch) {
+                                   emit batchReady(std::move(batch), _generation);
+                                 });
+  emit finished(_isCanceled, _generation);
+}
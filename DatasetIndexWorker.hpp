@@ -0,0 +1,50 @@
+#pragma once
+
+#include "DatasetIndexer.hpp"
+
+#include <QObject>
+#include <QMetaType>
+
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+
+Q_DECLARE_METATYPE(std::vector<DatasetSample>)
+
+/**
+ * Indexes project datasets on a worker thread and streams the indexed samples back in batches
+ * through queued signals. Should be moved to a QThread, the run slot is started from QThread::started.
+ * Samples which are not changed since the previous run are restored from the persistent index.
+ * Signals carry the generation given on construction (DatasetTableModel::generation), so the receiver
+ * could drop the ones still queued from a stopped worker.
+ */
+class DatasetIndexWorker : public QObject
+{
+Q_OBJECT
+
+public:
+  DatasetIndexWorker(std::vector<std::pair<std::string, std::string>> datasets,
+                     std::string indexFilePath,
+                     bool isContentHashed,
+                     quint64 generation,
+                     QObject* parent = nullptr);
+
+  /// Thread safe, could be called from any thread.
+  void cancel();
+
+public slots:
+  void run();
+
+signals:
+  void samplesCounted(int count);
+  void batchReady(std::vector<DatasetSample> samples, quint64 generation);
+  void finished(bool isCanceled, quint64 generation);
+
+private:
+  std::vector<std::pair<std::string, std::string>> _datasets;
+  std::string _indexFilePath;
+  bool _isContentHashed{};
+  quint64 _generation{};
+  std::atomic<bool> _isCanceled{false};
+};
@@ -0,0 +1,115 @@
+#include "DatasetIndexer.hpp"
+#include "LabelMeReader.hpp"
+
+#include <opencv2/imgcodecs.hpp>
+
+#ifdef _MSC_VER
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <algorithm>
+
+auto DatasetSample::isLabelMe() const -> bool
+{
+  return fs::path(annotationPath).extension().string() == ".json";
+}
+
+auto DatasetIndexer::listSamples(std::string const& imagesDirectoryPath,
+                                 std::string const& labelsDirectoryPath) -> std::vector<DatasetSample>
+{
+  auto imagesDirectoryPathCopy = imagesDirectoryPath;
+  std::replace(imagesDirectoryPathCopy.begin(), imagesDirectoryPathCopy.end(), '\\', '/');
+  auto lastSlash = imagesDirectoryPathCopy.find_last_of("/");
+  auto imagesDirectoryPathFixed = fs::path(imagesDirectoryPath).is_absolute() ? imagesDirectoryPath : labelsDirectoryPath + "/" + imagesDirectoryPathCopy.substr(0, lastSlash);
+
+  std::vector<DatasetSample> samples;
+  for (auto const& file : fs::directory_iterator{imagesDirectoryPathFixed})
+  {
+    if (fs::is_directory(file))
+    {
+      continue;
+    }
+    auto filename = file.path().filename().string();
+    auto fileext = file.path().extension().string();
+    filename = filename.substr(0, filename.find_last_of('.'));
+
+    DatasetSample sample;
+    sample.imagePath = file.path().string();
+    if (fs::exists(labelsDirectoryPath + "/" + filename + fileext))
+    {
+      sample.annotationPath = labelsDirectoryPath + "/" + filename + fileext;
+    }
+    else if (fs::exists(labelsDirectoryPath + "/" + filename + ".json"))
+    {
+      sample.annotationPath = labelsDirectoryPath + "/" + filename + ".json";
+    }
+    else
+    {
+      continue;
+    }
+    samples.emplace_back(std::move(sample));
+  }
+  return samples;
+}
+
+void DatasetIndexer::indexSample(DatasetSample& sample)
+{
+  /// Runs on the indexing threads, an image removed meanwhile makes the sample invalid instead of throwing
+  std::error_code errorCode;
+  sample.imageFileSize = fs::file_size(sample.imagePath, errorCode);
+  if (errorCode)
+  {
+    sample.imageFileSize = 0;
+    sample.isValid = false;
+    sample.isIndexed = true;
+    return;
+  }
+  if (sample.isLabelMe())
+  {
+    LabelMeAnnotation annotation;
+    sample.isValid = LabelMeReader::read(sample.annotationPath, annotation, LabelMeReader::ImageSize | LabelMeReader::Shapes);
+    if (sample.isValid)
+    {
+      sample.labelsByName = annotation.labelsCount();
+      sample.imageSize = cv::Size(annotation.imageWidth, annotation.imageHeight);
+    }
+  }
+  else
+  {
+    cv::Mat labelsImage = cv::imread(sample.annotationPath, cv::IMREAD_COLOR);
+    sample.imageSize = labelsImage.size();
+    sample.maskStatistics = LabelStatistics::calculate(labelsImage);
+  }
+  sample.isIndexed = true;
+}
+
+void DatasetIndexer::indexSamples(std::vector<DatasetSample>&& samples,
+                                  size_t batchSize,
+                                  std::atomic<bool> const& isCanceled,
+                                  BatchCallback const& onBatch)
+{
+  batchSize = std::max<size_t>(batchSize, 1);
+  for (size_t first = 0; (first < samples.size()) && !isCanceled; first += batchSize)
+  {
+    auto const last = std::min(first + batchSize, samples.size());
+    cv::parallel_for_(cv::Range(static_cast<int>(first), static_cast<int>(last)), [&](cv::Range const& range) {
+      for (auto i = range.start; (i < range.end) && !isCanceled; ++i)
+      {
+        if (!samples[i].isIndexed)
+        {
+          indexSample(samples[i]);
+        }
+      }
+    });
+    if (isCanceled)
+    {
+      break;
+    }
+    onBatch(std::vector<DatasetSample>(std::make_move_iterator(samples.begin() + first),
+                                       std::make_move_iterator(samples.begin() + last)));
+  }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "LabelStatistics.hpp"
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+struct DatasetSample
+{
+  std::string imagePath;
+  std::string annotationPath;
+  uint64_t imageFileSize{};
+  cv::Size imageSize;
+  bool isValid{true};
+  bool isIndexed{false};
+  /// Filled for "labelme" annotations
+  std::map<std::string, uint32_t> labelsByName;
+  /// Filled for color mask annotations
+  LabelStatistics maskStatistics;
+
+  auto isLabelMe() const -> bool;
+};
+
+struct DatasetIndexer
+{
+  using BatchCallback = std::function<void(std::vector<DatasetSample>&&)>;
+
+  /// Pairs images with annotations (mask with the same name or "labelme" json), nothing is decoded here.
+  static auto listSamples(std::string const& imagesDirectoryPath, std::string const& labelsDirectoryPath) -> std::vector<DatasetSample>;
+  static void indexSample(DatasetSample& sample);
+  /// Indexes samples in parallel batches, every processed batch is passed to the callback in the input order.
+  /// Samples which are already indexed (e.g. restored from the index cache) are passed as is.
+  static void indexSamples(std::vector<DatasetSample>&& samples,
+                           size_t batchSize,
+                           std::atomic<bool> const& isCanceled,
+                           BatchCallback const& onBatch);
+};
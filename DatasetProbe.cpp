@@ -0,0 +1,102 @@
+#include "DatasetProbe.hpp"
+#include "LabelMeReader.hpp"
+
+#ifdef _MSC_VER
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace {
+/// Resolves "." and ".." without touching the filesystem
+auto normalizePath(std::string const& path) -> std::string
+{
+  std::vector<std::string> parts;
+  size_t begin = 0;
+  while (begin <= path.size())
+  {
+    auto end = path.find('/', begin);
+    end = (end == std::string::npos) ? path.size() : end;
+    auto part = path.substr(begin, end - begin);
+    if ((part == "..") && !parts.empty() && (parts.back() != "..") && !parts.back().empty())
+    {
+      parts.pop_back();
+    }
+    else if ((part != ".") && (!part.empty() || parts.empty()))
+    {
+      parts.emplace_back(std::move(part));
+    }
+    begin = end + 1;
+  }
+  std::string result;
+  for (size_t i = 0; i < parts.size(); ++i)
+  {
+    result += (i == 0) ? parts[i] : ("/" + parts[i]);
+  }
+  return result.empty() ? std::string("/") : result;
+}
+} /// end namespace anonymous
+
+auto DatasetProbe::resolveImagePath(std::string const& annotationPath, std::string imagePath) -> std::string
+{
+  std::replace(imagePath.begin(), imagePath.end(), '\\', '/');
+  if (!fs::path(imagePath).is_absolute())
+  {
+    auto annotationDirectoryPath = fs::absolute(fs::path(annotationPath)).parent_path().string();
+    std::replace(annotationDirectoryPath.begin(), annotationDirectoryPath.end(), '\\', '/');
+    imagePath = annotationDirectoryPath + "/" + imagePath;
+  }
+  return normalizePath(imagePath);
+}
+
+auto DatasetProbe::probe(std::string const& annotationsDirectoryPath, size_t probesCount) -> DatasetSummary
+{
+  DatasetSummary summary;
+  std::vector<std::string> annotationPaths;
+  std::error_code errorCode;
+  for (fs::directory_iterator it(annotationsDirectoryPath, errorCode), end; !errorCode && (it != end); it.increment(errorCode))
+  {
+    if (fs::is_directory(it->status()) || (it->path().extension().string() != ".json"))
+    {
+      continue;
+    }
+    annotationPaths.emplace_back(it->path().string());
+    auto const fileSize = fs::file_size(it->path(), errorCode);
+    summary.annotationsBytes += errorCode ? 0 : fileSize;
+    errorCode.clear();
+  }
+  summary.annotationsCount = annotationPaths.size();
+  if (annotationPaths.empty() || (probesCount == 0))
+  {
+    return summary;
+  }
+
+  /// Probes are spread over the listing, so one odd file does not decide the directory
+  std::map<std::string, size_t> votes;
+  auto const step = std::max<size_t>(annotationPaths.size() / probesCount, 1);
+  for (size_t i = 0; (i < annotationPaths.size()) && (summary.probedCount < probesCount); i += step)
+  {
+    auto const imagePath = LabelMeReader::readImagePath(annotationPaths[i]);
+    ++summary.probedCount;
+    if (imagePath.empty())
+    {
+      continue;
+    }
+    auto const resolvedPath = resolveImagePath(annotationPaths[i], imagePath);
+    ++votes[resolvedPath.substr(0, resolvedPath.find_last_of('/'))];
+  }
+  auto const best = std::max_element(votes.cbegin(), votes.cend(), [](auto const& a, auto const& b) {
+    return a.second < b.second;
+  });
+  if (best != votes.cend())
+  {
+    summary.imagesDirectoryPath = best->first;
+  }
+  return summary;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct DatasetSummary
+{
+  /// Empty when no sampled annotation has imagePath
+  std::string imagesDirectoryPath;
+  size_t annotationsCount{};
+  uint64_t annotationsBytes{};
+  /// Annotations whose imagePath has been read to infer the images directory
+  size_t probedCount{};
+};
+
+/**
+ * Quick look at a "labelme" annotations directory before it is added to the project: only the directory
+ * listing and the heads of a few annotations spread over it are read, so it takes milliseconds regardless
+ * of the dataset size. The images directory is the one most of the probed annotations point to.
+ */
+struct DatasetProbe
+{
+  static auto probe(std::string const& annotationsDirectoryPath, size_t probesCount = 5) -> DatasetSummary;
+  /// imagePath of an annotation resolved against the annotation directory, with '/' separators.
+  static auto resolveImagePath(std::string const& annotationPath, std::string imagePath) -> std::string;
+};
@@ -0,0 +1,109 @@
+#include "DatasetSplitter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+/// Name of the rarest class of the sample by the count of samples having it, empty for samples without labels
+auto stratumOf(std::map<std::string, uint32_t> const& labelsCount, std::map<std::string, size_t> const& samplesCountByClass) -> std::string
+{
+  std::string stratum;
+  size_t stratumSamplesCount = 0;
+  for (auto const& labelCount : labelsCount)
+  {
+    if (labelCount.second == 0)
+    {
+      continue;
+    }
+    auto const samplesCount = samplesCountByClass.at(labelCount.first);
+    if (stratum.empty() || (samplesCount < stratumSamplesCount))
+    {
+      stratum = labelCount.first;
+      stratumSamplesCount = samplesCount;
+    }
+  }
+  return stratum;
+}
+} /// end namespace anonymous
+
+auto DatasetSplitter::rank(std::string const& imagePath, uint32_t seed) -> uint64_t
+{
+  /// FNV-1a of the path mixed with the seed and finalized by splitmix64, so close paths get unrelated ranks
+  uint64_t hash = 14695981039346656037ULL ^ seed;
+  for (auto const symbol : imagePath)
+  {
+    hash ^= static_cast<uint8_t>(symbol);
+    hash *= 1099511628211ULL;
+  }
+  hash += 0x9e3779b97f4a7c15ULL;
+  hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+  return hash ^ (hash >> 31);
+}
+
+void DatasetSplitter::split(std::vector<ConversionSample>& samples,
+                            std::vector<std::map<std::string, uint32_t>> const& labelsCount,
+                            SplitOptions const& options,
+                            SplitAssignment& assignment)
+{
+  SplitAssignment updated;
+  updated.options = options;
+  auto const isKept = (assignment.options == options);
+
+  std::map<std::string, size_t> samplesCountByClass;
+  if (options.isStratified)
+  {
+    for (auto const& sampleLabelsCount : labelsCount)
+    {
+      for (auto const& labelCount : sampleLabelsCount)
+      {
+        samplesCountByClass[labelCount.first] += (labelCount.second != 0) ? 1 : 0;
+      }
+    }
+  }
+
+  struct Stratum
+  {
+    size_t samplesCount{};
+    size_t validationCount{};
+    std::vector<std::pair<uint64_t, size_t>> newSamples;
+  };
+  std::map<std::string, Stratum> strata;
+  for (size_t i = 0; i < samples.size(); ++i)
+  {
+    auto& sample = samples[i];
+    auto& stratum = strata[(options.isStratified && (i < labelsCount.size())) ? stratumOf(labelsCount[i], samplesCountByClass) : std::string{}];
+    ++stratum.samplesCount;
+    if (isKept && (assignment.validation.count(sample.imagePath) != 0))
+    {
+      sample.isTraining = false;
+      ++stratum.validationCount;
+      updated.validation.insert(sample.imagePath);
+    }
+    else if (isKept && (assignment.training.count(sample.imagePath) != 0))
+    {
+      sample.isTraining = true;
+      updated.training.insert(sample.imagePath);
+    }
+    else
+    {
+      stratum.newSamples.emplace_back(rank(sample.imagePath, options.seed), i);
+    }
+  }
+
+  for (auto& stratum : strata)
+  {
+    auto& newSamples = stratum.second.newSamples;
+    std::sort(newSamples.begin(), newSamples.end());
+    auto const quota = static_cast<size_t>(std::llround(options.validationFraction * stratum.second.samplesCount));
+    auto validationLeft = (quota > stratum.second.validationCount) ? (quota - stratum.second.validationCount) : 0;
+    for (auto const& newSample : newSamples)
+    {
+      auto& sample = samples[newSample.second];
+      sample.isTraining = (validationLeft == 0);
+      validationLeft -= sample.isTraining ? 0 : 1;
+      (sample.isTraining ? updated.training : updated.validation).insert(sample.imagePath);
+    }
+  }
+  assignment = std::move(updated);
+}
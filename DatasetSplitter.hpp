@@ -0,0 +1,51 @@
+#pragma once
+
+#include "DatasetConverter.hpp"
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+struct SplitOptions
+{
+  float validationFraction{0.1f};
+  uint32_t seed{0};
+  /// Every stratum (samples grouped by their rarest class) gets the validation fraction of its samples
+  bool isStratified{true};
+
+  bool operator==(SplitOptions const& other) const
+  {
+    return (validationFraction == other.validationFraction) && (seed == other.seed) && (isStratified == other.isStratified);
+  }
+  bool operator!=(SplitOptions const& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+/// Image paths of the samples already assigned to a split and the options they have been assigned with.
+struct SplitAssignment
+{
+  SplitOptions options;
+  std::set<std::string> training;
+  std::set<std::string> validation;
+};
+
+/**
+ * Assigns samples to training or validation independently of their order: within a stratum the samples
+ * are ranked by a seeded hash of the image path and the lowest ranked ones go to validation.
+ * Assigned samples keep their split while the options are the same, new samples only fill the
+ * validation quota of their stratum, so adding samples never moves the existing ones.
+ */
+struct DatasetSplitter
+{
+  /// labelsCount are per sample in the samples order, they are needed only for the stratified split.
+  /// The assignment is updated: samples which are gone are dropped, new ones are added.
+  static void split(std::vector<ConversionSample>& samples,
+                    std::vector<std::map<std::string, uint32_t>> const& labelsCount,
+                    SplitOptions const& options,
+                    SplitAssignment& assignment);
+  static auto rank(std::string const& imagePath, uint32_t seed) -> uint64_t;
+};
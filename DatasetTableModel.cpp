@@ -0,0 +1,150 @@
+#include "DatasetTableModel.hpp"
+
+#include <QDir>
+
+#include <algorithm>
+
+DatasetTableModel::DatasetTableModel(QObject* parent)
+  : QAbstractTableModel(parent)
+{
+}
+
+int DatasetTableModel::rowCount(QModelIndex const& parent) const
+{
+  return parent.isValid() ? 0 : static_cast<int>(_items.size());
+}
+
+int DatasetTableModel::columnCount(QModelIndex const& parent) const
+{
+  return parent.isValid() ? 0 : ColumnsCount;
+}
+
+QVariant DatasetTableModel::data(QModelIndex const& index, int role) const
+{
+  if (!index.isValid() || (index.row() >= static_cast<int>(_items.size())))
+  {
+    return {};
+  }
+  auto const& item = _items[index.row()];
+  switch (role)
+  {
+    case Qt::DisplayRole:
+      switch (index.column())
+      {
+        case AddedColumn:
+          return tr("Added");
+        case FileNameColumn:
+          return QDir::toNativeSeparators(QDir().relativeFilePath(QString::fromStdString(item.imagePath)));
+        case SizeColumn:
+          return QString::number(item.imageFileSize);
+        default:
+          break;
+      }
+      break;
+    case Qt::ToolTipRole:
+      if (index.column() != AddedColumn)
+      {
+        return QDir::toNativeSeparators(QString::fromStdString(item.imagePath));
+      }
+      break;
+    case Qt::CheckStateRole:
+      if (index.column() == AddedColumn)
+      {
+        return item.isAdded ? Qt::Checked : Qt::Unchecked;
+      }
+      break;
+    case Qt::TextAlignmentRole:
+      if (index.column() == SizeColumn)
+      {
+        return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+      }
+      break;
+    default:
+      break;
+  }
+  return {};
+}
+
+QVariant DatasetTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+  if ((orientation != Qt::Horizontal) || (role != Qt::DisplayRole))
+  {
+    return QAbstractTableModel::headerData(section, orientation, role);
+  }
+  switch (section)
+  {
+    case AddedColumn:
+      return tr("Added");
+    case FileNameColumn:
+      return tr("Filename");
+    case SizeColumn:
+      return tr("Size");
+    default:
+      return {};
+  }
+}
+
+Qt::ItemFlags DatasetTableModel::flags(QModelIndex const& index) const
+{
+  auto itemFlags = QAbstractTableModel::flags(index);
+  if (index.isValid() && (index.column() == AddedColumn))
+  {
+    itemFlags |= Qt::ItemIsUserCheckable;
+  }
+  return itemFlags;
+}
+
+bool DatasetTableModel::setData(QModelIndex const& index, QVariant const& value, int role)
+{
+  if (!index.isValid() || (index.column() != AddedColumn) || (role != Qt::CheckStateRole))
+  {
+    return false;
+  }
+  _items[index.row()].isAdded = (static_cast<Qt::CheckState>(value.toInt()) == Qt::Checked);
+  emit dataChanged(index, index, {Qt::CheckStateRole});
+  return true;
+}
+
+void DatasetTableModel::clear()
+{
+  beginResetModel();
+  _items.clear();
+  ++_generation;
+  endResetModel();
+}
+
+auto DatasetTableModel::generation() const -> uint64_t
+{
+  return _generation;
+}
+
+bool DatasetTableModel::append(std::vector<DatasetSample> const& samples, uint64_t generation)
+{
+  if (generation != _generation)
+  {
+    return false;
+  }
+  auto const validCount = std::count_if(samples.cbegin(), samples.cend(), [](DatasetSample const& sample) {
+    return sample.isValid;
+  });
+  if (validCount == 0)
+  {
+    return true;
+  }
+  auto const first = static_cast<int>(_items.size());
+  beginInsertRows(QModelIndex(), first, first + static_cast<int>(validCount) - 1);
+  for (auto const& sample : samples)
+  {
+    if (sample.isValid)
+    {
+      _items.push_back(Item{sample.imagePath, sample.annotationPath, sample.imageFileSize, sample.imageSize, true});
+    }
+  }
+  endInsertRows();
+  return true;
+}
+
+auto DatasetTableModel::item(int row) const -> Item const&
+{
+  return _items[row];
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "DatasetIndexer.hpp"
+
+#include <QAbstractTableModel>
+
+#include <string>
+#include <vector>
+
+/**
+ * Model of the dataset samples list, rows are appended by whole batches
+ * and no per-cell items are allocated.
+ */
+class DatasetTableModel : public QAbstractTableModel
+{
+Q_OBJECT
+
+public:
+  enum Column
+  {
+    AddedColumn,
+    FileNameColumn,
+    SizeColumn,
+    ColumnsCount
+  };
+
+  struct Item
+  {
+    std::string imagePath;
+    std::string annotationPath;
+    uint64_t imageFileSize{};
+    /// Known once indexed, lets viewers pick a decoder reduction before the image is read
+    cv::Size imageSize;
+    bool isAdded{true};
+  };
+
+  explicit DatasetTableModel(QObject* parent = nullptr);
+
+  int rowCount(QModelIndex const& parent = QModelIndex()) const override;
+  int columnCount(QModelIndex const& parent = QModelIndex()) const override;
+  QVariant data(QModelIndex const& index, int role = Qt::DisplayRole) const override;
+  QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+  Qt::ItemFlags flags(QModelIndex const& index) const override;
+  bool setData(QModelIndex const& index, QVariant const& value, int role = Qt::EditRole) override;
+
+  /// Starts a new generation, batches of the previous ones are dropped by append.
+  void clear();
+  auto generation() const -> uint64_t;
+  /// Returns false and drops the batch when it belongs to an older generation, e.g. it has been queued
+  /// by an indexing which is stopped since.
+  bool append(std::vector<DatasetSample> const& samples, uint64_t generation);
+  auto item(int row) const -> Item const&;
+
+private:
+  std::vector<Item> _items;
+  uint64_t _generation{};
+};
@@ -0,0 +1,93 @@
+#include "FileCloner.hpp"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _MSC_VER
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <system_error>
+
+namespace {
+#ifdef __linux__
+/// Reflink or kernel side copy, the data does not pass through the user space either way
+auto cloneInKernel(std::string const& sourcePath, std::string const& destinationPath) -> FileCloner::Method
+{
+  auto const sourceFd = ::open(sourcePath.c_str(), O_RDONLY);
+  if (sourceFd < 0)
+  {
+    return FileCloner::Method::Failed;
+  }
+  struct stat sourceStat{};
+  auto const destinationFd = (::fstat(sourceFd, &sourceStat) == 0)
+                             ? ::open(destinationPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, sourceStat.st_mode & 0777)
+                             : -1;
+  if (destinationFd < 0)
+  {
+    ::close(sourceFd);
+    return FileCloner::Method::Failed;
+  }
+
+  auto method = FileCloner::Method::Failed;
+#ifdef FICLONE
+  if (::ioctl(destinationFd, FICLONE, sourceFd) == 0)
+  {
+    method = FileCloner::Method::Reflink;
+  }
+#endif
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 27)))
+  if (method == FileCloner::Method::Failed)
+  {
+    auto left = static_cast<size_t>(sourceStat.st_size);
+    while (left > 0)
+    {
+      auto const copied = ::copy_file_range(sourceFd, nullptr, destinationFd, nullptr, left, 0);
+      if (copied <= 0)
+      {
+        break;
+      }
+      left -= static_cast<size_t>(copied);
+    }
+    method = (left == 0) ? FileCloner::Method::Copy : FileCloner::Method::Failed;
+  }
+#endif
+  ::close(destinationFd);
+  ::close(sourceFd);
+  return method;
+}
+#endif
+} /// end namespace anonymous
+
+auto FileCloner::clone(std::string const& sourcePath, std::string const& destinationPath, bool isHardlinkAllowed) -> Method
+{
+  std::error_code errorCode;
+  fs::remove(destinationPath, errorCode);
+  if (isHardlinkAllowed)
+  {
+    fs::create_hard_link(sourcePath, destinationPath, errorCode);
+    if (!errorCode)
+    {
+      return Method::Hardlink;
+    }
+  }
+#ifdef __linux__
+  auto const method = cloneInKernel(sourcePath, destinationPath);
+  if (method != Method::Failed)
+  {
+    return method;
+  }
+#endif
+  errorCode.clear();
+  fs::copy_file(sourcePath, destinationPath, fs::copy_options::overwrite_existing, errorCode);
+  return errorCode ? Method::Failed : Method::Copy;
+}
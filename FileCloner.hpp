@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+/**
+ * Puts a copy of a file at the destination as cheaply as the filesystem allows: a hard link when it is
+ * allowed, then a reflink (copy-on-write clone, FICLONE on Btrfs/XFS), then a kernel side copy
+ * (copy_file_range) and a plain copy at last. An existing destination is replaced.
+ */
+struct FileCloner
+{
+  enum class Method
+  {
+    Failed,
+    Hardlink,
+    Reflink,
+    Copy
+  };
+
+  static auto clone(std::string const& sourcePath, std::string const& destinationPath, bool isHardlinkAllowed) -> Method;
+};
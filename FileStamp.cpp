@@ -0,0 +1,57 @@
+#include "FileStamp.hpp"
+
+#ifdef _MSC_VER
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+auto FileStamp::of(std::string const& filePath, bool isHashed) -> FileStamp
+{
+  FileStamp stamp;
+  std::error_code errorCode;
+  stamp.modificationTime = static_cast<int64_t>(fs::last_write_time(filePath, errorCode).time_since_epoch().count());
+  stamp.size = static_cast<uint64_t>(fs::file_size(filePath, errorCode));
+  stamp.contentHash = isHashed ? hashFileContent(filePath) : 0;
+  return stamp;
+}
+
+auto FileStamp::hashFileContent(std::string const& filePath) -> uint64_t
+{
+  std::ifstream file(filePath, std::ios::binary);
+  uint64_t hash = 14695981039346656037ULL;
+  std::vector<char> buffer(1 << 16);
+  while (file)
+  {
+    file.read(buffer.data(), buffer.size());
+    auto const readCount = file.gcount();
+    for (std::streamsize i = 0; i < readCount; ++i)
+    {
+      hash ^= static_cast<uint8_t>(buffer[i]);
+      hash *= 1099511628211ULL;
+    }
+  }
+  return hash;
+}
+
+bool FileStamp::isFreshFor(std::string const& filePath, bool isContentHashed)
+{
+  auto const current = of(filePath, false);
+  if ((current.modificationTime == modificationTime) && (current.size == size))
+  {
+    return true;
+  }
+  if (!isContentHashed || (contentHash == 0) || (hashFileContent(filePath) != contentHash))
+  {
+    return false;
+  }
+  modificationTime = current.modificationTime;
+  size = current.size;
+  return true;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Identity of a file content for caches: modification time and size, optionally with a content hash,
+ * so a file which has been touched or copied without changes is still recognized.
+ */
+struct FileStamp
+{
+  int64_t modificationTime{};
+  uint64_t size{};
+  uint64_t contentHash{};
+
+  static auto of(std::string const& filePath, bool isHashed) -> FileStamp;
+  /// FNV-1a, good enough for detecting changed files.
+  static auto hashFileContent(std::string const& filePath) -> uint64_t;
+
+  /// Compares time and size with the file, when they differ and the stamp has the hash, the content is hashed
+  /// and the stamp takes the new time and size if the content is the same.
+  bool isFreshFor(std::string const& filePath, bool isContentHashed);
+};
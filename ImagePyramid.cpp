@@ -0,0 +1,182 @@
+#include "ImagePyramid.hpp"
+#include "MaskRasterizer.hpp"
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+/// The finest levels hold most of the memory, the one in view and the one zoomed from are kept
+constexpr size_t keptLevelsCount = 2;
+/// Levels finer than it are decoded by the decoder reductions
+constexpr int decodedLevelsCount = 4;
+
+auto readMode(int level) -> int
+{
+  switch (level)
+  {
+    case 0:
+      return cv::IMREAD_COLOR;
+    case 1:
+      return cv::IMREAD_REDUCED_COLOR_2;
+    case 2:
+      return cv::IMREAD_REDUCED_COLOR_4;
+    default:
+      return cv::IMREAD_REDUCED_COLOR_8;
+  }
+}
+} /// end namespace anonymous
+
+ImagePyramid::ImagePyramid(std::string imagePath, cv::Size imageSize, std::vector<PyramidLayer> layers, std::map<std::string, cv::Scalar> colorToClass)
+  : _imagePath(std::move(imagePath))
+  , _imageSize(imageSize)
+  , _layers(std::move(layers))
+  , _colorToClass(std::move(colorToClass))
+{
+  for (auto const& layer : _layers)
+  {
+    _isLabelMe.push_back(layer.path.substr(layer.path.find_last_of('.') + 1) == "json");
+    _annotations.emplace_back();
+    if (_isLabelMe.back())
+    {
+      LabelMeReader::read(layer.path, _annotations.back(), LabelMeReader::ImageSize | LabelMeReader::Shapes);
+    }
+  }
+}
+
+auto ImagePyramid::imageSize() const -> cv::Size
+{
+  return _imageSize;
+}
+
+auto ImagePyramid::levelsCount() const -> int
+{
+  int count = 1;
+  while (std::max(levelSize(count - 1).width, levelSize(count - 1).height) > tileSize)
+  {
+    ++count;
+  }
+  return count;
+}
+
+auto ImagePyramid::levelFor(double scale) const -> int
+{
+  if (scale >= 1.0)
+  {
+    return 0;
+  }
+  auto const level = static_cast<int>(std::floor(std::log2(1.0 / scale)));
+  return std::clamp(level, 0, levelsCount() - 1);
+}
+
+auto ImagePyramid::tilesCount(int level) const -> cv::Size
+{
+  auto const size = levelSize(level);
+  return cv::Size((size.width + tileSize - 1) / tileSize, (size.height + tileSize - 1) / tileSize);
+}
+
+auto ImagePyramid::tileRect(int level, cv::Point tile) const -> cv::Rect
+{
+  auto const step = tileSize << level;
+  return cv::Rect(tile.x * step, tile.y * step, step, step) & cv::Rect(cv::Point(), _imageSize);
+}
+
+auto ImagePyramid::renderTile(int levelIndex, cv::Point tile, std::atomic<bool> const& isCanceled) -> cv::Mat
+{
+  if (isCanceled)
+  {
+    return {};
+  }
+  auto const levelData = level(levelIndex);
+  auto const rect = cv::Rect(tile.x * tileSize, tile.y * tileSize, tileSize, tileSize) & cv::Rect(cv::Point(), levelData.image.size());
+  if (isCanceled || rect.empty())
+  {
+    return {};
+  }
+
+  cv::Mat result = levelData.image(rect).clone();
+  cv::Mat mask;
+  for (size_t i = 0; i < _layers.size(); ++i)
+  {
+    if (_isLabelMe[i])
+    {
+      auto const& annotation = _annotations[i];
+      MaskRasterizer::Transform transform;
+      transform.scaleX = static_cast<double>(levelData.image.cols) / ((annotation.imageWidth > 0) ? annotation.imageWidth : _imageSize.width);
+      transform.scaleY = static_cast<double>(levelData.image.rows) / ((annotation.imageHeight > 0) ? annotation.imageHeight : _imageSize.height);
+      transform.offset = rect.tl();
+      mask.create(rect.size(), CV_8UC3);
+      MaskRasterizer::rasterize(annotation, _colorToClass, transform, mask);
+    }
+    else if (!levelData.masks[i].empty())
+    {
+      mask = levelData.masks[i](rect);
+    }
+    else
+    {
+      continue;
+    }
+    cv::addWeighted(result, 1.0, mask, _layers[i].alpha, 0.0, result);
+  }
+  return result;
+}
+
+auto ImagePyramid::levelSize(int level) const -> cv::Size
+{
+  auto const scale = 1 << level;
+  return cv::Size((_imageSize.width + scale - 1) / scale, (_imageSize.height + scale - 1) / scale);
+}
+
+auto ImagePyramid::decodeLevel(int levelIndex) -> Level
+{
+  Level result;
+  if (levelIndex < decodedLevelsCount)
+  {
+    result.image = cv::imread(_imagePath, readMode(levelIndex));
+  }
+  else
+  {
+    /// Reuses the coarsest decoded level, it is cached as well
+    auto const base = level(decodedLevelsCount - 1).image;
+    if (!base.empty())
+    {
+      cv::resize(base, result.image, levelSize(levelIndex), 0.0, 0.0, cv::INTER_AREA);
+    }
+  }
+  result.masks.resize(_layers.size());
+  for (size_t i = 0; (i < _layers.size()) && !result.image.empty(); ++i)
+  {
+    if (_isLabelMe[i])
+    {
+      continue;
+    }
+    /// Reduced decoding would average class colors, masks are always scaled by the nearest neighbour
+    auto& mask = result.masks[i];
+    mask = cv::imread(_layers[i].path, cv::IMREAD_COLOR);
+    if (!mask.empty() && (mask.size() != result.image.size()))
+    {
+      cv::resize(mask, mask, result.image.size(), 0.0, 0.0, cv::INTER_NEAREST);
+    }
+  }
+  return result;
+}
+
+auto ImagePyramid::level(int levelIndex) -> Level
+{
+  std::lock_guard<std::recursive_mutex> lock(_mutex);
+  auto const cached = std::find_if(_levels.begin(), _levels.end(), [levelIndex](auto const& entry) { return entry.first == levelIndex; });
+  if (cached != _levels.end())
+  {
+    _levels.splice(_levels.begin(), _levels, cached);
+    return _levels.front().second;
+  }
+  _levels.emplace_front(levelIndex, decodeLevel(levelIndex));
+  auto result = _levels.front().second;
+  while (_levels.size() > keptLevelsCount)
+  {
+    _levels.pop_back();
+  }
+  return result;
+}
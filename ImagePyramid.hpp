@@ -0,0 +1,72 @@
+#pragma once
+
+#include "LabelMeReader.hpp"
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// Mask blended over the image: a "labelme" annotation or a color mask image (annotation or prediction).
+struct PyramidLayer
+{
+  std::string path;
+  double alpha{0.5};
+};
+
+/**
+ * Image of any size viewed by tiles. Level k is the image scaled by 1/2^k: levels up to 1/8 are decoded
+ * straight at their scale by the JPEG/PNG decoder reductions, coarser ones are downscaled from 1/8.
+ * Levels are decoded on the first tile request only and just a few recent ones are kept, so the full
+ * resolution image is held in memory only while it is zoomed in. Layers are composited per tile,
+ * "labelme" shapes are rasterized at the tile resolution.
+ * Thread safe, tiles could be rendered concurrently.
+ */
+class ImagePyramid
+{
+public:
+  static constexpr int tileSize = 512;
+
+  /// The image size must be the full resolution size, the image is not read here.
+  ImagePyramid(std::string imagePath, cv::Size imageSize, std::vector<PyramidLayer> layers, std::map<std::string, cv::Scalar> colorToClass);
+
+  auto imageSize() const -> cv::Size;
+  /// The coarsest level fits into one tile.
+  auto levelsCount() const -> int;
+  /// The coarsest level which still has at least the given number of level pixels per image pixel.
+  auto levelFor(double scale) const -> int;
+  auto tilesCount(int level) const -> cv::Size;
+  /// Tile bounds in the full resolution coordinates, clipped by the image.
+  auto tileRect(int level, cv::Point tile) const -> cv::Rect;
+  /// BGR tile with the layers blended, empty when the image could not be decoded or when canceled.
+  auto renderTile(int level, cv::Point tile, std::atomic<bool> const& isCanceled) -> cv::Mat;
+
+private:
+  struct Level
+  {
+    cv::Mat image;
+    /// Per layer, empty for "labelme" layers which are rasterized per tile
+    std::vector<cv::Mat> masks;
+  };
+
+  auto levelSize(int level) const -> cv::Size;
+  auto decodeLevel(int level) -> Level;
+  auto level(int level) -> Level;
+
+  std::string _imagePath;
+  cv::Size _imageSize;
+  std::vector<PyramidLayer> _layers;
+  std::map<std::string, cv::Scalar> _colorToClass;
+  /// Parsed once, empty for mask image layers
+  std::vector<LabelMeAnnotation> _annotations;
+  std::vector<bool> _isLabelMe;
+
+  /// Recursive, coarse levels are built from the coarsest decoded one while the lock is held
+  std::recursive_mutex _mutex;
+  /// Most recently used first
+  std::list<std::pair<int, Level>> _levels;
+};
@@ -0,0 +1,556 @@
+#include "LabelMeReader.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace {
+/// In place JSON scanner over a buffer, only what the annotations need is parsed.
+class JsonCursor
+{
+public:
+  JsonCursor(char const* begin, char const* end)
+    : _position{begin}
+    , _end{end}
+  {
+  }
+
+  auto position() const -> char const*
+  {
+    return _position;
+  }
+
+  void skipWhitespace()
+  {
+    while ((_position < _end) && ((*_position == ' ') || (*_position == '\n') || (*_position == '\r') || (*_position == '\t')))
+    {
+      ++_position;
+    }
+  }
+
+  bool consume(char c)
+  {
+    skipWhitespace();
+    if ((_position < _end) && (*_position == c))
+    {
+      ++_position;
+      return true;
+    }
+    return false;
+  }
+
+  bool peek(char c)
+  {
+    skipWhitespace();
+    return (_position < _end) && (*_position == c);
+  }
+
+  /// The value is unescaped into out, nullptr just skips the string.
+  bool parseString(std::string* out)
+  {
+    if (!consume('"'))
+    {
+      return false;
+    }
+    if (out != nullptr)
+    {
+      out->clear();
+    }
+    while (_position < _end)
+    {
+      /// Long runs (base64 image data) are skipped with memchr without looking at every char
+      auto const quote = static_cast<char const*>(std::memchr(_position, '"', _end - _position));
+      if (quote == nullptr)
+      {
+        return false;
+      }
+      auto const escape = static_cast<char const*>(std::memchr(_position, '\\', quote - _position));
+      auto const chunkEnd = (escape != nullptr) ? escape : quote;
+      if (out != nullptr)
+      {
+        out->append(_position, chunkEnd);
+      }
+      _position = chunkEnd + 1;
+      if (escape == nullptr)
+      {
+        return true;
+      }
+      if (!parseEscape(out))
+      {
+        return false;
+      }
+    }
+    return false;
+  }
+
+  /// Parsed by hand, strtod depends on the locale (QApplication sets the system one)
+  bool parseNumber(double& value)
+  {
+    skipWhitespace();
+    auto const begin = _position;
+    auto const isNegative = (_position < _end) && (*_position == '-');
+    if (isNegative)
+    {
+      ++_position;
+    }
+    double mantissa = 0.0;
+    int exponent = 0;
+    while ((_position < _end) && isDigit(*_position))
+    {
+      mantissa = (mantissa * 10.0) + (*_position++ - '0');
+    }
+    if ((_position < _end) && (*_position == '.'))
+    {
+      ++_position;
+      while ((_position < _end) && isDigit(*_position))
+      {
+        mantissa = (mantissa * 10.0) + (*_position++ - '0');
+        --exponent;
+      }
+    }
+    if ((_position < _end) && ((*_position == 'e') || (*_position == 'E')))
+    {
+      ++_position;
+      auto const isExponentNegative = (_position < _end) && (*_position == '-');
+      if ((_position < _end) && ((*_position == '-') || (*_position == '+')))
+      {
+        ++_position;
+      }
+      int explicitExponent = 0;
+      while ((_position < _end) && isDigit(*_position))
+      {
+        explicitExponent = (explicitExponent * 10) + (*_position++ - '0');
+      }
+      exponent += isExponentNegative ? -explicitExponent : explicitExponent;
+    }
+    if ((_position - begin) == (isNegative ? 1 : 0))
+    {
+      return false;
+    }
+    value = mantissa * std::pow(10.0, exponent);
+    value = isNegative ? -value : value;
+    return true;
+  }
+
+  bool skipValue()
+  {
+    skipWhitespace();
+    if (_position >= _end)
+    {
+      return false;
+    }
+    switch (*_position)
+    {
+      case '"':
+        return parseString(nullptr);
+      case '{':
+      case '[':
+        return skipContainer();
+      default:
+        while ((_position < _end) && (*_position != ',') && (*_position != '}') && (*_position != ']'))
+        {
+          ++_position;
+        }
+        return true;
+    }
+  }
+
+private:
+  static bool isDigit(char c)
+  {
+    return (c >= '0') && (c <= '9');
+  }
+
+  bool parseEscape(std::string* out)
+  {
+    if (_position >= _end)
+    {
+      return false;
+    }
+    auto const c = *_position++;
+    char unescaped = c;
+    switch (c)
+    {
+      case 'b': unescaped = '\b'; break;
+      case 'f': unescaped = '\f'; break;
+      case 'n': unescaped = '\n'; break;
+      case 'r': unescaped = '\r'; break;
+      case 't': unescaped = '\t'; break;
+      case 'u':
+        return parseCodePoint(out);
+      default:
+        break;
+    }
+    if (out != nullptr)
+    {
+      out->push_back(unescaped);
+    }
+    return true;
+  }
+
+  bool parseHex(uint32_t& value)
+  {
+    if ((_end - _position) < 4)
+    {
+      return false;
+    }
+    value = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+      auto const c = *_position++;
+      value <<= 4;
+      if ((c >= '0') && (c <= '9')) value |= c - '0';
+      else if ((c >= 'a') && (c <= 'f')) value |= c - 'a' + 10;
+      else if ((c >= 'A') && (c <= 'F')) value |= c - 'A' + 10;
+      else return false;
+    }
+    return true;
+  }
+
+  bool parseCodePoint(std::string* out)
+  {
+    uint32_t codePoint{};
+    if (!parseHex(codePoint))
+    {
+      return false;
+    }
+    if ((codePoint >= 0xD800) && (codePoint < 0xDC00) && ((_end - _position) >= 6) && (_position[0] == '\\') && (_position[1] == 'u'))
+    {
+      _position += 2;
+      uint32_t low{};
+      if (!parseHex(low))
+      {
+        return false;
+      }
+      codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+    }
+    if (out == nullptr)
+    {
+      return true;
+    }
+    if (codePoint < 0x80)
+    {
+      out->push_back(static_cast<char>(codePoint));
+    }
+    else if (codePoint < 0x800)
+    {
+      out->push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+      out->push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    else if (codePoint < 0x10000)
+    {
+      out->push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+      out->push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+      out->push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    else
+    {
+      out->push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+      out->push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+      out->push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+      out->push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    return true;
+  }
+
+  /// Strings are skipped as a whole, so brackets inside of them are not counted
+  bool skipContainer()
+  {
+    size_t depth = 0;
+    while (_position < _end)
+    {
+      switch (*_position)
+      {
+        case '"':
+          if (!parseString(nullptr))
+          {
+            return false;
+          }
+          continue;
+        case '{':
+        case '[':
+          ++depth;
+          break;
+        case '}':
+        case ']':
+          if (--depth == 0)
+          {
+            ++_position;
+            return true;
+          }
+          break;
+        default:
+          break;
+      }
+      ++_position;
+    }
+    return false;
+  }
+
+  char const* _position;
+  char const* _end;
+};
+
+/// Calls onMember(key) with the cursor at the member value, the callback has to consume the value.
+template <typename Callback>
+bool parseObject(JsonCursor& cursor, Callback&& onMember)
+{
+  if (!cursor.consume('{'))
+  {
+    return false;
+  }
+  if (cursor.consume('}'))
+  {
+    return true;
+  }
+  std::string key;
+  do
+  {
+    if (!cursor.parseString(&key) || !cursor.consume(':') || !onMember(key))
+    {
+      return false;
+    }
+  } while (cursor.consume(','));
+  return cursor.consume('}');
+}
+
+template <typename Callback>
+bool parseArray(JsonCursor& cursor, Callback&& onItem)
+{
+  if (!cursor.consume('['))
+  {
+    return false;
+  }
+  if (cursor.consume(']'))
+  {
+    return true;
+  }
+  do
+  {
+    if (!onItem())
+    {
+      return false;
+    }
+  } while (cursor.consume(','));
+  return cursor.consume(']');
+}
+
+bool parsePoints(JsonCursor& cursor, std::vector<cv::Point2f>& points)
+{
+  return parseArray(cursor, [&]() {
+    double coordinates[2]{};
+    size_t count = 0;
+    auto const isParsed = parseArray(cursor, [&]() {
+      double value{};
+      if (!cursor.parseNumber(value))
+      {
+        return false;
+      }
+      if (count < 2)
+      {
+        coordinates[count] = value;
+      }
+      ++count;
+      return true;
+    });
+    points.emplace_back(static_cast<float>(coordinates[0]), static_cast<float>(coordinates[1]));
+    return isParsed && (count >= 2);
+  });
+}
+
+bool parseShape(JsonCursor& cursor, LabelMeShape& shape)
+{
+  return parseObject(cursor, [&](std::string const& key) {
+    if (key == "label")
+    {
+      return cursor.parseString(&shape.label);
+    }
+    if (key == "shape_type")
+    {
+      if (cursor.peek('"'))
+      {
+        return cursor.parseString(&shape.shapeType);
+      }
+      return cursor.skipValue();
+    }
+    if (key == "points")
+    {
+      return parsePoints(cursor, shape.points);
+    }
+    return cursor.skipValue();
+  });
+}
+
+bool readFile(std::string const& filePath, std::string& content)
+{
+  std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+  if (!file)
+  {
+    return false;
+  }
+  content.resize(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  return static_cast<bool>(file.read(&content[0], static_cast<std::streamsize>(content.size())));
+}
+
+void writeString(std::ostream& stream, std::string const& value)
+{
+  stream << '"';
+  for (auto c : value)
+  {
+    switch (c)
+    {
+      case '"': stream << "\\\""; break;
+      case '\\': stream << "\\\\"; break;
+      case '\n': stream << "\\n"; break;
+      case '\r': stream << "\\r"; break;
+      case '\t': stream << "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20)
+        {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+          stream << escaped;
+        }
+        else
+        {
+          stream << c;
+        }
+        break;
+    }
+  }
+  stream << '"';
+}
+} /// end namespace anonymous
+
+auto LabelMeAnnotation::labelsCount() const -> std::map<std::string, uint32_t>
+{
+  std::map<std::string, uint32_t> labelsCount;
+  for (auto const& shape : shapes)
+  {
+    ++labelsCount[shape.label];
+  }
+  return labelsCount;
+}
+
+bool LabelMeReader::read(std::string const& annotationPath, LabelMeAnnotation& annotation, uint32_t fields)
+{
+  std::string json;
+  return readFile(annotationPath, json) && parse(json, annotation, fields);
+}
+
+bool LabelMeReader::parse(std::string const& json, LabelMeAnnotation& annotation, uint32_t fields)
+{
+  JsonCursor cursor(json.data(), json.data() + json.size());
+  return parseObject(cursor, [&](std::string const& key) {
+    if ((fields & ImagePath) && (key == "imagePath"))
+    {
+      return cursor.parseString(&annotation.imagePath);
+    }
+    if ((fields & ImageSize) && ((key == "imageWidth") || (key == "imageHeight")))
+    {
+      double value{};
+      if (!cursor.parseNumber(value))
+      {
+        return false;
+      }
+      ((key == "imageWidth") ? annotation.imageWidth : annotation.imageHeight) = static_cast<int>(value);
+      return true;
+    }
+    if ((fields & Shapes) && (key == "shapes"))
+    {
+      return parseArray(cursor, [&]() {
+        annotation.shapes.emplace_back();
+        return parseShape(cursor, annotation.shapes.back());
+      });
+    }
+    return cursor.skipValue();
+  });
+}
+
+auto LabelMeReader::readImagePath(std::string const& annotationPath, size_t headSize) -> std::string
+{
+  std::ifstream file(annotationPath, std::ios::binary);
+  if (!file)
+  {
+    return {};
+  }
+  std::string head(headSize, '\0');
+  file.read(&head[0], static_cast<std::streamsize>(head.size()));
+  auto const isWholeFile = static_cast<size_t>(file.gcount()) < headSize;
+  head.resize(static_cast<size_t>(file.gcount()));
+
+  /// Parsing is stopped right after imagePath, so a truncated tail does not matter
+  std::string imagePath;
+  bool isFound = false;
+  JsonCursor cursor(head.data(), head.data() + head.size());
+  parseObject(cursor, [&](std::string const& key) {
+    if (key == "imagePath")
+    {
+      isFound = cursor.parseString(&imagePath);
+      return false;
+    }
+    return cursor.skipValue();
+  });
+  if (isFound || isWholeFile)
+  {
+    return imagePath;
+  }
+  LabelMeAnnotation annotation;
+  read(annotationPath, annotation, ImagePath);
+  return annotation.imagePath;
+}
+
+bool LabelMeReader::copyWithImagePath(std::string const& sourcePath, std::string const& destinationPath, std::string const& imagePath)
+{
+  std::string json;
+  if (!readFile(sourcePath, json))
+  {
+    return false;
+  }
+  JsonCursor cursor(json.data(), json.data() + json.size());
+  char const* valueBegin = nullptr;
+  char const* valueEnd = nullptr;
+  size_t membersCount = 0;
+  auto const isParsed = parseObject(cursor, [&](std::string const& key) {
+    ++membersCount;
+    if (key == "imagePath")
+    {
+      cursor.skipWhitespace();
+      valueBegin = cursor.position();
+      auto const isSkipped = cursor.skipValue();
+      valueEnd = cursor.position();
+      return isSkipped;
+    }
+    return cursor.skipValue();
+  });
+  if (!isParsed)
+  {
+    return false;
+  }
+
+  std::ofstream file(destinationPath, std::ios::binary | std::ios::trunc);
+  if (valueBegin == nullptr)
+  {
+    /// No imagePath member, it is added as the first one
+    auto const objectBegin = json.find('{') + 1;
+    file.write(json.data(), static_cast<std::streamsize>(objectBegin));
+    file << "\"imagePath\": ";
+    writeString(file, imagePath);
+    /// An empty object gets no separator, a trailing comma is not JSON
+    if (membersCount != 0)
+    {
+      file << ",";
+    }
+    file.write(json.data() + objectBegin, static_cast<std::streamsize>(json.size() - objectBegin));
+  }
+  else
+  {
+    file.write(json.data(), valueBegin - json.data());
+    writeString(file, imagePath);
+    file.write(valueEnd, (json.data() + json.size()) - valueEnd);
+  }
+  return static_cast<bool>(file.flush());
+}
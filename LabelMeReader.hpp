@@ -0,0 +1,50 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+struct LabelMeShape
+{
+  std::string label;
+  std::string shapeType{"polygon"};
+  std::vector<cv::Point2f> points;
+};
+
+struct LabelMeAnnotation
+{
+  std::string imagePath;
+  int imageWidth{};
+  int imageHeight{};
+  std::vector<LabelMeShape> shapes;
+
+  auto labelsCount() const -> std::map<std::string, uint32_t>;
+};
+
+/**
+ * Reads "labelme" annotations without building a property tree. The file is read into one buffer
+ * and parsed in place, members which are not requested (the base64 "imageData" above all) are skipped
+ * by scanning for the closing quote, so nothing is allocated for them.
+ */
+struct LabelMeReader
+{
+  enum Fields : uint32_t
+  {
+    ImagePath = 1,
+    ImageSize = 2,
+    Shapes = 4,
+    AllFields = ImagePath | ImageSize | Shapes
+  };
+
+  /// Returns false when the file could not be read or is not a valid JSON object.
+  static bool read(std::string const& annotationPath, LabelMeAnnotation& annotation, uint32_t fields = AllFields);
+  static bool parse(std::string const& json, LabelMeAnnotation& annotation, uint32_t fields = AllFields);
+  /// Reads only the head of the file, the whole file is read just when imagePath is not found in the head
+  /// (e.g. it is written after the image data).
+  static auto readImagePath(std::string const& annotationPath, size_t headSize = 64 * 1024) -> std::string;
+  /// Copies the annotation replacing only the "imagePath" value, the rest of the file is kept byte for byte.
+  static bool copyWithImagePath(std::string const& sourcePath, std::string const& destinationPath, std::string const& imagePath);
+};
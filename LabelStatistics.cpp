@@ -0,0 +1,191 @@
+#include "LabelStatistics.hpp"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+struct Component
+{
+  uint32_t color{};
+  int minX{std::numeric_limits<int>::max()};
+  int minY{std::numeric_limits<int>::max()};
+  int maxX{-1};
+  int maxY{-1};
+  uint64_t area{};
+
+  void add(int x, int y)
+  {
+    minX = std::min(minX, x);
+    minY = std::min(minY, y);
+    maxX = std::max(maxX, x);
+    maxY = std::max(maxY, y);
+    ++area;
+  }
+
+  void add(Component const& other)
+  {
+    minX = std::min(minX, other.minX);
+    minY = std::min(minY, other.minY);
+    maxX = std::max(maxX, other.maxX);
+    maxY = std::max(maxY, other.maxY);
+    area += other.area;
+  }
+};
+
+auto findRoot(std::vector<int32_t>& parent, int32_t label) -> int32_t
+{
+  while (parent[label] != label)
+  {
+    parent[label] = parent[parent[label]];
+    label = parent[label];
+  }
+  return label;
+}
+
+auto unite(std::vector<int32_t>& parent, int32_t a, int32_t b) -> int32_t
+{
+  a = findRoot(parent, a);
+  b = findRoot(parent, b);
+  if (a == b)
+  {
+    return a;
+  }
+  if (a > b)
+  {
+    std::swap(a, b);
+  }
+  parent[b] = a;
+  return a;
+}
+
+auto packColor(cv::Vec3b const& color) -> uint32_t
+{
+  return static_cast<uint32_t>(color[0]) | (static_cast<uint32_t>(color[1]) << 8) | (static_cast<uint32_t>(color[2]) << 16);
+}
+
+auto unpackColor(uint32_t color) -> cv::Vec3b
+{
+  return cv::Vec3b(static_cast<uint8_t>(color & 0xFF), static_cast<uint8_t>((color >> 8) & 0xFF), static_cast<uint8_t>((color >> 16) & 0xFF));
+}
+} /// end namespace anonymous
+
+void LabelStatistics::merge(LabelStatistics const& other)
+{
+  for (auto const& rects : other.boundingBoxes)
+  {
+    auto& destination = boundingBoxes[rects.first];
+    destination.insert(destination.end(), rects.second.cbegin(), rects.second.cend());
+  }
+  for (auto const& count : other.pixelsCount)
+  {
+    pixelsCount[count.first] += count.second;
+  }
+}
+
+auto LabelStatistics::calculate(cv::Mat const& labelsImage) -> LabelStatistics
+{
+  LabelStatistics result;
+  if (labelsImage.empty() || (labelsImage.type() != CV_8UC3))
+  {
+    return result;
+  }
+
+  /// Two rows of packed colors and provisional labels are enough, because the statistics are
+  /// accumulated per provisional label and the equivalences are resolved at the end.
+  auto const cols = labelsImage.cols;
+  std::vector<uint32_t> previousColors(cols);
+  std::vector<uint32_t> currentColors(cols);
+  std::vector<int32_t> previousLabels(cols, -1);
+  std::vector<int32_t> currentLabels(cols, -1);
+  std::vector<int32_t> parent;
+  std::vector<Component> components;
+
+  auto joinNeighbour = [&](int32_t label, int32_t neighbour) -> int32_t {
+    return (label == -1) ? findRoot(parent, neighbour) : unite(parent, label, neighbour);
+  };
+
+  for (auto r = 0; r < labelsImage.rows; ++r)
+  {
+    auto ptr = labelsImage.ptr<cv::Vec3b>(r);
+    for (auto c = 0; c < cols; ++c)
+    {
+      auto const color = packColor(ptr[c]);
+      currentColors[c] = color;
+
+      int32_t label = -1;
+      if ((c > 0) && (currentColors[c - 1] == color))
+      {
+        label = joinNeighbour(label, currentLabels[c - 1]);
+      }
+      if (r > 0)
+      {
+        if ((c > 0) && (previousColors[c - 1] == color))
+        {
+          label = joinNeighbour(label, previousLabels[c - 1]);
+        }
+        if (previousColors[c] == color)
+        {
+          label = joinNeighbour(label, previousLabels[c]);
+        }
+        if ((c + 1 < cols) && (previousColors[c + 1] == color))
+        {
+          label = joinNeighbour(label, previousLabels[c + 1]);
+        }
+      }
+      if (label == -1)
+      {
+        label = static_cast<int32_t>(parent.size());
+        parent.push_back(label);
+        components.emplace_back();
+        components.back().color = color;
+      }
+      currentLabels[c] = label;
+      components[label].add(c, r);
+    }
+    std::swap(previousColors, currentColors);
+    std::swap(previousLabels, currentLabels);
+  }
+
+  for (auto label = 0; label < static_cast<int32_t>(components.size()); ++label)
+  {
+    auto const root = findRoot(parent, label);
+    if (root != label)
+    {
+      components[root].add(components[label]);
+    }
+  }
+  for (auto label = 0; label < static_cast<int32_t>(components.size()); ++label)
+  {
+    if (parent[label] != label)
+    {
+      continue;
+    }
+    auto const& component = components[label];
+    auto const color = unpackColor(component.color);
+    result.boundingBoxes[color].emplace_back(component.minX,
+                                             component.minY,
+                                             component.maxX - component.minX + 1,
+                                             component.maxY - component.minY + 1);
+    result.pixelsCount[color] += component.area;
+  }
+  return result;
+}
+
+auto LabelStatistics::calculate(std::string const& labelsFile) -> LabelStatistics
+{
+  return calculate(cv::imread(labelsFile, cv::IMREAD_COLOR));
+}
+
+auto LabelStatistics::calculate(std::vector<std::string> const& labelsFiles) -> std::vector<LabelStatistics>
+{
+  std::vector<LabelStatistics> result(labelsFiles.size());
+  cv::parallel_for_(cv::Range(0, static_cast<int>(labelsFiles.size())), [&](cv::Range const& range) {
+    for (auto i = range.start; i < range.end; ++i)
+    {
+      result[i] = calculate(labelsFiles[i]);
+    }
+  });
+  return result;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace std {
+template<>
+struct less<cv::Vec3b>
+{
+  bool operator()(::cv::Vec3b const& a, ::cv::Vec3b const& b) const
+  {
+    return std::tie(a[0], a[1], a[2]) < std::tie(b[0], b[1], b[2]);
+  }
+};
+}
+
+/**
+ * Per-mask class statistics: bounding boxes of the 8-connected components
+ * of every color and the pixels count of every color.
+ * Both are built in a single labeling pass over the mask.
+ */
+struct LabelStatistics
+{
+  std::map<cv::Vec3b, std::vector<cv::Rect>> boundingBoxes;
+  std::map<cv::Vec3b, uint64_t> pixelsCount;
+
+  void merge(LabelStatistics const& other);
+
+  static auto calculate(cv::Mat const& labelsImage) -> LabelStatistics;
+  static auto calculate(std::string const& labelsFile) -> LabelStatistics;
+  /// Processes files in parallel on all available cores, result order matches the input order.
+  static auto calculate(std::vector<std::string> const& labelsFiles) -> std::vector<LabelStatistics>;
+};
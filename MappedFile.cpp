@@ -0,0 +1,188 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <utility>
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+  *this = std::move(other);
+}
+
+auto MappedFile::operator=(MappedFile&& other) noexcept -> MappedFile&
+{
+  if (this != &other)
+  {
+    close();
+    std::swap(_data, other._data);
+    std::swap(_size, other._size);
+#ifdef _WIN32
+    std::swap(_fileHandle, other._fileHandle);
+    std::swap(_mappingHandle, other._mappingHandle);
+#endif
+  }
+  return *this;
+}
+
+#ifdef _WIN32
+bool MappedFile::open(std::string const& filePath)
+{
+  close();
+  auto fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (fileHandle == INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(fileHandle, &fileSize) || (fileSize.QuadPart == 0))
+  {
+    CloseHandle(fileHandle);
+    return false;
+  }
+  auto mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mappingHandle == nullptr)
+  {
+    CloseHandle(fileHandle);
+    return false;
+  }
+  auto data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+  if (data == nullptr)
+  {
+    CloseHandle(mappingHandle);
+    CloseHandle(fileHandle);
+    return false;
+  }
+  _fileHandle = fileHandle;
+  _mappingHandle = mappingHandle;
+  _data = static_cast<uint8_t*>(data);
+  _size = static_cast<size_t>(fileSize.QuadPart);
+  return true;
+}
+
+bool MappedFile::create(std::string const& filePath, size_t size)
+{
+  close();
+  if (size == 0)
+  {
+    return false;
+  }
+  auto fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (fileHandle == INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+  DWORD bytesReturned = 0;
+  DeviceIoControl(fileHandle, FSCTL_SET_SPARSE, nullptr, 0, nullptr, 0, &bytesReturned, nullptr);
+  LARGE_INTEGER fileSize;
+  fileSize.QuadPart = static_cast<LONGLONG>(size);
+  auto mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READWRITE, fileSize.HighPart, fileSize.LowPart, nullptr);
+  if (mappingHandle == nullptr)
+  {
+    CloseHandle(fileHandle);
+    return false;
+  }
+  auto data = MapViewOfFile(mappingHandle, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+  if (data == nullptr)
+  {
+    CloseHandle(mappingHandle);
+    CloseHandle(fileHandle);
+    return false;
+  }
+  _fileHandle = fileHandle;
+  _mappingHandle = mappingHandle;
+  _data = static_cast<uint8_t*>(data);
+  _size = size;
+  return true;
+}
+
+void MappedFile::close()
+{
+  if (_data != nullptr)
+  {
+    UnmapViewOfFile(_data);
+    CloseHandle(_mappingHandle);
+    CloseHandle(_fileHandle);
+  }
+  _data = nullptr;
+  _size = 0;
+  _fileHandle = nullptr;
+  _mappingHandle = nullptr;
+}
+#else
+bool MappedFile::open(std::string const& filePath)
+{
+  close();
+  auto const fd = ::open(filePath.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return false;
+  }
+  struct stat fileStat{};
+  if ((::fstat(fd, &fileStat) != 0) || (fileStat.st_size == 0))
+  {
+    ::close(fd);
+    return false;
+  }
+  auto data = ::mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  /// The mapping keeps its own reference to the file
+  ::close(fd);
+  if (data == MAP_FAILED)
+  {
+    return false;
+  }
+  _data = static_cast<uint8_t*>(data);
+  _size = static_cast<size_t>(fileStat.st_size);
+  return true;
+}
+
+bool MappedFile::create(std::string const& filePath, size_t size)
+{
+  close();
+  if (size == 0)
+  {
+    return false;
+  }
+  auto const fd = ::open(filePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0)
+  {
+    return false;
+  }
+  if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+  {
+    ::close(fd);
+    return false;
+  }
+  auto data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED)
+  {
+    return false;
+  }
+  _data = static_cast<uint8_t*>(data);
+  _size = size;
+  return true;
+}
+
+void MappedFile::close()
+{
+  if (_data != nullptr)
+  {
+    ::munmap(_data, _size);
+  }
+  _data = nullptr;
+  _size = 0;
+}
+#endif
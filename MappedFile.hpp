@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Memory mapping of a whole file. Pages are loaded by the OS on first access and shared
+ * with the page cache, so reading a record costs no copy and no system call.
+ * Move only, the mapping is released by the destructor.
+ */
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(MappedFile&& other) noexcept;
+  auto operator=(MappedFile&& other) noexcept -> MappedFile&;
+  MappedFile(MappedFile const&) = delete;
+  auto operator=(MappedFile const&) -> MappedFile& = delete;
+
+  /// Maps the file read only. Returns false when the file could not be opened or mapped, empty files are not mapped.
+  bool open(std::string const& filePath);
+  /// Creates (or truncates) the file of the size and maps it for reading and writing.
+  /// The file is sparse where the filesystem allows it, the disk space is taken by written pages only.
+  bool create(std::string const& filePath, size_t size);
+  void close();
+
+  auto data() const -> uint8_t const*
+  {
+    return _data;
+  }
+  /// Only for the files mapped by create
+  auto mutableData() -> uint8_t*
+  {
+    return _data;
+  }
+  auto size() const -> size_t
+  {
+    return _size;
+  }
+  bool isOpen() const
+  {
+    return _data != nullptr;
+  }
+
+private:
+  uint8_t* _data{};
+  size_t _size{};
+#ifdef _WIN32
+  void* _fileHandle{};
+  void* _mappingHandle{};
+#endif
+};
@@ -0,0 +1,78 @@
+#include "MaskRasterizer.hpp"
+
+#include <opencv2/imgproc.hpp>
+
+#include <cmath>
+
+namespace {
+/// Sub pixel precision of fillPoly, vertices keep their fractional part after scaling
+constexpr int fractionalBits = 4;
+constexpr double fractionalScale = 1 << fractionalBits;
+
+auto toTarget(cv::Point2f const& point, MaskRasterizer::Transform const& transform) -> cv::Point
+{
+  return cv::Point(static_cast<int>(std::lround(((point.x * transform.scaleX) - transform.offset.x) * fractionalScale)),
+                   static_cast<int>(std::lround(((point.y * transform.scaleY) - transform.offset.y) * fractionalScale)));
+}
+} /// end namespace anonymous
+
+auto MaskRasterizer::classIndices(std::map<std::string, cv::Scalar> const& colorToClass) -> std::map<std::string, uint8_t>
+{
+  std::map<std::string, uint8_t> indices;
+  uint8_t index = 1;
+  for (auto const& classColor : colorToClass)
+  {
+    indices[classColor.first] = index++;
+  }
+  return indices;
+}
+
+void MaskRasterizer::rasterize(LabelMeAnnotation const& annotation,
+                               std::map<std::string, cv::Scalar> const& colorToClass,
+                               Transform const& transform,
+                               cv::Mat& target)
+{
+  target.setTo(cv::Scalar::all(0));
+  auto const isClassIndex = (target.channels() == 1);
+  auto const indices = isClassIndex ? classIndices(colorToClass) : std::map<std::string, uint8_t>{};
+
+  std::vector<cv::Point> polygon;
+  for (auto const& shape : annotation.shapes)
+  {
+    auto const classColor = colorToClass.find(shape.label);
+    if ((classColor == colorToClass.cend()) || shape.points.empty())
+    {
+      continue;
+    }
+    auto const color = isClassIndex ? cv::Scalar::all(indices.at(shape.label)) : classColor->second;
+
+    /// LabelMe writes polygons with an empty shape_type as well
+    auto const isPolygon = shape.shapeType.empty() || (shape.shapeType == "polygon");
+    /// fillPoly fills spans of every scanline at once, so the cost is proportional to the target area of the shape
+    if (isPolygon && (shape.points.size() >= 3))
+    {
+      polygon.clear();
+      for (auto const& point : shape.points)
+      {
+        polygon.emplace_back(toTarget(point, transform));
+      }
+      cv::fillPoly(target, std::vector<std::vector<cv::Point>>{polygon}, color, cv::LINE_8, fractionalBits);
+    }
+    else if ((shape.shapeType == "rectangle") && (shape.points.size() >= 2))
+    {
+      auto const first = toTarget(shape.points[0], transform);
+      auto const second = toTarget(shape.points[1], transform);
+      polygon = {first, cv::Point(second.x, first.y), second, cv::Point(first.x, second.y)};
+      cv::fillPoly(target, std::vector<std::vector<cv::Point>>{polygon}, color, cv::LINE_8, fractionalBits);
+    }
+    else if ((shape.shapeType == "circle") && (shape.points.size() >= 2))
+    {
+      auto const center = toTarget(shape.points[0], transform);
+      /// The radius is taken in the annotation coordinates, the circle becomes an ellipse when scales differ
+      auto const radius = std::hypot(shape.points[1].x - shape.points[0].x, shape.points[1].y - shape.points[0].y);
+      auto const axes = cv::Size(static_cast<int>(std::lround(radius * transform.scaleX * fractionalScale)),
+                                 static_cast<int>(std::lround(radius * transform.scaleY * fractionalScale)));
+      cv::ellipse(target, center, axes, 0.0, 0.0, 360.0, color, cv::FILLED, cv::LINE_8, fractionalBits);
+    }
+  }
+}
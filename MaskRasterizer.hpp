@@ -0,0 +1,35 @@
+#pragma once
+
+#include "LabelMeReader.hpp"
+
+#include <opencv2/core.hpp>
+
+#include <map>
+#include <string>
+
+/**
+ * Draws "labelme" shapes straight into a caller provided mask at the target resolution, so the full
+ * resolution mask is never built and resized. The target could be a crop of the scaled annotation,
+ * shapes are clipped by the target bounds.
+ * CV_8UC3 targets get class colors (BGR), CV_8UC1 targets get class indices (0 is the background).
+ */
+struct MaskRasterizer
+{
+  struct Transform
+  {
+    /// Target pixels per annotation pixel
+    double scaleX{1.0};
+    double scaleY{1.0};
+    /// Top left corner of the target in the scaled annotation coordinates
+    cv::Point offset;
+  };
+
+  /// Classes are numbered from 1 in the order of names, the same on export and training.
+  static auto classIndices(std::map<std::string, cv::Scalar> const& colorToClass) -> std::map<std::string, uint8_t>;
+
+  /// Unknown labels and shapes without area (lines, points) are skipped. The target is cleared first.
+  static void rasterize(LabelMeAnnotation const& annotation,
+                        std::map<std::string, cv::Scalar> const& colorToClass,
+                        Transform const& transform,
+                        cv::Mat& target);
+};
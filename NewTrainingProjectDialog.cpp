@@ -1,4 +1,6 @@
 #include "NewTrainingProjectDialog.hpp"
+#include "ProjectFile.hpp"
+#include "DatasetProbe.hpp"
 
 #include <QtWidgets>
 
@@ -84,7 +86,7 @@ NewTrainingProjectDialog::NewTrainingProjectDialog(bool isOpen, QWidget *parent)
   }
   else
   {
-    bp::write_json(_projectFileName.toStdString(), _pt);
+    ProjectFile::save(_projectFileName.toStdString(), _pt);
   }
 
   _datasetListWidget = new QListWidget(this);
@@ -107,41 +109,14 @@ NewTrainingProjectDialog::NewTrainingProjectDialog(bool isOpen, QWidget *parent)
       return;
     }
 
-    std::string imagePath;
-    for (auto item : fs::directory_iterator(dir.toStdString()))
+    auto const summary = DatasetProbe::probe(dir.toStdString());
+    auto const& imagePath = summary.imagesDirectoryPath;
+    if (imagePath.empty())
     {
-      auto const fullPath = item.path().string();
-      auto const extention = item.path().filename().extension().string();
-      if (extention == ".json")
-      {
-        try
-        {
-          bp::ptree annotation;
-          bp::read_json(fullPath, annotation);
-          auto imagePathOpt = annotation.get_optional<std::string>("imagePath");
-          if (imagePathOpt.is_initialized())
-          {
-            auto imageDir = QDir(fs::path(fullPath).remove_filename().string().c_str());
-            imagePath = imageDir.cleanPath(imageDir.absoluteFilePath(QString::fromStdString(imagePathOpt.get()))).toStdString();
-            std::replace(imagePath.begin(), imagePath.end(), '\\', '/');
-            auto imageDirPath = imagePath.substr(0, imagePath.find_last_of('/'));
-            imagePath = imageDirPath;
-#if 0 // TODO: Should be deleted after test
-            auto imageDirPath = imagePathOpt.get().substr(0, imagePathOpt.get().find_last_of('\\'));
-            std::replace(imageDirPath.begin(), imageDirPath.end(), '\\', '/');
-            auto const lastSlashPos = fullPath.find_last_of('/');
-            auto const directory = fullPath.substr(0, lastSlashPos + 1);
-            auto imagesRelativeDirectory = QDir::toNativeSeparators(QString::fromStdString(imageDirPath)).toStdString();
-            imagePath = QDir::toNativeSeparators(QString::fromStdString(directory)).toStdString() + imagesRelativeDirectory;
-#endif
-            break;
-          }
-        }
-        catch(bp::json_parser_error const&)
-        {
-          continue;
-        }
-      }
+      QMessageBox msgBox;
+      msgBox.setText(tr("Could not be found \"imagePath\" in %n annotation(s) of the directory!", nullptr, static_cast<int>(summary.probedCount)));
+      msgBox.exec();
+      return;
     }
     if (!appendNewDataset(_pt, imagePath, dir.toStdString()))
     {
@@ -151,8 +126,12 @@ NewTrainingProjectDialog::NewTrainingProjectDialog(bool isOpen, QWidget *parent)
     }
     else
     {
-      bp::write_json(_projectFileName.toStdString(), _pt);
-      new QListWidgetItem(dir, _datasetListWidget);
+      ProjectFile::save(_projectFileName.toStdString(), _pt);
+      auto datasetItem = new QListWidgetItem(dir, _datasetListWidget);
+      datasetItem->setToolTip(tr("%1 annotations, %2 MB, images: %3")
+                              .arg(summary.annotationsCount)
+                              .arg(static_cast<double>(summary.annotationsBytes) / (1024.0 * 1024.0), 0, 'f', 1)
+                              .arg(QString::fromStdString(imagePath)));
     }
   });
 
@@ -162,7 +141,7 @@ NewTrainingProjectDialog::NewTrainingProjectDialog(bool isOpen, QWidget *parent)
     if (_datasetListWidget->currentRow() != -1)
     {
       removeSelectedDataset(_pt, _datasetListWidget->currentItem()->text().toStdString());
-      boost::property_tree::write_json(_projectFileName.toStdString(), _pt);
+      ProjectFile::save(_projectFileName.toStdString(), _pt);
       qDeleteAll(_datasetListWidget->selectedItems());
     }
   });
@@ -1,11 +1,15 @@
 #include "OpenDatasetsDialog.hpp"
 #include "StartTrainingDialog.hpp"
 #include "ProjectFile.hpp"
+#include "LabelStatistics.hpp"
+#include "DatasetIndexWorker.hpp"
+#include "DatasetIndexCache.hpp"
+#include "DatasetTableModel.hpp"
+#include "ProjectWorkflow.hpp"
+#include "TiledImageView.hpp"
 
 #include <opencv2/opencv.hpp>
 
-#include <UNet/TrainUnet2D.hpp>
-
 #include <QtWidgets>
 
 #include <boost/property_tree/ptree.hpp>
@@ -24,52 +28,7 @@ namespace fs = std::experimental::filesystem;
 
 namespace bp = boost::property_tree;
 
-namespace std {
-template<>
-struct less<cv::Vec3b>
-{
-  bool operator()(::cv::Vec3b const& a, ::cv::Vec3b const& b) const
-  {
-    return std::tie(a[0], a[1], a[2]) < std::tie(b[0], b[1], b[2]);
-  }
-};
-}
-
 namespace {
-auto calculateLabels(std::set<cv::Vec3b>& colorSet, std::string const& labelsFile) -> std::map<cv::Vec3b, std::vector<cv::Rect>>
-{
-  cv::Mat labelsImage = cv::imread(labelsFile);
-  cv::imshow("some", labelsImage);
-  cv::waitKey(1);
-  for (auto r = 0; r < labelsImage.rows; ++r)
-  {
-    auto ptr = labelsImage.ptr<cv::Vec3b>(r);
-    for(int c = 0; c < labelsImage.cols; c++)
-    {
-      if (colorSet.count(ptr[c]) == 0)
-      {
-        colorSet.insert(ptr[c]);
-      }
-    }
-  }
-  std::map<cv::Vec3b, std::vector<cv::Rect>> labels;
-  for(auto const& color : colorSet)
-  {
-    cv::Mat currentMask;
-    cv::inRange(labelsImage, color, color, currentMask);
-
-    std::vector<std::vector<cv::Point>> contours;
-    std::vector<cv::Vec4i> hierarchy;
-    cv::findContours(currentMask, contours, hierarchy, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
-    labels[color] = std::vector<cv::Rect>(contours.size());
-    for (auto j = 0; j < contours.size(); ++j)
-    {
-      labels[color][j] = cv::boundingRect(contours[j]);
-    }
-  }
-  return labels;
-}
-
 enum { absoluteFileNameRole = Qt::UserRole + 1 };
 
 QString fileNameOfItem(const QTableWidgetItem *item)
@@ -88,35 +47,28 @@ OpenDatasetsDialog::OpenDatasetsDialog(std::string const& projectFile, QWidget*
 {
    setWindowTitle(tr("Open datasets dialog"));
 
-   _unet = std::make_unique<UNet>("/home/oleksandr/WORK/09_05_2021/unet_training_tool/unet_3c1cl3l8f.cfg",
-                                  "/home/oleksandr/WORK/09_05_2021/unet_training_tool/checkpoints_3c1cl3l8f/best_28.weights",
-                                  cv::Size{8, 8},
-                                  std::vector<float>{0.99},
-                                  true);
    _projectFile = projectFile;
+   _projectSaver = std::make_unique<ProjectSaver>(_projectFile, _pt);
 
-   labelsTable = new QTableWidget(0, 3);
+   _datasetModel = new DatasetTableModel(this);
+   labelsTable = new QTableView(this);
+   labelsTable->setModel(_datasetModel);
    labelsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
-
-   QStringList labels;
-   labels << tr("Added") << tr("Filename") << tr("Size");
-   labelsTable->setHorizontalHeaderLabels(labels);
    labelsTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
    labelsTable->verticalHeader()->hide();
+   labelsTable->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
    labelsTable->setShowGrid(false);
    labelsTable->setContextMenuPolicy(Qt::CustomContextMenu);
-   connect(labelsTable, &QTableWidget::currentCellChanged, this, &OpenDatasetsDialog::openDatasetItem);
-
-   _labelsViewLabel = new QLabel(this);
-   _scrollArea = new QScrollArea(this);
+   connect(labelsTable->selectionModel(), &QItemSelectionModel::currentRowChanged, [this](QModelIndex const& current, QModelIndex const&) {
+     openDatasetItem(current.row());
+   });
 
-   _labelsViewLabel->setBackgroundRole(QPalette::Base);
-   _labelsViewLabel->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
-   _labelsViewLabel->setScaledContents(true);
+   _imageView = new TiledImageView(this);
 
-   _scrollArea->setBackgroundRole(QPalette::Dark);
-   _scrollArea->setWidget(_labelsViewLabel);
-   _scrollArea->setVisible(true);
+   /// Rendered on the service threads, shown on the GUI thread; queued calls are dropped with the dialog
+   _previewService = std::make_unique<PreviewService>([this](std::string const& imagePath, Preview const& preview) {
+     QMetaObject::invokeMethod(this, [this, imagePath, preview]() { showPreview(imagePath, preview); }, Qt::QueuedConnection);
+   });
 
    classCountTable = new QTableWidget(0, 4);
    QStringList classCountTableLabels;
@@ -151,30 +103,43 @@ OpenDatasetsDialog::OpenDatasetsDialog(std::string const& projectFile, QWidget*
 
    _startTrainingButton = new QPushButton(tr("&Start training..."), this);
    connect(_startTrainingButton, &QAbstractButton::clicked, [this](){
+     _projectSaver->flush();
      auto startTrainingDialog = new StartTrainingDialog(_projectFile, this);
      startTrainingDialog->exec();
+     /// The training dialog has saved its own changes, ROI settings for example
+     bp::read_json(_projectFile, _pt);
+     updatePreviewSettings();
+   });
+
+   _exportSplitButton = new QPushButton(tr("&Export split by class..."), this);
+   connect(_exportSplitButton, &QAbstractButton::clicked, [this](){
+     exportSplit();
    });
 
    auto mainLayout = new QGridLayout(this);
    mainLayout->addWidget(labelsTable, 0, 0);
    mainLayout->addWidget(classCountTable, 1, 0);
-   mainLayout->addWidget(_startTrainingButton, 2, 0);
-   mainLayout->addWidget(_scrollArea, 0, 1, 3, 1);
+   mainLayout->addWidget(_exportSplitButton, 2, 0);
+   mainLayout->addWidget(_startTrainingButton, 3, 0);
+   mainLayout->addWidget(_imageView, 0, 1, 4, 1);
 
    connect(new QShortcut(QKeySequence::Quit, this), &QShortcut::activated, qApp, &QApplication::quit);
 
    resize(QGuiApplication::primaryScreen()->availableSize() * 3 / 5);
-   openViewer(projectFile);
    boost::property_tree::read_json(_projectFile, _pt);
    _classesToColorsMap = ProjectFile::loadColors(_pt);
-   for (int i = 0; i < classCountTable->rowCount(); ++i)
-   {
-     cv::Scalar color = _classesToColorsMap[classCountTable->item(i, 2)->text().toStdString()];
-     classCountTable->item(i, 1)->setBackground(QColor(color[2], color[1], color[0]));
-   }
+   updatePreviewSettings();
+   openViewer(projectFile);
    //updateColorMaps();
 }
 
+OpenDatasetsDialog::~OpenDatasetsDialog()
+{
+  stopIndexing();
+  /// Joins the render threads before the members their callback touches are gone
+  _previewService.reset();
+}
+
 void OpenDatasetsDialog::updateColorMaps()
 {
   _classesToColorsMap.clear();
@@ -185,28 +150,180 @@ void OpenDatasetsDialog::updateColorMaps()
     _classesToColorsMap[className] = cv::Scalar(color.blue(), color.green(), color.red());
   }
   ProjectFile::saveColors(_pt, _classesToColorsMap);
-  bp::write_json(_projectFile, _pt);
-  if ((labelsTable->currentRow() >= 0) && (labelsTable->currentRow() < labelsTable->rowCount()))
+  _projectSaver->scheduleSave();
+  updatePreviewSettings();
+  if (labelsTable->currentIndex().isValid())
   {
-    openDatasetItem(labelsTable->currentRow(), 0, 0, 0);
+    openDatasetItem(labelsTable->currentIndex().row());
   }
 }
 
 void OpenDatasetsDialog::openViewer(std::string const& projectFile)
 {
-  labelsTable->setRowCount(0);
+  stopIndexing();
+  _datasetModel->clear();
   classCountTable->setRowCount(0);
+  _allLabels.clear();
+  _allLabelsByName.clear();
+  _wrongAnnotations.clear();
 
-  std::map<cv::Vec3b, std::vector<cv::Rect>> allLabels;
-  std::map<std::string, uint32_t> allLabelsByName;
-  std::set<cv::Vec3b> colorSet;
-
+  std::vector<std::pair<std::string, std::string>> datasets;
+  _projectSaver->flush();
   bp::read_json(projectFile, _pt);
   ProjectFile::iterateOverDatasets(_pt, [&](std::string const& imagesDirercoryPath, std::string const& labelsDirectoryPath) {
-    openCurrentDataset(imagesDirercoryPath, labelsDirectoryPath, allLabels, allLabelsByName, colorSet);
+    datasets.emplace_back(imagesDirercoryPath, labelsDirectoryPath);
   });
 
-  for (auto const& classLabels : allLabels)
+  _indexProgressDialog = new QProgressDialog(this);
+  _indexProgressDialog->setAttribute(Qt::WA_DeleteOnClose);
+  _indexProgressDialog->setCancelButtonText(tr("&Cancel"));
+  _indexProgressDialog->setRange(0, 0);
+  _indexProgressDialog->setWindowTitle(tr("Counting labels"));
+  _indexProgressDialog->setAutoClose(false);
+  _indexProgressDialog->setAutoReset(false);
+
+  _indexThread = new QThread(this);
+  _indexWorker = new DatasetIndexWorker(std::move(datasets),
+                                        DatasetIndexCache::indexFilePathForProject(projectFile),
+                                        _pt.get<bool>("index.contentHash", false),
+                                        _datasetModel->generation());
+  _indexWorker->moveToThread(_indexThread);
+  connect(_indexThread, &QThread::started, _indexWorker, &DatasetIndexWorker::run);
+  connect(_indexThread, &QThread::finished, _indexWorker, &QObject::deleteLater);
+  connect(_indexWorker, &DatasetIndexWorker::samplesCounted, _indexProgressDialog, &QProgressDialog::setMaximum);
+  connect(_indexWorker, &DatasetIndexWorker::batchReady, this, &OpenDatasetsDialog::appendIndexedSamples);
+  connect(_indexWorker, &DatasetIndexWorker::finished, this, &OpenDatasetsDialog::finishIndexing);
+  auto indexWorker = _indexWorker;
+  connect(_indexProgressDialog, &QProgressDialog::canceled, indexWorker, [indexWorker]() {
+    indexWorker->cancel();
+  }, Qt::DirectConnection);
+  _indexProgressDialog->show();
+  _indexThread->start();
+}
+
+void OpenDatasetsDialog::exportSplit()
+{
+  if (_indexThread != nullptr)
+  {
+    QMessageBox msgBox;
+    msgBox.setText("Datasets are being indexed, the split could be exported after indexing!");
+    msgBox.exec();
+    return;
+  }
+  auto dir = QFileDialog::getExistingDirectory(this, tr("Open directory for saving split dataset"),
+                                               ".",
+                                               QFileDialog::ShowDirsOnly | QFileDialog::DontResolveSymlinks);
+  if (dir.isEmpty())
+  {
+    return;
+  }
+
+  QProgressDialog progressDialog(this);
+  progressDialog.setCancelButtonText(tr("&Cancel"));
+  progressDialog.setWindowTitle(tr("Exporting split dataset"));
+  SplitExportOptions exportOptions;
+  exportOptions.outputDirectoryPath = dir.toStdString();
+  std::atomic<bool> isCanceled{false};
+  auto result = ProjectWorkflow::exportSplit(_pt,
+                                             DatasetIndexCache::indexFilePathForProject(_projectFile),
+                                             exportOptions,
+                                             isCanceled,
+                                             [&](size_t processed, size_t total) {
+                                               progressDialog.setMaximum(static_cast<int>(total));
+                                               progressDialog.setValue(static_cast<int>(processed));
+                                               progressDialog.setLabelText(tr("Exported sample %1 of %n ...", nullptr, static_cast<int>(total)).arg(processed));
+                                               QCoreApplication::processEvents();
+                                               isCanceled = progressDialog.wasCanceled();
+                                             });
+  progressDialog.close();
+  if (!result.failedAnnotations.empty())
+  {
+    std::string text = "Could not be exported the following annotation files:";
+    for (auto const& failedAnnotation : result.failedAnnotations)
+    {
+      text += "\n" + failedAnnotation;
+    }
+    QMessageBox msgBox;
+    msgBox.setText(QString::fromStdString(text));
+    msgBox.exec();
+  }
+}
+
+void OpenDatasetsDialog::stopIndexing()
+{
+  if (_indexThread == nullptr)
+  {
+    return;
+  }
+  _indexWorker->cancel();
+  _indexThread->quit();
+  _indexThread->wait();
+  _indexThread->deleteLater();
+  _indexThread = nullptr;
+  _indexWorker = nullptr;
+  if (_indexProgressDialog != nullptr)
+  {
+    _indexProgressDialog->close();
+    _indexProgressDialog = nullptr;
+  }
+}
+
+void OpenDatasetsDialog::appendIndexedSamples(std::vector<DatasetSample> const& samples, quint64 generation)
+{
+  /// Batches queued by a stopped indexing belong to the cleared list
+  if (!_datasetModel->append(samples, generation))
+  {
+    return;
+  }
+  for (auto const& sample : samples)
+  {
+    if (!sample.isValid)
+    {
+      _wrongAnnotations.emplace_back(sample.annotationPath);
+      continue;
+    }
+    for (auto const& classLabels : sample.labelsByName)
+    {
+      _allLabelsByName[classLabels.first] += classLabels.second;
+    }
+    for (auto const& rects : sample.maskStatistics.boundingBoxes)
+    {
+      _allLabels[rects.first].insert(_allLabels[rects.first].end(), rects.second.cbegin(), rects.second.cend());
+    }
+  }
+  if (_indexProgressDialog != nullptr)
+  {
+    auto const processed = _indexProgressDialog->value() + static_cast<int>(samples.size());
+    _indexProgressDialog->setValue(processed);
+    _indexProgressDialog->setLabelText(tr("Processed label number %1 of %n...", nullptr, _indexProgressDialog->maximum()).arg(processed));
+  }
+}
+
+void OpenDatasetsDialog::finishIndexing(bool, quint64 generation)
+{
+  if (generation != _datasetModel->generation())
+  {
+    return;
+  }
+  stopIndexing();
+  updateClassCountTable();
+  if (!_wrongAnnotations.empty())
+  {
+    std::string text = "The following files are wrong:";
+    for (auto const& wrongAnnotation : _wrongAnnotations)
+    {
+      text += "\n" + wrongAnnotation;
+    }
+    QMessageBox msgBox;
+    msgBox.setText(QString::fromStdString(text));
+    msgBox.exec();
+  }
+}
+
+void OpenDatasetsDialog::updateClassCountTable()
+{
+  classCountTable->setRowCount(0);
+  for (auto const& classLabels : _allLabels)
   {
     auto classNameItem = new QTableWidgetItem(QString::fromStdString(std::to_string(classLabels.first[0]) + " " +
                                                                                   std::to_string(classLabels.first[1]) + " " +
@@ -233,7 +350,7 @@ void OpenDatasetsDialog::openViewer(std::string const& projectFile)
     classCountTable->setItem(row, 3, countItem);
   }
 
-  for (auto const& classLabels : allLabelsByName)
+  for (auto const& classLabels : _allLabelsByName)
   {
     auto classNameItem = new QTableWidgetItem(QString::fromStdString(classLabels.first));
     classNameItem->setFlags(classNameItem->flags() ^ Qt::ItemIsEditable);
@@ -257,184 +374,78 @@ void OpenDatasetsDialog::openViewer(std::string const& projectFile)
     classCountTable->setItem(row, 2, classNameItem);
     classCountTable->setItem(row, 3, countItem);
   }
-  //updateColorMaps();
+  for (int i = 0; i < classCountTable->rowCount(); ++i)
+  {
+    auto const colorIt = _classesToColorsMap.find(classCountTable->item(i, 2)->text().toStdString());
+    if (colorIt != _classesToColorsMap.end())
+    {
+      classCountTable->item(i, 1)->setBackground(QColor(colorIt->second[2], colorIt->second[1], colorIt->second[0]));
+    }
+  }
 }
 
-void OpenDatasetsDialog::openCurrentDataset(std::string const& imagesDirectoryPath,
-                                            std::string const& labelsDirectoryPath,
-                                            std::map<cv::Vec3b, std::vector<cv::Rect>>& allLabels,
-                                            std::map<std::string, uint32_t>& allLabelsByName,
-                                            std::set<cv::Vec3b>& colorSet)
+void OpenDatasetsDialog::updatePreviewSettings()
 {
-   auto imagesDirectoryPathCopy = imagesDirectoryPath;
-   std::replace(imagesDirectoryPathCopy.begin(), imagesDirectoryPathCopy.end(), '\\', '/');
-   auto lastSlash = imagesDirectoryPathCopy.find_last_of("/");
-   auto imagesDirectoryPathFixed = fs::path(imagesDirectoryPath).is_absolute() ? imagesDirectoryPath : labelsDirectoryPath + "/" + imagesDirectoryPathCopy.substr(0, lastSlash);
-   std::vector<fs::directory_entry> imageList(fs::directory_iterator{imagesDirectoryPathFixed}, fs::directory_iterator{});
-
-   QProgressDialog progressDialog(this);
-   progressDialog.setCancelButtonText(tr("&Cancel"));
-   progressDialog.setRange(0, imageList.size());
-   progressDialog.setWindowTitle(tr("Counting labels"));
-
-   auto currentLabel = 0;
-   bool splitDataset = true;
-   QString dir = QFileDialog::getExistingDirectory(this, tr("Open directory for saving split dataset"),
-                                                  ".",
-                                                  QFileDialog::ShowDirsOnly | QFileDialog::DontResolveSymlinks);
-   if (dir.isEmpty())
-   {
-     QMessageBox msgBox;
-     msgBox.setText("Folder for saving split dataset was not selected, this operation will be skipped!");
-     msgBox.exec();
-     splitDataset = false;
-     //return;
-   }
-   for (auto const& file : imageList)
-   {
-     auto filename = file.path().filename().string();
-     auto fileext = file.path().extension().string();
-     filename = filename.substr(0,filename.find_last_of('.'));
-     auto testFolderPath = labelsDirectoryPath + "/" + filename + ".json";
-     std::cout << testFolderPath << std::endl;
-     auto res = fs::exists(testFolderPath);
-     if (fs::exists(labelsDirectoryPath + "/" + filename + fileext))
-     {
-       _dataset.emplace_back(file.path().string(), labelsDirectoryPath + "/" + filename + fileext);
-       auto currentLabels = calculateLabels(colorSet, _dataset.back().second);
-       for (auto const& rects : currentLabels)
-       {
-         allLabels[rects.first].insert(allLabels[rects.first].end(), rects.second.cbegin(), rects.second.cend());
-       }
-     }
-     else if (fs::exists(labelsDirectoryPath + "/" + filename + ".json"))
-     {
-       _dataset.emplace_back(file.path().string(), labelsDirectoryPath + "/" + filename + ".json");
-       LabelMeDeleteImage(_dataset.back().second);
-       ////
-       std::string const splitDir = dir.toStdString();
-       std::map<std::string, uint32_t> classesExist;
-       if (!CountingLabeledObjects(classesExist, _dataset.back().second, true))
-       {
-         QMessageBox msgBox;
-         msgBox.setText(QString::fromStdString(std::string("The file: ") + labelsDirectoryPath + "/" + filename + ".json" + "is wrong!"));
-         msgBox.exec();
-         continue;
-       }
-       for (auto const& classExist : classesExist)
-       {
-         if (splitDataset)
-         {
-             fs::create_directories(splitDir + "/" + classExist.first + "/images");
-             fs::create_directories(splitDir + "/" + classExist.first + "/data");
-         }
-         if (classesExist.find("trash") != classesExist.end())
-         {
-           if (splitDataset)
-           {
-               fs::copy(_dataset.back().first, splitDir + "/" + "trash" + "/images");
-               fs::copy(_dataset.back().second, splitDir + "/" + "trash" + "/data");
-               bp::ptree ptData;
-               auto const newImagePath = splitDir + "/" + "trash" + "/images/" + fs::path(_dataset.back().first).filename().string();
-               auto const newDataPath = splitDir + "/" + "trash" + "/data/" + fs::path(_dataset.back().second).filename().string();
-               bp::read_json(newDataPath, ptData);
-               ptData.put<std::string>("imagePath", newImagePath);
-               bp::write_json(newDataPath, ptData);
-           }
-           break;
-         }
-         if (splitDataset)
-         {
-             fs::copy(_dataset.back().first, splitDir + "/" + classExist.first + "/images");
-             fs::copy(_dataset.back().second, splitDir + "/" + classExist.first + "/data");
-             bp::ptree ptData;
-             auto const newImagePath = splitDir + "/" + classExist.first + "/images/" + fs::path(_dataset.back().first).filename().string();
-             auto const newDataPath = splitDir + "/" + classExist.first + "/data/" + fs::path(_dataset.back().second).filename().string();
-             bp::read_json(newDataPath, ptData);
-             ptData.put<std::string>("imagePath", newImagePath);
-             bp::write_json(newDataPath, ptData);
-         }
-       }
-       if (!CountingLabeledObjects(allLabelsByName, _dataset.back().second, true))
-       {
-         QMessageBox msgBox;
-         msgBox.setText(QString::fromStdString(std::string("The file: ") + labelsDirectoryPath + "/" + filename + ".json" + "is wrong!"));
-         msgBox.exec();
-         continue;
-       }
-     }
-     else
-     {
-         continue;
-     }
-     auto filePathQ = QString::fromStdString(_dataset.back().first);
-     const QString toolTip = QDir::toNativeSeparators(filePathQ);
-     const QString relativePath = QDir::toNativeSeparators(currentDir.relativeFilePath(filePathQ));
-     const qint64 size = QFileInfo(filePathQ).size();
-     auto addedItem = new QTableWidgetItem(tr("Added"));
-     addedItem->setFlags(addedItem->flags() | Qt::ItemIsUserCheckable);
-     addedItem->setCheckState(Qt::Checked);
-     auto fileNameItem = new QTableWidgetItem(relativePath);
-     fileNameItem->setData(absoluteFileNameRole, QVariant(filePathQ));
-     fileNameItem->setToolTip(toolTip);
-     fileNameItem->setFlags(fileNameItem->flags() ^ Qt::ItemIsEditable);
-     auto sizeItem = new QTableWidgetItem(QString::fromStdString(std::to_string(size)));
-     sizeItem->setData(absoluteFileNameRole, QVariant(filePathQ));
-     sizeItem->setToolTip(toolTip);
-     sizeItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-     sizeItem->setFlags(sizeItem->flags() ^ Qt::ItemIsEditable);
-     int row = labelsTable->rowCount();
-     labelsTable->insertRow(row);
-     labelsTable->setItem(row, 0, addedItem);
-     labelsTable->setItem(row, 1, fileNameItem);
-     labelsTable->setItem(row, 2, sizeItem);
-
-     progressDialog.setValue(currentLabel);
-     progressDialog.setLabelText(tr("Processed label number %1 of %n...", nullptr, imageList.size()).arg(currentLabel++));
-     QCoreApplication::processEvents();
-
-     if (progressDialog.wasCanceled())
-     {
-       break;
-     }
-   }
+  _previewSettings.colorToClass = _classesToColorsMap;
+  _previewSettings.roiDetectorOptions = ProjectFile::loadRoiDetectorOptions(_pt);
+  auto const viewportSize = _imageView->size() * _imageView->devicePixelRatioF();
+  _previewSettings.displaySize = cv::Size(viewportSize.width(), viewportSize.height());
+  _previewService->setSettings(_previewSettings);
 }
 
-void OpenDatasetsDialog::openDatasetItem(int row, int, int, int)
+void OpenDatasetsDialog::openDatasetItem(int row)
 {
-  cv::Mat frame = cv::imread(_dataset[row].first, cv::IMREAD_COLOR);
-  auto extention = _dataset[row].second.substr(_dataset[row].second.find_last_of('.') + 1);
-  cv::Mat labelsImage = (extention == "json") ? ConvertPolygonsToMask(_dataset[row].second, _classesToColorsMap) : cv::imread(_dataset[row].second);
-  if (labelsImage.empty())
+  if ((row < 0) || (row >= _datasetModel->rowCount()))
   {
-    QMessageBox msgBox;
-    msgBox.setText(QString::fromStdString(std::string("Something wrong with annotation: ") + _dataset[row].second));
-    msgBox.exec();
+    return;
   }
-  else
+  /// Previews made for a smaller viewer would be upscaled, a shrunk viewer still shows them fine
+  auto const viewportSize = _imageView->size() * _imageView->devicePixelRatioF();
+  if ((viewportSize.width() > _previewSettings.displaySize.width) || (viewportSize.height() > _previewSettings.displaySize.height))
   {
-    cv::addWeighted(frame, 1.0, labelsImage, 0.5, 0.0, frame);
+    updatePreviewSettings();
   }
-  std::vector<cv::Mat> predictedImages = _unet ? _unet->performPrediction(frame, [](std::vector<cv::Mat> const&){}, true, false) : std::vector<cv::Mat>{};
-  for (auto const& predictedImage : predictedImages) {
-      cv::imshow("test", predictedImage);
+
+  auto const requestOf = [this](int row) {
+    auto const& datasetItem = _datasetModel->item(row);
+    return PreviewRequest{datasetItem.imagePath, datasetItem.annotationPath, datasetItem.imageSize};
+  };
+  /// Neighbours are rendered while the shown sample is looked at, stepping through the table is instant
+  std::vector<PreviewRequest> prefetched;
+  for (auto const offset : {1, -1, 2, -2})
+  {
+    if ((row + offset >= 0) && (row + offset < _datasetModel->rowCount()))
+    {
+      prefetched.emplace_back(requestOf(row + offset));
+    }
   }
-  cv::waitKey(1);
-  cv::Rect unionBox;
-  auto boundingBoxesAll = UNet::foundBoundingBoxes(predictedImages);
-  for (auto& boundingBoxesClass : boundingBoxesAll) {
-      std::sort(boundingBoxesClass.begin(), boundingBoxesClass.end(), [](auto& a, auto& b){
-          return a.area() > b.area();
-      });
-      for(auto const& boundingBox : boundingBoxesClass) {
-          unionBox |= boundingBox;
-          break;
-      }
+  _previewService->request(requestOf(row), prefetched);
+}
+
+void OpenDatasetsDialog::showPreview(std::string const& imagePath, Preview const& preview)
+{
+  auto const row = labelsTable->currentIndex().row();
+  if ((row < 0) || (row >= _datasetModel->rowCount()) || (_datasetModel->item(row).imagePath != imagePath))
+  {
+    return;
+  }
+  if (!preview.isAnnotationValid)
+  {
+    QMessageBox msgBox;
+    msgBox.setText(QString::fromStdString(std::string("Something wrong with annotation: ") + _datasetModel->item(row).annotationPath));
+    msgBox.exec();
   }
-  cv::rectangle(frame, unionBox, cv::Scalar(255, 255, 255), 4);
-  image = QImage((uchar*)frame.data, frame.cols, frame.rows, frame.step, QImage::Format_BGR888);
-  _labelsViewLabel->setPixmap(QPixmap::fromImage(image)/*.scaled(_labelsViewLabel->width(), _labelsViewLabel->height(), Qt::KeepAspectRatio)*/);
-  _labelsViewLabel->adjustSize();
+  if (preview.frame.empty())
+  {
+    return;
+  }
+  /// The preview is the overview, zoomed in parts are rendered from the pyramid of the full resolution image
+  auto overview = QImage(preview.frame.data, preview.frame.cols, preview.frame.rows, static_cast<int>(preview.frame.step), QImage::Format_BGR888).copy();
+  auto pyramid = std::make_shared<ImagePyramid>(imagePath, preview.imageSize,
+                                                std::vector<PyramidLayer>{PyramidLayer{_datasetModel->item(row).annotationPath, 0.5}},
+                                                _previewSettings.colorToClass);
+  auto const roi = QRect(preview.roi.x, preview.roi.y, preview.roi.width, preview.roi.height);
+  _imageView->setImage(std::move(overview), std::move(pyramid), roi);
 }
 
 void OpenDatasetsDialog::createDatasetLists()
@@ -443,23 +454,19 @@ void OpenDatasetsDialog::createDatasetLists()
    auto masksList = std::ofstream("masks.txt");
    auto ignoredImgsList = std::ofstream("ignoredImgs.txt");
    auto ignoredMasksList = std::ofstream("ignoredMasks.txt");
-   int rowCount = labelsTable->rowCount();
+   int rowCount = _datasetModel->rowCount();
    for (auto i = 0; i < rowCount; ++i)
    {
-      QTableWidgetItem* pItem(labelsTable->item(i, 0));
-      if (pItem)
+      auto const& datasetItem = _datasetModel->item(i);
+      if (datasetItem.isAdded)
       {
-         Qt::CheckState st = pItem->checkState();
-         if (st == Qt::CheckState::Checked)
-         {
-            imgsList << _dataset[i].first << std::endl;
-            masksList << _dataset[i].second << std::endl;
-         }
-         else
-         {
-            ignoredImgsList << _dataset[i].first << std::endl;
-            ignoredMasksList << _dataset[i].second << std::endl;
-         }
+         imgsList << datasetItem.imagePath << std::endl;
+         masksList << datasetItem.annotationPath << std::endl;
+      }
+      else
+      {
+         ignoredImgsList << datasetItem.imagePath << std::endl;
+         ignoredMasksList << datasetItem.annotationPath << std::endl;
       }
    }
 }
\ No newline at end of file
@@ -3,60 +3,78 @@
 #include <QDialog>
 #include <QDir>
 
-#include <opencv_unet/UNet.hpp>
+#include "LabelStatistics.hpp"
+#include "DatasetIndexer.hpp"
+#include "ProjectSaver.hpp"
+#include "PreviewService.hpp"
 
 #include <opencv2/core/types.hpp>
 
 #include <boost/property_tree/ptree.hpp>
 
-#include <set>
 #include <memory>
 
 QT_BEGIN_NAMESPACE
 class QComboBox;
 class QLabel;
 class QPushButton;
+class QProgressDialog;
+class QTableView;
 class QTableWidget;
 class QTableWidgetItem;
-class QScrollArea;
+class QThread;
 QT_END_NAMESPACE
 
+class DatasetIndexWorker;
+class DatasetTableModel;
+class TiledImageView;
+
 class OpenDatasetsDialog : public QDialog
 {
 Q_OBJECT
 
 public:
     OpenDatasetsDialog(std::string const& projectFile, QWidget *parent = nullptr);
+    ~OpenDatasetsDialog() override;
 
 private slots:
     void createDatasetLists();
-    void openDatasetItem(int row, int, int, int);
+    void openDatasetItem(int row);
+    void appendIndexedSamples(std::vector<DatasetSample> const& samples, quint64 generation);
+    void finishIndexing(bool isCanceled, quint64 generation);
 
 private:
     void updateColorMaps();
+    void updateClassCountTable();
     void openViewer(std::string const& projectFile);
-    // TODO: dirty function should be rewritten more clear
-    void openCurrentDataset(std::string const& imagesDirectoryPath,
-                            std::string const& labelsDirectoryPath,
-                            std::map<cv::Vec3b, std::vector<cv::Rect>>& allLabels,
-                            std::map<std::string, uint32_t>& allLabelsByName,
-                            std::set<cv::Vec3b>& colorSet);
+    void stopIndexing();
+    void exportSplit();
+    void updatePreviewSettings();
+    void showPreview(std::string const& imagePath, Preview const& preview);
 
     //QPushButton* _createDatasetButton{};
-    QTableWidget* labelsTable{};
+    QTableView* labelsTable{};
+    DatasetTableModel* _datasetModel{};
     QTableWidget* classCountTable{};
     QDir currentDir;
 
-    QLabel* _labelsViewLabel{};
-    QScrollArea* _scrollArea{};
-    QImage image;
+    TiledImageView* _imageView{};
+    std::unique_ptr<PreviewService> _previewService;
+    PreviewSettings _previewSettings;
 
     std::map<std::string, cv::Scalar> _classesToColorsMap;
-    std::vector<std::pair<std::string, std::string>> _dataset;
+    std::map<cv::Vec3b, std::vector<cv::Rect>> _allLabels;
+    std::map<std::string, uint32_t> _allLabelsByName;
+    std::vector<std::string> _wrongAnnotations;
+
+    QThread* _indexThread{};
+    DatasetIndexWorker* _indexWorker{};
+    QProgressDialog* _indexProgressDialog{};
 
     std::string _projectFile;
     boost::property_tree::ptree _pt;
+    std::unique_ptr<ProjectSaver> _projectSaver;
 
     QPushButton* _startTrainingButton{};
-    std::unique_ptr<UNet> _unet;
+    QPushButton* _exportSplitButton{};
 };
@@ -0,0 +1,258 @@
+#include "PreviewService.hpp"
+#include "LabelMeReader.hpp"
+#include "MaskRasterizer.hpp"
+#include "RoiModelRegistry.hpp"
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+
+namespace {
+/// The biggest of 1/2, 1/4 and 1/8 decoder reductions which keeps the image not smaller than the display
+auto readModeFor(cv::Size imageSize, cv::Size displaySize) -> int
+{
+  if (displaySize.empty() || imageSize.empty())
+  {
+    return cv::IMREAD_COLOR;
+  }
+  auto const scale = std::min(imageSize.width / displaySize.width, imageSize.height / displaySize.height);
+  if (scale >= 8)
+  {
+    return cv::IMREAD_REDUCED_COLOR_8;
+  }
+  if (scale >= 4)
+  {
+    return cv::IMREAD_REDUCED_COLOR_4;
+  }
+  return (scale >= 2) ? cv::IMREAD_REDUCED_COLOR_2 : cv::IMREAD_COLOR;
+}
+
+/// Downscales what the decoder reduction has left above the display size, the aspect ratio is kept
+void fitDisplay(cv::Mat& image, cv::Size displaySize, int interpolation)
+{
+  if (displaySize.empty() || image.empty() || ((image.cols <= displaySize.width) && (image.rows <= displaySize.height)))
+  {
+    return;
+  }
+  auto const scale = std::min(static_cast<double>(displaySize.width) / image.cols, static_cast<double>(displaySize.height) / image.rows);
+  auto const size = cv::Size(std::max(static_cast<int>(image.cols * scale), 1), std::max(static_cast<int>(image.rows * scale), 1));
+  cv::resize(image, image, size, 0.0, 0.0, interpolation);
+}
+} /// end namespace anonymous
+
+PreviewService::PreviewService(ReadyCallback onReady, size_t cacheCapacity, size_t threadsCount)
+  : _onReady(std::move(onReady))
+  , _cacheCapacity(std::max<size_t>(cacheCapacity, 1))
+{
+  for (size_t i = 0; i < std::max<size_t>(threadsCount, 1); ++i)
+  {
+    _threads.emplace_back([this]() { work(); });
+  }
+}
+
+PreviewService::~PreviewService()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _isStopped = true;
+    _queue.clear();
+    for (auto& running : _running)
+    {
+      *running.second = true;
+    }
+  }
+  _hasJobs.notify_all();
+  for (auto& thread : _threads)
+  {
+    thread.join();
+  }
+}
+
+void PreviewService::setSettings(PreviewSettings settings)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _settings = std::move(settings);
+  ++_generation;
+  _queue.clear();
+  for (auto& running : _running)
+  {
+    *running.second = true;
+  }
+  _cache.clear();
+  _lru.clear();
+}
+
+void PreviewService::request(PreviewRequest const& shown, std::vector<PreviewRequest> const& prefetched)
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  _shownImagePath = shown.imagePath;
+
+  std::vector<PreviewRequest> wanted{shown};
+  wanted.insert(wanted.end(), prefetched.cbegin(), prefetched.cend());
+  auto const isWanted = [&wanted](std::string const& imagePath) {
+    return std::any_of(wanted.cbegin(), wanted.cend(), [&imagePath](auto const& request) { return request.imagePath == imagePath; });
+  };
+
+  /// Renders of samples the user has scrolled away from only delay the shown one
+  _queue.erase(std::remove_if(_queue.begin(), _queue.end(), [&isWanted](auto const& job) { return !isWanted(job.request.imagePath); }),
+               _queue.end());
+  for (auto& running : _running)
+  {
+    if (!isWanted(running.first))
+    {
+      *running.second = true;
+    }
+  }
+
+  auto const cached = _cache.find(shown.imagePath);
+  std::optional<Preview> shownPreview;
+  if (cached != _cache.end())
+  {
+    _lru.splice(_lru.begin(), _lru, cached->second.second);
+    shownPreview = cached->second.first;
+  }
+
+  /// The shown sample goes to the front, the neighbours in the given order behind it
+  for (auto request = wanted.crbegin(); request != wanted.crend(); ++request)
+  {
+    auto const queued = std::find_if(_queue.begin(), _queue.end(), [&request](auto const& job) { return job.request.imagePath == request->imagePath; });
+    auto job = (queued != _queue.end()) ? *queued : Job{*request, std::make_shared<std::atomic<bool>>(false), _generation};
+    if (queued != _queue.end())
+    {
+      _queue.erase(queued);
+    }
+    auto const running = _running.equal_range(request->imagePath);
+    auto const isRunning = std::any_of(running.first, running.second, [](auto const& entry) { return !*entry.second; });
+    if (!isRunning && (_cache.count(request->imagePath) == 0))
+    {
+      _queue.push_front(std::move(job));
+    }
+  }
+  lock.unlock();
+  _hasJobs.notify_all();
+
+  if (shownPreview)
+  {
+    _onReady(shown.imagePath, *shownPreview);
+  }
+}
+
+void PreviewService::work()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true)
+  {
+    _hasJobs.wait(lock, [this]() { return _isStopped || !_queue.empty(); });
+    if (_isStopped)
+    {
+      return;
+    }
+    auto job = std::move(_queue.front());
+    _queue.pop_front();
+    auto const running = _running.emplace(job.request.imagePath, job.isCanceled);
+    auto const settings = _settings;
+    lock.unlock();
+
+    auto const preview = render(job.request, settings, *job.isCanceled);
+
+    lock.lock();
+    _running.erase(running);
+    if (*job.isCanceled || (job.generation != _generation))
+    {
+      continue;
+    }
+    storeLocked(job.request.imagePath, preview);
+    if (job.request.imagePath == _shownImagePath)
+    {
+      lock.unlock();
+      _onReady(job.request.imagePath, preview);
+      lock.lock();
+    }
+  }
+}
+
+void PreviewService::storeLocked(std::string const& imagePath, Preview const& preview)
+{
+  auto const cached = _cache.find(imagePath);
+  if (cached != _cache.end())
+  {
+    _lru.erase(cached->second.second);
+    _cache.erase(cached);
+  }
+  _lru.push_front(imagePath);
+  _cache.emplace(imagePath, std::make_pair(preview, _lru.begin()));
+  while (_cache.size() > _cacheCapacity)
+  {
+    _cache.erase(_lru.back());
+    _lru.pop_back();
+  }
+}
+
+auto PreviewService::render(PreviewRequest const& request, PreviewSettings const& settings, std::atomic<bool> const& isCanceled) -> Preview
+{
+  Preview preview;
+  auto const isJson = (request.annotationPath.substr(request.annotationPath.find_last_of('.') + 1) == "json");
+
+  /// The annotation is read first, its image size picks the decoder reduction before the image is touched
+  LabelMeAnnotation annotation;
+  auto const isAnnotationRead = isJson && LabelMeReader::read(request.annotationPath, annotation, LabelMeReader::ImageSize | LabelMeReader::Shapes);
+  preview.imageSize = request.imageSize.empty() ? cv::Size(annotation.imageWidth, annotation.imageHeight) : request.imageSize;
+  auto const readMode = readModeFor(preview.imageSize, settings.displaySize);
+  if (isCanceled)
+  {
+    return preview;
+  }
+  preview.frame = cv::imread(request.imagePath, readMode);
+  if (preview.imageSize.empty())
+  {
+    /// Decoded at full resolution when the size is not known
+    preview.imageSize = preview.frame.size();
+  }
+  fitDisplay(preview.frame, settings.displaySize, cv::INTER_AREA);
+  if (isCanceled || preview.frame.empty())
+  {
+    preview.isAnnotationValid = !preview.frame.empty();
+    return preview;
+  }
+
+  auto roiDetector = settings.roiDetectorOptions ? RoiModelRegistry::instance().detector(*settings.roiDetectorOptions) : nullptr;
+  if (roiDetector)
+  {
+    auto const box = roiDetector->detect(preview.frame);
+    auto const scaleX = static_cast<double>(preview.imageSize.width) / preview.frame.cols;
+    auto const scaleY = static_cast<double>(preview.imageSize.height) / preview.frame.rows;
+    preview.roi = cv::Rect(cv::Point(static_cast<int>(box.x * scaleX), static_cast<int>(box.y * scaleY)),
+                           cv::Point(static_cast<int>(box.br().x * scaleX), static_cast<int>(box.br().y * scaleY)));
+  }
+  if (isCanceled)
+  {
+    return preview;
+  }
+
+  cv::Mat labelsImage;
+  if (isAnnotationRead)
+  {
+    MaskRasterizer::Transform transform;
+    transform.scaleX = (annotation.imageWidth > 0) ? (static_cast<double>(preview.frame.cols) / annotation.imageWidth) : 1.0;
+    transform.scaleY = (annotation.imageHeight > 0) ? (static_cast<double>(preview.frame.rows) / annotation.imageHeight) : 1.0;
+    labelsImage.create(preview.frame.size(), CV_8UC3);
+    MaskRasterizer::rasterize(annotation, settings.colorToClass, transform, labelsImage);
+  }
+  else if (!isJson)
+  {
+    /// Color masks must not be blended across class borders, nearest neighbour keeps the colors exact
+    labelsImage = cv::imread(request.annotationPath, cv::IMREAD_COLOR);
+    if (!labelsImage.empty() && (labelsImage.size() != preview.frame.size()))
+    {
+      cv::resize(labelsImage, labelsImage, preview.frame.size(), 0.0, 0.0, cv::INTER_NEAREST);
+    }
+  }
+
+  preview.isAnnotationValid = !labelsImage.empty();
+  if (preview.isAnnotationValid)
+  {
+    cv::addWeighted(preview.frame, 1.0, labelsImage, 0.5, 0.0, preview.frame);
+  }
+  return preview;
+}
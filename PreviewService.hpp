@@ -0,0 +1,99 @@
+#pragma once
+
+#include "RoiDetector.hpp"
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct PreviewRequest
+{
+  std::string imagePath;
+  std::string annotationPath;
+  /// Full resolution size when known, otherwise it is read from the annotation
+  cv::Size imageSize;
+};
+
+struct PreviewSettings
+{
+  std::map<std::string, cv::Scalar> colorToClass;
+  std::optional<RoiDetectorOptions> roiDetectorOptions;
+  /// Previews are decoded and rendered to fit it, empty means the full resolution
+  cv::Size displaySize;
+};
+
+struct Preview
+{
+  /// BGR frame with the annotation blended over it
+  cv::Mat frame;
+  /// Full resolution size of the image and the ROI in its coordinates, the frame is a scaled down copy
+  cv::Size imageSize;
+  cv::Rect roi;
+  bool isAnnotationValid{true};
+};
+
+/**
+ * Renders dataset previews on worker threads and keeps the recent ones in a small LRU. Every request
+ * names the shown sample and its neighbours: the shown one is rendered first, the neighbours are
+ * prefetched after it, and queued or running renders of samples which are no longer wanted are canceled.
+ * Images are decoded at reduced scale when the display size allows it.
+ */
+class PreviewService
+{
+public:
+  /// Called on a worker thread, or on the requesting thread for a cached preview, only for the shown sample.
+  using ReadyCallback = std::function<void(std::string const& imagePath, Preview const& preview)>;
+
+  explicit PreviewService(ReadyCallback onReady, size_t cacheCapacity = 16, size_t threadsCount = 2);
+  ~PreviewService();
+
+  /// Drops cached previews and pending renders, they have been made with the previous settings.
+  void setSettings(PreviewSettings settings);
+  void request(PreviewRequest const& shown, std::vector<PreviewRequest> const& prefetched);
+
+  /// Decode at reduced scale, ROI, rasterized annotation blended over the frame. Returns early when canceled.
+  static auto render(PreviewRequest const& request, PreviewSettings const& settings, std::atomic<bool> const& isCanceled) -> Preview;
+
+private:
+  struct Job
+  {
+    PreviewRequest request;
+    std::shared_ptr<std::atomic<bool>> isCanceled;
+    uint64_t generation{};
+  };
+
+  void work();
+  void storeLocked(std::string const& imagePath, Preview const& preview);
+
+  ReadyCallback _onReady;
+  size_t _cacheCapacity;
+
+  std::mutex _mutex;
+  std::condition_variable _hasJobs;
+  bool _isStopped{};
+  PreviewSettings _settings;
+  /// Increased by every settings change, renders made with older settings are not cached
+  uint64_t _generation{};
+  std::string _shownImagePath;
+  std::deque<Job> _queue;
+  /// A canceled render could still be finishing when its sample is wanted again and rendered anew
+  std::multimap<std::string, std::shared_ptr<std::atomic<bool>>> _running;
+
+  /// Most recently used first
+  std::list<std::string> _lru;
+  std::unordered_map<std::string, std::pair<Preview, std::list<std::string>::iterator>> _cache;
+
+  std::vector<std::thread> _threads;
+};
@@ -0,0 +1,183 @@
+#include "ProbabilityCache.hpp"
+
+#ifdef _MSC_VER
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <cstring>
+
+namespace {
+constexpr char cacheMagic[8] = {'U', 'N', 'E', 'T', 'P', 'R', 'O', 'B'};
+
+auto alignUp(uint64_t value) -> uint64_t
+{
+  return (value + ProbabilityCacheWriter::payloadAlignment - 1) & ~static_cast<uint64_t>(ProbabilityCacheWriter::payloadAlignment - 1);
+}
+
+auto planeSize(ProbabilityCacheRecord const& record) -> uint64_t
+{
+  return static_cast<uint64_t>(record.rows) * static_cast<uint64_t>(record.cols);
+}
+} /// end namespace anonymous
+
+ProbabilityCacheWriter::ProbabilityCacheWriter(std::string filePath, uint32_t classesCount, std::string key)
+  : _filePath(std::move(filePath))
+  , _classesCount(classesCount)
+  , _key(std::move(key))
+{
+  auto const directoryPath = fs::path(_filePath).parent_path();
+  std::error_code errorCode;
+  if (!directoryPath.empty())
+  {
+    fs::create_directories(directoryPath, errorCode);
+  }
+  _file.open(_filePath, std::ios::binary | std::ios::trunc);
+  /// The header is written again with the index offset on close, until then readers reject the incomplete cache
+  ProbabilityCacheHeader header{};
+  _file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+  _file.write(_key.data(), static_cast<std::streamsize>(_key.size()));
+  _offset = sizeof(header) + _key.size();
+  _isFailed = !_file;
+}
+
+ProbabilityCacheWriter::~ProbabilityCacheWriter()
+{
+  close();
+}
+
+auto ProbabilityCacheWriter::quantize(cv::Mat const& probabilities) -> cv::Mat
+{
+  cv::Mat levels;
+  probabilities.convertTo(levels, CV_8U, 255.0);
+  return levels;
+}
+
+bool ProbabilityCacheWriter::append(ProbabilitySample const& sample)
+{
+  auto const size = sample.labels.size();
+  auto isValid = (sample.labels.type() == CV_8UC1) && (sample.probabilities.size() == _classesCount);
+  for (auto const& plane : sample.probabilities)
+  {
+    isValid = isValid && (plane.type() == CV_8UC1) && (plane.size() == size);
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_isFailed || !_file.is_open() || !isValid)
+  {
+    return false;
+  }
+  ProbabilityCacheRecord record{};
+  record.nameSize = static_cast<uint32_t>(sample.name.size());
+  record.rows = size.height;
+  record.cols = size.width;
+  static char const padding[payloadAlignment] = {};
+  auto writePlane = [&](cv::Mat const& plane) {
+    auto const offset = alignUp(_offset);
+    _file.write(padding, static_cast<std::streamsize>(offset - _offset));
+    for (int y = 0; y < plane.rows; ++y)
+    {
+      _file.write(plane.ptr<char>(y), plane.cols);
+    }
+    _offset = offset + planeSize(record);
+    return offset;
+  };
+  record.offset = writePlane(sample.labels);
+  for (auto const& plane : sample.probabilities)
+  {
+    writePlane(plane);
+  }
+  _file.write(sample.name.data(), static_cast<std::streamsize>(sample.name.size()));
+  _offset += sample.name.size();
+  _records.push_back(record);
+  _isFailed = !_file;
+  return !_isFailed;
+}
+
+bool ProbabilityCacheWriter::close()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!_file.is_open())
+  {
+    return !_isFailed;
+  }
+  auto const indexOffset = alignUp(_offset);
+  static char const padding[payloadAlignment] = {};
+  _file.write(padding, static_cast<std::streamsize>(indexOffset - _offset));
+  _file.write(reinterpret_cast<char const*>(_records.data()), static_cast<std::streamsize>(_records.size() * sizeof(ProbabilityCacheRecord)));
+
+  ProbabilityCacheHeader header{};
+  std::memcpy(header.magic, cacheMagic, sizeof(header.magic));
+  header.version = version;
+  header.recordsCount = static_cast<uint32_t>(_records.size());
+  header.indexOffset = indexOffset;
+  header.classesCount = _classesCount;
+  header.keySize = static_cast<uint32_t>(_key.size());
+  _file.seekp(0);
+  _file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+  _file.close();
+  _isFailed = _file.fail() || _isFailed;
+  return !_isFailed;
+}
+
+bool ProbabilityCacheReader::open(std::string const& filePath)
+{
+  _records = nullptr;
+  _recordsCount = 0;
+  _classesCount = 0;
+  _key.clear();
+  if (!_file.open(filePath) || (_file.size() < sizeof(ProbabilityCacheHeader)))
+  {
+    _file.close();
+    return false;
+  }
+  ProbabilityCacheHeader header;
+  std::memcpy(&header, _file.data(), sizeof(header));
+  if ((std::memcmp(header.magic, cacheMagic, sizeof(header.magic)) != 0) ||
+      (header.version != ProbabilityCacheWriter::version) ||
+      (header.indexOffset < (sizeof(ProbabilityCacheHeader) + header.keySize)) ||
+      ((header.indexOffset % alignof(ProbabilityCacheRecord)) != 0) ||
+      (header.indexOffset + (static_cast<uint64_t>(header.recordsCount) * sizeof(ProbabilityCacheRecord)) > _file.size()))
+  {
+    _file.close();
+    return false;
+  }
+  _key.assign(reinterpret_cast<char const*>(_file.data() + sizeof(ProbabilityCacheHeader)), header.keySize);
+  _classesCount = header.classesCount;
+  _records = reinterpret_cast<ProbabilityCacheRecord const*>(_file.data() + header.indexOffset);
+  _recordsCount = header.recordsCount;
+  return true;
+}
+
+bool ProbabilityCacheReader::read(size_t index, ProbabilitySample& sample) const
+{
+  if (index >= _recordsCount)
+  {
+    return false;
+  }
+  auto const& record = _records[index];
+  auto const size = planeSize(record);
+  auto offset = record.offset;
+  for (size_t i = 0; i <= _classesCount; ++i)
+  {
+    offset = alignUp(offset) + size;
+  }
+  if ((record.rows < 0) || (record.cols < 0) || ((offset + record.nameSize) > _file.size()))
+  {
+    return false;
+  }
+  auto data = const_cast<uint8_t*>(_file.data());
+  sample.name.assign(reinterpret_cast<char const*>(data + offset), record.nameSize);
+  offset = record.offset;
+  sample.labels = cv::Mat(record.rows, record.cols, CV_8UC1, data + offset);
+  sample.probabilities.clear();
+  for (size_t i = 0; i < _classesCount; ++i)
+  {
+    offset = alignUp(offset + size);
+    sample.probabilities.emplace_back(record.rows, record.cols, CV_8UC1, data + offset);
+  }
+  return true;
+}
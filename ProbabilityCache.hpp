@@ -0,0 +1,109 @@
+#pragma once
+
+#include "MappedFile.hpp"
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// Header at the beginning of a probability cache, the key follows it and the index of fixed size records is at indexOffset.
+struct ProbabilityCacheHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t recordsCount;
+  uint64_t indexOffset;
+  uint32_t classesCount;
+  uint32_t keySize;
+};
+static_assert(sizeof(ProbabilityCacheHeader) == 32, "ProbabilityCacheHeader is a part of the file format");
+
+/// Payload at offset is the truth labels and one plane per class (each aligned to ProbabilityCacheWriter::payloadAlignment),
+/// then the name. All planes are rows * cols bytes.
+struct ProbabilityCacheRecord
+{
+  uint64_t offset;
+  uint32_t nameSize;
+  int32_t rows;
+  int32_t cols;
+  uint32_t reserved;
+};
+static_assert(sizeof(ProbabilityCacheRecord) == 24, "ProbabilityCacheRecord is a part of the file format");
+
+struct ProbabilitySample
+{
+  std::string name;
+  /// CV_8UC1 class index per pixel, 0 is the background
+  cv::Mat labels;
+  /// CV_8UC1 per class, the probability quantized to levels 0..255
+  std::vector<cv::Mat> probabilities;
+};
+
+/**
+ * Writes network outputs of a validation run into one file, so thresholds could be chosen later without
+ * running the network again. Probabilities are quantized to 8 bits, the quarter of the float output,
+ * a threshold step of 1/255 is finer than any threshold worth telling apart.
+ * The key identifies the network and the dataset, a cache with another key is stale.
+ */
+class ProbabilityCacheWriter
+{
+public:
+  static constexpr uint32_t version = 1;
+  static constexpr size_t payloadAlignment = 64;
+
+  ProbabilityCacheWriter(std::string filePath, uint32_t classesCount, std::string key);
+  ~ProbabilityCacheWriter();
+
+  /// CV_32FC1 probabilities to levels, rounded to the nearest one.
+  static auto quantize(cv::Mat const& probabilities) -> cv::Mat;
+  /// Thread safe, returns false when the cache could not be written or the planes do not match the classes count.
+  bool append(ProbabilitySample const& sample);
+  /// Writes the index, returns false when the cache is not complete.
+  bool close();
+
+private:
+  std::string _filePath;
+  uint32_t _classesCount;
+  std::string _key;
+  std::mutex _mutex;
+  std::ofstream _file;
+  uint64_t _offset{};
+  std::vector<ProbabilityCacheRecord> _records;
+  bool _isFailed{};
+};
+
+/**
+ * Reads a probability cache through a memory mapping, samples are read only views of the mapping
+ * valid while the reader is open. Reading is thread safe.
+ */
+class ProbabilityCacheReader
+{
+public:
+  /// Returns false when the file is not a complete cache of a known version.
+  bool open(std::string const& filePath);
+  auto key() const -> std::string const&
+  {
+    return _key;
+  }
+  auto classesCount() const -> size_t
+  {
+    return _classesCount;
+  }
+  auto size() const -> size_t
+  {
+    return _recordsCount;
+  }
+  /// Returns false when the record is out of the file.
+  bool read(size_t index, ProbabilitySample& sample) const;
+
+private:
+  MappedFile _file;
+  std::string _key;
+  size_t _classesCount{};
+  ProbabilityCacheRecord const* _records{};
+  size_t _recordsCount{};
+};
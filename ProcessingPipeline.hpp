@@ -0,0 +1,322 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Blocking queue with limited capacity, push waits while the queue is full, so a slow
+ * consumer slows down its producers instead of letting the queue grow.
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+  explicit BoundedQueue(size_t capacity)
+    : _capacity{std::max<size_t>(capacity, 1)}
+  {
+  }
+
+  /// Returns false when the queue is closed.
+  bool push(T&& item)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notFull.wait(lock, [this]() { return _isClosed || (_items.size() < _capacity); });
+    if (_isClosed)
+    {
+      return false;
+    }
+    _items.emplace_back(std::move(item));
+    _notEmpty.notify_one();
+    return true;
+  }
+
+  /// Returns false when the queue is closed and drained.
+  bool pop(T& item)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notEmpty.wait(lock, [this]() { return _isClosed || !_items.empty(); });
+    if (_items.empty())
+    {
+      return false;
+    }
+    item = std::move(_items.front());
+    _items.pop_front();
+    _notFull.notify_one();
+    return true;
+  }
+
+  /// Like pop, but gives up after the timeout; isTimedOut tells it from a closed and drained queue.
+  bool popFor(T& item, std::chrono::milliseconds timeout, bool& isTimedOut)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    isTimedOut = !_notEmpty.wait_for(lock, timeout, [this]() { return _isClosed || !_items.empty(); });
+    if (_items.empty())
+    {
+      return false;
+    }
+    item = std::move(_items.front());
+    _items.pop_front();
+    _notFull.notify_one();
+    return true;
+  }
+
+  void close()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _isClosed = true;
+    _notEmpty.notify_all();
+    _notFull.notify_all();
+  }
+
+private:
+  size_t const _capacity;
+  std::deque<T> _items;
+  std::mutex _mutex;
+  std::condition_variable _notEmpty;
+  std::condition_variable _notFull;
+  bool _isClosed{};
+};
+
+/**
+ * Runs items through a sequence of stages, every stage has its own threads and is connected
+ * with the next one by a bounded queue. Results are passed to the sink on the calling thread
+ * in the input order. The source stays a window of items ahead of the sink, so the results
+ * waiting for a slow item ahead of them are bounded like the queues.
+ */
+template <typename T>
+class ProcessingPipeline
+{
+public:
+  using Stage = std::function<void(T&)>;
+  using BatchStage = std::function<void(std::vector<T*> const&)>;
+  using Sink = std::function<void(T&&)>;
+
+  explicit ProcessingPipeline(size_t queueCapacity)
+    : _queueCapacity{queueCapacity}
+  {
+  }
+
+  void addStage(Stage stage, size_t threadsCount)
+  {
+    _stages.push_back({std::move(stage), {}, std::max<size_t>(threadsCount, 1), 1});
+  }
+
+  /// Runs on a single thread, items are collected until the batch is full or the input is drained.
+  void addBatchStage(BatchStage stage, size_t batchSize)
+  {
+    _stages.push_back({{}, std::move(stage), 1, std::max<size_t>(batchSize, 1)});
+  }
+
+  /// Canceled items are dropped, so the sink could be called for the part of items only; items which are done
+  /// when the run is canceled are dropped as well, the sink does not wait for the gaps.
+  /// An exception of a stage or of the sink stops the pipeline: the queues are closed, the rest of items
+  /// is dropped, every thread is joined and the first exception is rethrown from run.
+  void run(std::vector<T>&& items, std::atomic<bool> const& isCanceled, Sink const& sink)
+  {
+    using Sequenced = std::pair<size_t, T>;
+    std::vector<std::unique_ptr<BoundedQueue<Sequenced>>> queues;
+    for (size_t i = 0; i <= _stages.size(); ++i)
+    {
+      queues.emplace_back(std::make_unique<BoundedQueue<Sequenced>>(_queueCapacity));
+    }
+
+    /// Items done ahead of a slow one wait for it in the reorder buffer of the sink, so the source keeps at most
+    /// window items ahead of the sink, as many as the queues and the stage threads could hold
+    auto window = _queueCapacity * queues.size();
+    for (auto const& stage : _stages)
+    {
+      window += stage.threadsCount * stage.batchSize;
+    }
+    std::mutex windowMutex;
+    std::condition_variable windowMoved;
+    size_t sunkCount = 0;
+    /// A batch stage waiting for more items could hold the one the sink waits for, it sends a partial batch then
+    std::atomic<bool> isWindowFull{false};
+
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    std::atomic<bool> isFailed{false};
+    auto fail = [&](std::exception_ptr exception) {
+      {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error)
+        {
+          error = exception;
+        }
+      }
+      isFailed = true;
+      /// Wakes up every thread waiting on a full or an empty queue or on the window
+      for (auto& queue : queues)
+      {
+        queue->close();
+      }
+      std::lock_guard<std::mutex> lock(windowMutex);
+      windowMoved.notify_all();
+    };
+    auto isStopped = [&]() {
+      return isCanceled || isFailed;
+    };
+
+    std::vector<std::thread> threads;
+    threads.emplace_back([&]() {
+      for (size_t i = 0; (i < items.size()) && !isStopped(); ++i)
+      {
+        {
+          std::unique_lock<std::mutex> lock(windowMutex);
+          /// Cancel is not signaled, so it is polled while waiting
+          while (!isStopped() && (i >= (sunkCount + window)))
+          {
+            isWindowFull = true;
+            windowMoved.wait_for(lock, std::chrono::milliseconds(10));
+          }
+          isWindowFull = false;
+        }
+        if (isStopped() || !queues.front()->push(Sequenced{i, std::move(items[i])}))
+        {
+          break;
+        }
+      }
+      queues.front()->close();
+    });
+
+    std::vector<std::unique_ptr<std::atomic<size_t>>> activeThreads;
+    for (auto const& stage : _stages)
+    {
+      activeThreads.emplace_back(std::make_unique<std::atomic<size_t>>(stage.threadsCount));
+    }
+    for (size_t stageIndex = 0; stageIndex < _stages.size(); ++stageIndex)
+    {
+      for (size_t t = 0; t < _stages[stageIndex].threadsCount; ++t)
+      {
+        threads.emplace_back([&, stageIndex]() {
+          auto const& stage = _stages[stageIndex];
+          auto& input = *queues[stageIndex];
+          auto& output = *queues[stageIndex + 1];
+          std::vector<Sequenced> batch;
+          bool isDrained = false;
+          while (!isDrained)
+          {
+            batch.clear();
+            Sequenced item;
+            while (batch.size() < stage.batchSize)
+            {
+              bool isTimedOut = false;
+              auto const isPopped = batch.empty() ? input.pop(item) : input.popFor(item, std::chrono::milliseconds(10), isTimedOut);
+              if (isTimedOut)
+              {
+                if (isWindowFull)
+                {
+                  break;
+                }
+                continue;
+              }
+              if (!isPopped)
+              {
+                isDrained = true;
+                break;
+              }
+              if (!isStopped())
+              {
+                batch.emplace_back(std::move(item));
+              }
+            }
+            if (batch.empty())
+            {
+              continue;
+            }
+            try
+            {
+              if (stage.processBatch)
+              {
+                std::vector<T*> batchItems;
+                for (auto& batchItem : batch)
+                {
+                  batchItems.push_back(&batchItem.second);
+                }
+                stage.processBatch(batchItems);
+              }
+              else
+              {
+                stage.process(batch.front().second);
+              }
+            }
+            catch (...)
+            {
+              fail(std::current_exception());
+              continue;
+            }
+            for (auto& batchItem : batch)
+            {
+              output.push(std::move(batchItem));
+            }
+          }
+          if (--(*activeThreads[stageIndex]) == 0)
+          {
+            output.close();
+          }
+        });
+      }
+    }
+
+    std::map<size_t, T> reorderBuffer;
+    size_t nextIndex = 0;
+    Sequenced item;
+    while (queues.back()->pop(item))
+    {
+      if (isStopped())
+      {
+        /// Dropped items leave gaps which are never filled
+        reorderBuffer.clear();
+        continue;
+      }
+      reorderBuffer.emplace(item.first, std::move(item.second));
+      try
+      {
+        for (auto it = reorderBuffer.find(nextIndex); it != reorderBuffer.end(); it = reorderBuffer.find(++nextIndex))
+        {
+          sink(std::move(it->second));
+          reorderBuffer.erase(it);
+        }
+      }
+      catch (...)
+      {
+        fail(std::current_exception());
+      }
+      std::lock_guard<std::mutex> lock(windowMutex);
+      sunkCount = nextIndex;
+      windowMoved.notify_one();
+    }
+
+    for (auto& thread : threads)
+    {
+      thread.join();
+    }
+    if (error)
+    {
+      std::rethrow_exception(error);
+    }
+  }
+
+private:
+  struct StageInfo
+  {
+    Stage process;
+    BatchStage processBatch;
+    size_t threadsCount;
+    size_t batchSize;
+  };
+
+  size_t _queueCapacity;
+  std::vector<StageInfo> _stages;
+};
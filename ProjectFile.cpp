@@ -1,11 +1,49 @@
 #include "ProjectFile.hpp"
 
 #include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#ifdef _MSC_VER
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <fstream>
 #include <optional>
 #include <map>
 #include <string>
 
-auto ProjectFile::loadColors(boost::property_tree::ptree& tree) -> std::map<std::string, cv::Scalar>
+bool ProjectFile::save(std::string const& projectFile, boost::property_tree::ptree const& tree)
+{
+  auto const temporaryFilePath = projectFile + ".tmp";
+  {
+    std::ofstream file(temporaryFilePath, std::ios::trunc);
+    if (!file)
+    {
+      return false;
+    }
+    try
+    {
+      bp::write_json(file, tree);
+    }
+    catch (bp::json_parser_error const&)
+    {
+      return false;
+    }
+    if (!file.flush())
+    {
+      return false;
+    }
+  }
+  std::error_code errorCode;
+  fs::rename(temporaryFilePath, projectFile, errorCode);
+  return !errorCode;
+}
+
+auto ProjectFile::loadColors(boost::property_tree::ptree const& tree) -> std::map<std::string, cv::Scalar>
 {
   std::map<std::string, cv::Scalar> classesColors;
   auto datasets = tree.get_child_optional("classesColorsMap");
@@ -38,7 +76,37 @@ void ProjectFile::saveColors(boost::property_tree::ptree& tree, const std::map<s
   }
 }
 
-void ProjectFile::iterateOverDatasets(boost::property_tree::ptree& pt,
+auto ProjectFile::loadClassSettings(boost::property_tree::ptree const& tree) -> std::map<std::string, ClassSettings>
+{
+  std::map<std::string, ClassSettings> settings;
+  auto items = tree.get_child_optional("classSettings");
+  if (items.is_initialized())
+  {
+    for (auto const& item : items.get())
+    {
+      auto& classSettings = settings[item.second.get<std::string>("className")];
+      classSettings.threshold = item.second.get<float>("threshold", classSettings.threshold);
+      classSettings.weight = item.second.get<float>("weight", classSettings.weight);
+    }
+  }
+  return settings;
+}
+
+void ProjectFile::saveClassSettings(boost::property_tree::ptree& tree, std::map<std::string, ClassSettings> const& settings)
+{
+  bp::ptree items;
+  for (auto const& item : settings)
+  {
+    bp::ptree classSettingsItem;
+    classSettingsItem.put("className", item.first);
+    classSettingsItem.put("threshold", item.second.threshold);
+    classSettingsItem.put("weight", item.second.weight);
+    items.push_back(bp::ptree::value_type("", classSettingsItem));
+  }
+  tree.put_child("classSettings", items);
+}
+
+void ProjectFile::iterateOverDatasets(boost::property_tree::ptree const& pt,
                                       std::function<void(const std::string&, const std::string&)>&& cb)
 {
   auto datasets = pt.get_child_optional("datasets");
@@ -59,3 +127,77 @@ void ProjectFile::iterateOverDatasets(boost::property_tree::ptree& pt,
     }
   }
 }
+
+auto ProjectFile::loadRoiDetectorOptions(boost::property_tree::ptree const& tree) -> std::optional<RoiDetectorOptions>
+{
+  if (!tree.get<bool>("ROI.enabled", false))
+  {
+    return std::nullopt;
+  }
+  RoiDetectorOptions options;
+  options.modelFilePath = tree.get<std::string>("ROI.modelFilePath", "");
+  options.weightsFilePath = tree.get<std::string>("ROI.weightsFilePath", "");
+  if (options.modelFilePath.empty() || options.weightsFilePath.empty())
+  {
+    return std::nullopt;
+  }
+  auto thresholds = tree.get_child_optional("ROI.thresholds");
+  if (thresholds.is_initialized())
+  {
+    options.thresholds.clear();
+    for (auto const& item : thresholds.get())
+    {
+      options.thresholds.push_back(item.second.get_value<float>());
+    }
+  }
+  options.inputChannels = tree.get<uint32_t>("ROI.inputChannels", options.inputChannels);
+  options.inputSize = cv::Size(tree.get<int>("ROI.inputWidth", 0), tree.get<int>("ROI.inputHeight", 0));
+  options.batchSize = tree.get<size_t>("ROI.batchSize", options.batchSize);
+  return options;
+}
+
+auto ProjectFile::loadSplitOptions(boost::property_tree::ptree const& tree) -> SplitOptions
+{
+  SplitOptions options;
+  options.validationFraction = tree.get<float>("split.validationFraction", options.validationFraction);
+  options.seed = tree.get<uint32_t>("split.seed", options.seed);
+  options.isStratified = tree.get<bool>("split.stratified", options.isStratified);
+  return options;
+}
+
+auto ProjectFile::loadSplit(boost::property_tree::ptree const& tree) -> SplitAssignment
+{
+  SplitAssignment assignment;
+  assignment.options = loadSplitOptions(tree);
+  for (auto const& part : {std::make_pair("split.training", &assignment.training), std::make_pair("split.validation", &assignment.validation)})
+  {
+    auto imagePaths = tree.get_child_optional(part.first);
+    if (!imagePaths.is_initialized())
+    {
+      continue;
+    }
+    for (auto const& item : imagePaths.get())
+    {
+      part.second->insert(item.second.get_value<std::string>());
+    }
+  }
+  return assignment;
+}
+
+void ProjectFile::saveSplit(boost::property_tree::ptree& tree, SplitAssignment const& assignment)
+{
+  tree.put("split.validationFraction", assignment.options.validationFraction);
+  tree.put("split.seed", assignment.options.seed);
+  tree.put("split.stratified", assignment.options.isStratified);
+  for (auto const& part : {std::make_pair("split.training", &assignment.training), std::make_pair("split.validation", &assignment.validation)})
+  {
+    bp::ptree imagePaths;
+    for (auto const& imagePath : *part.second)
+    {
+      bp::ptree item;
+      item.put_value(imagePath);
+      imagePaths.push_back(bp::ptree::value_type("", item));
+    }
+    tree.put_child(part.first, imagePaths);
+  }
+}
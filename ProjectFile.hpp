@@ -1,17 +1,41 @@
 #pragma once
 
+#include "DatasetSplitter.hpp"
+#include "RoiDetector.hpp"
+
 #include <opencv2/opencv.hpp>
 
 #include <boost/property_tree/ptree.hpp>
 
 #include <map>
+#include <optional>
 #include <string>
 
 namespace bp = boost::property_tree;
 
+/// Training settings of one class, the same for every network of the project
+struct ClassSettings
+{
+  /// Probability threshold of the class on evaluation
+  float threshold{0.3f};
+  /// Loss weight of the class, rare classes get more than 1
+  float weight{1.0f};
+};
+
 struct ProjectFile
 {
-static auto loadColors(bp::ptree& tree) -> std::map<std::string, cv::Scalar>;
+/// Writes to a temporary file next to the project and renames it, so the project is never left truncated.
+static bool save(std::string const& projectFile, bp::ptree const& tree);
+static auto loadColors(bp::ptree const& tree) -> std::map<std::string, cv::Scalar>;
 static void saveColors(bp::ptree& tree, std::map<std::string, cv::Scalar> const& colorMap);
-static void iterateOverDatasets(bp::ptree& pt, std::function<void(std::string const&, std::string const&)>&& cb);
+/// The "classSettings" section, classes which are not stored get the default settings.
+static auto loadClassSettings(bp::ptree const& tree) -> std::map<std::string, ClassSettings>;
+static void saveClassSettings(bp::ptree& tree, std::map<std::string, ClassSettings> const& settings);
+static void iterateOverDatasets(bp::ptree const& pt, std::function<void(std::string const&, std::string const&)>&& cb);
+/// Settings of the "ROI" section, nothing when ROI cropping is disabled or the model is not set.
+static auto loadRoiDetectorOptions(bp::ptree const& tree) -> std::optional<RoiDetectorOptions>;
+/// The "split" section: options (validationFraction, seed, stratified) and the assigned image paths.
+static auto loadSplit(bp::ptree const& tree) -> SplitAssignment;
+static auto loadSplitOptions(bp::ptree const& tree) -> SplitOptions;
+static void saveSplit(bp::ptree& tree, SplitAssignment const& assignment);
 };
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include "ProjectSaver.hpp"
+#include "ProjectFile.hpp"
+
+#include <QTimer>
+#include <QtGlobal>
+
+ProjectSaver::ProjectSaver(std::string projectFile, boost::property_tree::ptree const& pt, QObject* parent, int delayMs)
+  : QObject(parent)
+  , _projectFile{std::move(projectFile)}
+  , _pt{pt}
+  , _timer{new QTimer(this)}
+{
+  _timer->setSingleShot(true);
+  _timer->setInterval(delayMs);
+  connect(_timer, &QTimer::timeout, this, &ProjectSaver::flush);
+}
+
+ProjectSaver::~ProjectSaver()
+{
+  flush();
+}
+
+void ProjectSaver::scheduleSave()
+{
+  _isDirty = true;
+  _timer->start();
+}
+
+bool ProjectSaver::flush()
+{
+  _timer->stop();
+  if (!_isDirty)
+  {
+    return true;
+  }
+  if (!ProjectFile::save(_projectFile, _pt))
+  {
+    qWarning("Could not be saved project file: %s", _projectFile.c_str());
+    return false;
+  }
+  _isDirty = false;
+  return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QObject>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <string>
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+/**
+ * Coalesces edits of the project tree: every change only restarts the debounce timer and the tree
+ * is written once the edits calm down, on flush or on destruction. Writes are atomic (ProjectFile::save).
+ * The tree is owned by the caller and must outlive the saver, so the saver should be a member declared after it.
+ */
+class ProjectSaver : public QObject
+{
+Q_OBJECT
+
+public:
+  ProjectSaver(std::string projectFile, boost::property_tree::ptree const& pt, QObject* parent = nullptr, int delayMs = 500);
+  ~ProjectSaver() override;
+
+  void scheduleSave();
+
+public slots:
+  /// Writes pending changes right now, returns false when the write has failed.
+  bool flush();
+
+private:
+  std::string _projectFile;
+  boost::property_tree::ptree const& _pt;
+  QTimer* _timer{};
+  bool _isDirty{};
+};
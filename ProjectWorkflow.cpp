@@ -0,0 +1,390 @@
+#include "ProjectWorkflow.hpp"
+#include "DatasetIndexCache.hpp"
+#include "DatasetSplitter.hpp"
+#include "LabelMeReader.hpp"
+#include "MaskRasterizer.hpp"
+#include "ProjectFile.hpp"
+#include "RoiModelRegistry.hpp"
+
+#include <UNet/TrainUnet2D.hpp>
+
+#ifdef _MSC_VER
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <algorithm>
+
+namespace {
+constexpr size_t indexBatchSize = 64;
+} /// end namespace anonymous
+
+auto ProjectWorkflow::datasets(bp::ptree const& pt) -> std::vector<std::pair<std::string, std::string>>
+{
+  std::vector<std::pair<std::string, std::string>> result;
+  ProjectFile::iterateOverDatasets(pt, [&](std::string const& imagesDirectoryPath, std::string const& labelsDirectoryPath) {
+    result.emplace_back(imagesDirectoryPath, labelsDirectoryPath);
+  });
+  return result;
+}
+
+void ProjectWorkflow::indexDatasets(std::vector<std::pair<std::string, std::string>> const& datasets,
+                                    std::string const& indexFilePath,
+                                    bool isContentHashed,
+                                    std::atomic<bool> const& isCanceled,
+                                    std::function<void(size_t)> const& onCounted,
+                                    DatasetIndexer::BatchCallback const& onBatch)
+{
+  std::vector<DatasetSample> samples;
+  for (auto const& dataset : datasets)
+  {
+    auto datasetSamples = DatasetIndexer::listSamples(dataset.first, dataset.second);
+    samples.insert(samples.end(), std::make_move_iterator(datasetSamples.begin()), std::make_move_iterator(datasetSamples.end()));
+    if (isCanceled)
+    {
+      return;
+    }
+  }
+  onCounted(samples.size());
+
+  DatasetIndexCache indexCache(indexFilePath, isContentHashed);
+  indexCache.load();
+  for (auto& sample : samples)
+  {
+    indexCache.lookup(sample);
+  }
+
+  DatasetIndexer::indexSamples(std::move(samples), indexBatchSize, isCanceled, [&](std::vector<DatasetSample>&& batch) {
+    for (auto const& sample : batch)
+    {
+      indexCache.store(sample);
+    }
+    onBatch(std::move(batch));
+  });
+  indexCache.save(!isCanceled);
+}
+
+auto ProjectWorkflow::exportSplit(bp::ptree const& pt,
+                                  std::string const& indexFilePath,
+                                  SplitExportOptions const& options,
+                                  std::atomic<bool> const& isCanceled,
+                                  SplitExporter::ProgressCallback const& onProgress) -> SplitExporter::Result
+{
+  /// Indexing is cheap for unchanged samples, they are restored from the index, and it gives the classes of samples
+  std::vector<DatasetSample> samples;
+  indexDatasets(datasets(pt), indexFilePath, pt.get<bool>("index.contentHash", false), isCanceled, [](size_t) {
+  }, [&](std::vector<DatasetSample>&& batch) {
+    samples.insert(samples.end(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+  });
+  if (isCanceled)
+  {
+    return {};
+  }
+  return SplitExporter::exportByClass(std::move(samples), options, isCanceled, onProgress);
+}
+
+auto ProjectWorkflow::conversionSamples(bp::ptree& pt, std::string const& indexFilePath) -> std::vector<ConversionSample>
+{
+  std::vector<ConversionSample> samples;
+  auto datasetFolderPathes = pt.get_child_optional("datasets");
+  if (!datasetFolderPathes.is_initialized())
+  {
+    return samples;
+  }
+  for (auto const& datasetFolderPath : datasetFolderPathes.get())
+  {
+    auto annotations = datasetFolderPath.second.get_optional<std::string>("annotations");
+    auto images = datasetFolderPath.second.get_optional<std::string>("images");
+    if (!annotations.is_initialized() || !images.is_initialized())
+    {
+      continue;
+    }
+    for (auto const& file : fs::directory_iterator{images.get()})
+    {
+      if (fs::is_directory(file))
+      {
+        continue;
+      }
+      auto filename = file.path().filename().string();
+      filename = filename.substr(0, filename.size() - 4);
+      samples.push_back(ConversionSample{file.path().string(), annotations.get() + "/" + filename + ".json"});
+    }
+  }
+
+  auto const splitOptions = ProjectFile::loadSplitOptions(pt);
+  std::vector<std::map<std::string, uint32_t>> labelsCount;
+  if (splitOptions.isStratified)
+  {
+    /// Label statistics come from the dataset index, only samples which are not indexed yet are read
+    DatasetIndexCache indexCache(indexFilePath, pt.get<bool>("index.contentHash", false));
+    indexCache.load();
+    labelsCount.reserve(samples.size());
+    for (auto const& sample : samples)
+    {
+      DatasetSample indexedSample;
+      indexedSample.imagePath = sample.imagePath;
+      indexedSample.annotationPath = sample.annotationPath;
+      LabelMeAnnotation annotation;
+      if (indexCache.lookup(indexedSample))
+      {
+        labelsCount.emplace_back(indexedSample.labelsByName);
+      }
+      else if (LabelMeReader::read(sample.annotationPath, annotation, LabelMeReader::Shapes))
+      {
+        labelsCount.emplace_back(annotation.labelsCount());
+      }
+      else
+      {
+        labelsCount.emplace_back();
+      }
+    }
+  }
+  auto assignment = ProjectFile::loadSplit(pt);
+  DatasetSplitter::split(samples, labelsCount, splitOptions, assignment);
+  ProjectFile::saveSplit(pt, assignment);
+  return samples;
+}
+
+auto ProjectWorkflow::conversionOptions(bp::ptree const& pt, std::string const& outputDirectoryPath) -> ConversionOptions
+{
+  ConversionOptions options;
+  options.outputDirectoryPath = outputDirectoryPath;
+  options.isClahe = false;
+  options.heightDownscale = pt.get<uint32_t>("UNet.heightDownscale", 1);
+  options.widthDownscale = pt.get<uint32_t>("UNet.widthDownscale", 1);
+  options.initialFeatureCount = pt.get<uint32_t>("UNet.featuresCount", 8);
+  options.colorToClass = ProjectFile::loadColors(pt);
+  options.maskFormat = pt.get<bool>("UNet.classIndexMasks", false) ? MaskFormat::ClassIndex : MaskFormat::Color;
+  options.isContentHashed = pt.get<bool>("index.contentHash", false);
+  auto roiDetectorOptions = ProjectFile::loadRoiDetectorOptions(pt);
+  if (roiDetectorOptions)
+  {
+    options.roiBatchSize = roiDetectorOptions->batchSize;
+    options.roiModelKey = RoiModelRegistry::keyFor(*roiDetectorOptions);
+  }
+  return options;
+}
+
+auto ProjectWorkflow::sampleCacheOptions(bp::ptree const& pt) -> SampleCacheOptions
+{
+  SampleCacheOptions options;
+  options.memoryBytesLimit = pt.get<uint64_t>("cache.memoryMiB", options.memoryBytesLimit >> 20) << 20;
+  options.spillBytesLimit = pt.get<uint64_t>("cache.spillMiB", options.spillBytesLimit >> 20) << 20;
+  options.spillDirectoryPath = pt.get<std::string>("cache.spillDirectory", "");
+  return options;
+}
+
+bool ProjectWorkflow::roiCallback(bp::ptree const& pt, DatasetConverter::RoiCallback& callback)
+{
+  callback = nullptr;
+  auto roiDetectorOptions = ProjectFile::loadRoiDetectorOptions(pt);
+  if (!roiDetectorOptions)
+  {
+    return true;
+  }
+  auto roiDetector = RoiModelRegistry::instance().detector(*roiDetectorOptions);
+  if (!roiDetector)
+  {
+    return false;
+  }
+  callback = [roiDetector](std::vector<cv::Mat> const& frames) {
+    return roiDetector->detect(frames);
+  };
+  return true;
+}
+
+auto ProjectWorkflow::generateModel(bp::ptree& pt, std::string const& directoryPath) -> std::string
+{
+  auto modelFilePath = directoryPath + "/unet_" +
+                       pt.get<std::string>("UNet.inputChannels", "1") + "c" +
+                       pt.get<std::string>("UNet.outputChannels", "7") + "cl" +
+                       pt.get<std::string>("UNet.layersCount", "4") + "l" +
+                       pt.get<std::string>("UNet.featuresCount", "5") + "f" + ".cfg";
+  pt.put<std::string>("UNet.modelFilePath", modelFilePath);
+  runOpts({{std::string("--generate-custom-unet"), {
+                                                     pt.get<std::string>("UNet.inputChannels", "1"),
+                                                     pt.get<std::string>("UNet.outputChannels", "7"),
+                                                     pt.get<std::string>("UNet.layersCount", "4"),
+                                                     pt.get<std::string>("UNet.featuresCount", "5"),
+                                                     directoryPath}}});
+  return modelFilePath;
+}
+
+auto ProjectWorkflow::trainingParams(bp::ptree const& pt, std::string const& convertedDatasetPath, bool isEvaluation) -> Params
+{
+  auto modelFilePath = pt.get<std::string>("UNet.modelFilePath", "");
+  auto weightsFilePath = pt.get<std::string>("UNet.weightsFilePath", "");
+  auto colorsToClassMap = ProjectFile::loadColors(pt);
+  auto classSettings = ProjectFile::loadClassSettings(pt);
+  Params params;
+  auto isWeighted = false;
+  /// All classes in the name order, it is the order of the output channels and of the class indices
+  for (auto const& colorToClass : colorsToClassMap)
+  {
+    auto const& settings = classSettings[colorToClass.first];
+    params["--colors-to-class-map"].emplace_back(colorToClass.first);
+    params["--colors-to-class-map"].emplace_back(std::to_string(colorToClass.second[2]));
+    params["--colors-to-class-map"].emplace_back(std::to_string(colorToClass.second[1]));
+    params["--colors-to-class-map"].emplace_back(std::to_string(colorToClass.second[0]));
+    params["--selected-classes-and-thresholds"].emplace_back(colorToClass.first);
+    params["--selected-classes-and-thresholds"].emplace_back(std::to_string(settings.threshold));
+    params["--class-weights"].emplace_back(colorToClass.first);
+    params["--class-weights"].emplace_back(std::to_string(settings.weight));
+    isWeighted = isWeighted || (settings.weight != 1.0f);
+  }
+  /// Equal weights are the trainer default, the flag is sent only when it changes something (validateTrainerSupport)
+  if (!isWeighted)
+  {
+    params.erase("--class-weights");
+  }
+  params["--eval"] = {isEvaluation ? "yes" : "no"};
+  params["--epochs"] = {std::to_string(pt.get<uint32_t>("UNet.epochsCount", 200))};
+  fs::create_directories(modelFilePath + "_checkpoints");
+  params["--checkpoints-output"] = {modelFilePath + "_checkpoints"};
+  /// The trainer reads only the directories layout (validateTrainerSupport)
+  params["--train-directories"] = {convertedDatasetPath + "/imagesT/", convertedDatasetPath + "/masksT/"};
+  params["--valid-directories"] = {convertedDatasetPath + "/imagesV/", convertedDatasetPath + "/masksV/"};
+  if (weightsFilePath.empty())
+  {
+    params["--model-darknet"] = {modelFilePath};
+  }
+  else
+  {
+    params["--model-darknet"] = {modelFilePath, weightsFilePath};
+  }
+#ifdef UNET_TRAINER_CLASS_INDEX_MASKS
+  if (pt.get<bool>("UNet.classIndexMasks", false))
+  {
+    /// Masks hold class indices, the names are passed in the index order
+    auto& classNames = params["--class-index-masks"];
+    for (auto const& classIndex : MaskRasterizer::classIndices(colorsToClassMap))
+    {
+      classNames.emplace_back(classIndex.first);
+    }
+  }
+#endif
+  params["--size-downscaled"] = {"0", "0"};
+  params["--grayscale"] = {(pt.get<uint32_t>("UNet.inputChannels", 1) == 1) ? "yes" : "no"};
+  return params;
+}
+
+auto ProjectWorkflow::validationOptions(bp::ptree const& pt) -> ValidationOptions
+{
+  ValidationOptions options;
+  options.network.modelFilePath = pt.get<std::string>("UNet.modelFilePath", "");
+  options.network.weightsFilePath = pt.get<std::string>("UNet.weightsFilePath", "");
+  options.network.inputChannels = pt.get<uint32_t>("UNet.inputChannels", 1);
+  options.network.thresholds.clear();
+  auto classSettings = ProjectFile::loadClassSettings(pt);
+  /// Name order, the order of the output channels and of the class indices
+  for (auto const& colorToClass : ProjectFile::loadColors(pt))
+  {
+    options.classNames.emplace_back(colorToClass.first);
+    options.classColors.emplace_back(colorToClass.second);
+    options.network.thresholds.emplace_back(classSettings[colorToClass.first].threshold);
+  }
+  options.isClassIndexMasks = pt.get<bool>("UNet.classIndexMasks", false);
+  return options;
+}
+
+auto ProjectWorkflow::validateClasses(bp::ptree const& pt) -> std::string
+{
+  auto const classesCount = ProjectFile::loadColors(pt).size();
+  if (classesCount == 0)
+  {
+    return "The project has no classes, classesColorsMap is empty";
+  }
+  auto const outputChannels = pt.get<size_t>("UNet.outputChannels", 1);
+  if (outputChannels != classesCount)
+  {
+    return "UNet.outputChannels is " + std::to_string(outputChannels) + " but the project has " + std::to_string(classesCount) +
+           " classes, the network needs one output channel per class";
+  }
+  for (auto const& settings : ProjectFile::loadClassSettings(pt))
+  {
+    if ((settings.second.threshold <= 0.0f) || (settings.second.threshold >= 1.0f) || (settings.second.weight <= 0.0f))
+    {
+      return "Class \"" + settings.first + "\" needs a threshold in (0, 1) and a positive weight";
+    }
+  }
+  return {};
+}
+
+bool ProjectWorkflow::isClassIndexMasksTrainable()
+{
+#ifdef UNET_TRAINER_CLASS_INDEX_MASKS
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool ProjectWorkflow::isClassWeightsTrainable()
+{
+#ifdef UNET_TRAINER_CLASS_WEIGHTS
+  return true;
+#else
+  return false;
+#endif
+}
+
+auto ProjectWorkflow::validateTrainerSupport(bp::ptree const& pt) -> std::string
+{
+  /// A trainer which ignores the flag would read the indices as colors, every pixel would be the background
+  if (!isClassIndexMasksTrainable() && pt.get<bool>("UNet.classIndexMasks", false))
+  {
+    return "UNet.classIndexMasks is set but the trainer is not known to accept --class-index-masks, convert color masks"
+           " for training or configure with -DUNET_TRAINER_CLASS_INDEX_MASKS=ON for a trainer which does";
+  }
+  for (auto const& settings : ProjectFile::loadClassSettings(pt))
+  {
+    if (!isClassWeightsTrainable() && (settings.second.weight != 1.0f))
+    {
+      return "Class \"" + settings.first + "\" has the loss weight " + std::to_string(settings.second.weight) +
+             " but the trainer is not known to accept --class-weights, configure with -DUNET_TRAINER_CLASS_WEIGHTS=ON"
+             " for a trainer which does, or keep the weights at 1";
+    }
+  }
+  return {};
+}
+
+auto ProjectWorkflow::checkpointsDirectory(bp::ptree const& pt) -> std::string
+{
+  auto const modelFilePath = pt.get<std::string>("UNet.modelFilePath", "");
+  return modelFilePath.empty() ? std::string{} : (modelFilePath + "_checkpoints");
+}
+
+auto ProjectWorkflow::checkpoints(std::string const& directoryPath) -> std::vector<std::string>
+{
+  std::vector<std::pair<fs::file_time_type, std::string>> checkpoints;
+  std::error_code errorCode;
+  for (fs::directory_iterator it(directoryPath, errorCode), end; !directoryPath.empty() && !errorCode && (it != end); it.increment(errorCode))
+  {
+    if (fs::is_directory(it->status()) || (it->path().extension().string() != ".weights"))
+    {
+      continue;
+    }
+    auto const time = fs::last_write_time(it->path(), errorCode);
+    if (!errorCode)
+    {
+      checkpoints.emplace_back(time, it->path().string());
+    }
+    errorCode.clear();
+  }
+  std::sort(checkpoints.begin(), checkpoints.end());
+  std::vector<std::string> paths;
+  for (auto& checkpoint : checkpoints)
+  {
+    paths.emplace_back(std::move(checkpoint.second));
+  }
+  return paths;
+}
+
+auto ProjectWorkflow::latestCheckpoint(bp::ptree const& pt) -> std::string
+{
+  auto const paths = checkpoints(checkpointsDirectory(pt));
+  return paths.empty() ? std::string{} : paths.back();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "DatasetConverter.hpp"
+#include "DatasetIndexer.hpp"
+#include "SampleCache.hpp"
+#include "SplitExporter.hpp"
+#include "ValidationMetrics.hpp"
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bp = boost::property_tree;
+
+/**
+ * Steps of the project workflow (index, convert, train, validate) driven by the project file only,
+ * without any UI. Shared by the dialogs and the command line tool.
+ */
+struct ProjectWorkflow
+{
+  using Params = std::map<std::string, std::vector<std::string>>;
+
+  static auto datasets(bp::ptree const& pt) -> std::vector<std::pair<std::string, std::string>>;
+
+  /// Restores unchanged samples from the persistent index and indexes the rest.
+  static void indexDatasets(std::vector<std::pair<std::string, std::string>> const& datasets,
+                            std::string const& indexFilePath,
+                            bool isContentHashed,
+                            std::atomic<bool> const& isCanceled,
+                            std::function<void(size_t)> const& onCounted,
+                            DatasetIndexer::BatchCallback const& onBatch);
+
+  /// Indexes the project datasets and exports their samples by class (SplitExporter).
+  static auto exportSplit(bp::ptree const& pt,
+                          std::string const& indexFilePath,
+                          SplitExportOptions const& options,
+                          std::atomic<bool> const& isCanceled,
+                          SplitExporter::ProgressCallback const& onProgress) -> SplitExporter::Result;
+
+  /// All "labelme" samples of the project datasets split by DatasetSplitter with the "split" section options.
+  /// The split is stored back into the "split" section, the caller saves the project to keep it for the next runs.
+  static auto conversionSamples(bp::ptree& pt, std::string const& indexFilePath) -> std::vector<ConversionSample>;
+  static auto conversionOptions(bp::ptree const& pt, std::string const& outputDirectoryPath) -> ConversionOptions;
+  /// Limits of the sample cache from the "cache" section (memoryMiB, spillMiB, spillDirectory), cache.enabled turns it on.
+  static auto sampleCacheOptions(bp::ptree const& pt) -> SampleCacheOptions;
+  /// Leaves the callback empty when ROI cropping is disabled, returns false when the ROI model could not be loaded.
+  static bool roiCallback(bp::ptree const& pt, DatasetConverter::RoiCallback& callback);
+
+  /// Generates the darknet config of the network described by the "UNet" section into the directory
+  /// and stores its path as UNet.modelFilePath.
+  static auto generateModel(bp::ptree& pt, std::string const& directoryPath) -> std::string;
+  /// Parameters of the trainer for training or evaluation of UNet.modelFilePath on the converted dataset.
+  /// Every project class is passed with its threshold from the "classSettings" section, the weights only when some differs from 1.
+  /// With UNet.classIndexMasks (and UNET_TRAINER_CLASS_INDEX_MASKS) the trainer gets --class-index-masks
+  /// with class names in the index order.
+  static auto trainingParams(bp::ptree const& pt, std::string const& convertedDatasetPath, bool isEvaluation) -> Params;
+  /// The trained network (UNet.modelFilePath, UNet.weightsFilePath) with the class thresholds, colors and mask format.
+  static auto validationOptions(bp::ptree const& pt) -> ValidationOptions;
+  /// Checks the classes before a run: UNet.outputChannels must match the classes count, thresholds and weights
+  /// must be valid. Returns the problem, empty when the run could start.
+  static auto validateClasses(bp::ptree const& pt) -> std::string;
+  /// Checks that the trainer reads what the project converts for it: weights other than 1 need a trainer with --class-weights
+  /// (UNET_TRAINER_CLASS_WEIGHTS) and class index masks one with --class-index-masks (UNET_TRAINER_CLASS_INDEX_MASKS).
+  /// Conversion and validation read class index masks themselves. Returns the problem, empty when training could start.
+  static auto validateTrainerSupport(bp::ptree const& pt) -> std::string;
+  /// The build knows the trainer reads class index masks (UNET_TRAINER_CLASS_INDEX_MASKS), the definition is private to the core.
+  static bool isClassIndexMasksTrainable();
+  /// The build knows the trainer accepts --class-weights (UNET_TRAINER_CLASS_WEIGHTS).
+  static bool isClassWeightsTrainable();
+  /// Where the trainer writes the checkpoints of UNet.modelFilePath, empty when the model is not set.
+  static auto checkpointsDirectory(bp::ptree const& pt) -> std::string;
+  /// "*.weights" of the directory from the oldest to the newest.
+  static auto checkpoints(std::string const& directoryPath) -> std::vector<std::string>;
+  /// The newest "*.weights" in the checkpoints directory of UNet.modelFilePath, empty when there is none.
+  static auto latestCheckpoint(bp::ptree const& pt) -> std::string;
+};
@@ -0,0 +1,146 @@
+#include "RoiDetector.hpp"
+#include "DatasetConverter.hpp"
+
+#include <opencv_unet/UNet.hpp>
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+
+RoiDetector::RoiDetector(RoiDetectorOptions options)
+  : _options{std::move(options)}
+  , _net{cv::dnn::readNetFromDarknet(_options.modelFilePath, _options.weightsFilePath)}
+{
+  _options.batchSize = std::max<size_t>(_options.batchSize, 1);
+  _options.sizeAlignment = std::max<uint32_t>(_options.sizeAlignment, 1);
+  if (_options.thresholds.empty())
+  {
+    _options.thresholds.push_back(0.5f);
+  }
+}
+
+auto RoiDetector::options() const -> RoiDetectorOptions const&
+{
+  return _options;
+}
+
+auto RoiDetector::detect(cv::Mat const& frame) -> cv::Rect
+{
+  return detect(std::vector<cv::Mat>{frame}).front();
+}
+
+auto RoiDetector::detect(std::vector<cv::Mat> const& frames) -> std::vector<cv::Rect>
+{
+  std::vector<cv::Rect> result;
+  result.reserve(frames.size());
+  auto const predictions = predict(frames);
+  for (size_t i = 0; i < frames.size(); ++i)
+  {
+    auto unionBox = DatasetConverter::unionBoundingBox(UNet::foundBoundingBoxes(predictions[i]));
+    if (!unionBox.empty() && !predictions[i].empty())
+    {
+      auto const scaleX = static_cast<double>(frames[i].cols) / predictions[i].front().cols;
+      auto const scaleY = static_cast<double>(frames[i].rows) / predictions[i].front().rows;
+      unionBox = cv::Rect(static_cast<int>(unionBox.x * scaleX),
+                          static_cast<int>(unionBox.y * scaleY),
+                          static_cast<int>(unionBox.width * scaleX),
+                          static_cast<int>(unionBox.height * scaleY));
+    }
+    result.push_back(unionBox);
+  }
+  return result;
+}
+
+auto RoiDetector::predict(std::vector<cv::Mat> const& frames) -> std::vector<std::vector<cv::Mat>>
+{
+  auto result = probabilities(frames);
+  for (auto& frameResult : result)
+  {
+    frameResult = threshold(frameResult);
+  }
+  return result;
+}
+
+auto RoiDetector::threshold(std::vector<cv::Mat> const& probabilities) const -> std::vector<cv::Mat>
+{
+  std::vector<cv::Mat> masks;
+  masks.reserve(probabilities.size());
+  for (size_t c = 0; c < probabilities.size(); ++c)
+  {
+    auto const threshold = _options.thresholds[std::min<size_t>(c, _options.thresholds.size() - 1)];
+    cv::Mat mask;
+    cv::threshold(probabilities[c], mask, threshold, 255.0, cv::THRESH_BINARY);
+    mask.convertTo(mask, CV_8U);
+    masks.emplace_back(mask);
+  }
+  return masks;
+}
+
+auto RoiDetector::probabilities(std::vector<cv::Mat> const& frames) -> std::vector<std::vector<cv::Mat>>
+{
+  std::vector<std::vector<cv::Mat>> result;
+  result.reserve(frames.size());
+  std::lock_guard<std::mutex> lock(_mutex);
+  size_t first = 0;
+  while (first < frames.size())
+  {
+    /// A blob must have the same size for all frames, so a batch is split when the input size changes
+    auto const inputSize = inputSizeFor(frames[first]);
+    auto last = first + 1;
+    while ((last < std::min(first + _options.batchSize, frames.size())) && (inputSizeFor(frames[last]) == inputSize))
+    {
+      ++last;
+    }
+    auto predictions = forward(std::vector<cv::Mat>(frames.begin() + first, frames.begin() + last), inputSize);
+    result.insert(result.end(), std::make_move_iterator(predictions.begin()), std::make_move_iterator(predictions.end()));
+    first = last;
+  }
+  return result;
+}
+
+auto RoiDetector::inputSizeFor(cv::Mat const& frame) const -> cv::Size
+{
+  if (!_options.inputSize.empty())
+  {
+    return _options.inputSize;
+  }
+  auto const alignment = static_cast<int>(_options.sizeAlignment);
+  return cv::Size(std::max(frame.cols - (frame.cols % alignment), alignment),
+                  std::max(frame.rows - (frame.rows % alignment), alignment));
+}
+
+auto RoiDetector::forward(std::vector<cv::Mat> const& frames, cv::Size inputSize) -> std::vector<std::vector<cv::Mat>>
+{
+  std::vector<cv::Mat> inputs;
+  inputs.reserve(frames.size());
+  for (auto const& frame : frames)
+  {
+    cv::Mat input = frame;
+    if ((_options.inputChannels == 1) && (frame.channels() == 3))
+    {
+      cv::cvtColor(frame, input, cv::COLOR_BGR2GRAY);
+    }
+    else if ((_options.inputChannels == 3) && (frame.channels() == 1))
+    {
+      cv::cvtColor(frame, input, cv::COLOR_GRAY2BGR);
+    }
+    inputs.emplace_back(input);
+  }
+  _net.setInput(cv::dnn::blobFromImages(inputs, 1.0 / 255.0, inputSize, cv::Scalar(), false, false));
+  cv::Mat output = _net.forward();
+
+  /// Output is NxCxHxW
+  auto const classesCount = output.size[1];
+  auto const height = output.size[2];
+  auto const width = output.size[3];
+  std::vector<std::vector<cv::Mat>> result(frames.size());
+  for (size_t n = 0; n < frames.size(); ++n)
+  {
+    for (auto c = 0; c < classesCount; ++c)
+    {
+      /// The output blob is reused by the next forward
+      result[n].emplace_back(cv::Mat(height, width, CV_32FC1, output.ptr<float>(static_cast<int>(n), c)).clone());
+    }
+  }
+  return result;
+}
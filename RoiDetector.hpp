@@ -0,0 +1,54 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/dnn.hpp>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct RoiDetectorOptions
+{
+  std::string modelFilePath;
+  std::string weightsFilePath;
+  /// Per class, the last one is used for the rest of classes
+  std::vector<float> thresholds{0.99f};
+  uint32_t inputChannels{3};
+  /// Network input size, empty means the size of the first frame aligned down to sizeAlignment.
+  /// Could be set smaller than frames for a cheaper ROI pre-pass.
+  cv::Size inputSize;
+  uint32_t sizeAlignment{32};
+  size_t batchSize{8};
+};
+
+/**
+ * Finds the region of interest of frames with a darknet UNet model: the union of the biggest
+ * bounding box of every class. Frames are resized to the input size and forwarded through
+ * the network as one blob per batch, boxes are returned in the frames coordinates.
+ * The network output is expected to be probabilities (logistic activation of the last layer).
+ * Thread safe, calls are serialized.
+ */
+class RoiDetector
+{
+public:
+  explicit RoiDetector(RoiDetectorOptions options);
+
+  auto options() const -> RoiDetectorOptions const&;
+
+  auto detect(cv::Mat const& frame) -> cv::Rect;
+  auto detect(std::vector<cv::Mat> const& frames) -> std::vector<cv::Rect>;
+  /// Thresholded masks (CV_8UC1, 0 or 255) per frame per class in the network input size.
+  auto predict(std::vector<cv::Mat> const& frames) -> std::vector<std::vector<cv::Mat>>;
+  /// Probabilities (CV_32FC1) per frame per class in the network input size.
+  auto probabilities(std::vector<cv::Mat> const& frames) -> std::vector<std::vector<cv::Mat>>;
+  /// Masks of the probabilities with the per class thresholds, the same as predict makes.
+  auto threshold(std::vector<cv::Mat> const& probabilities) const -> std::vector<cv::Mat>;
+
+private:
+  auto inputSizeFor(cv::Mat const& frame) const -> cv::Size;
+  auto forward(std::vector<cv::Mat> const& frames, cv::Size inputSize) -> std::vector<std::vector<cv::Mat>>;
+
+  RoiDetectorOptions _options;
+  cv::dnn::Net _net;
+  std::mutex _mutex;
+};
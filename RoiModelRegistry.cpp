@@ -0,0 +1,60 @@
+#include "RoiModelRegistry.hpp"
+
+#include <sstream>
+
+auto RoiModelRegistry::instance() -> RoiModelRegistry&
+{
+  static RoiModelRegistry registry;
+  return registry;
+}
+
+auto RoiModelRegistry::detector(RoiDetectorOptions const& options) -> std::shared_ptr<RoiDetector>
+{
+  std::shared_ptr<Entry> entry;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& cached = _entries[keyFor(options)];
+    if (!cached)
+    {
+      cached = std::make_shared<Entry>();
+    }
+    entry = cached;
+  }
+
+  /// The registry lock is not held while loading, so only requests of the same model wait for it
+  std::lock_guard<std::mutex> lock(entry->mutex);
+  if (!entry->detector)
+  {
+    try
+    {
+      entry->detector = std::make_shared<RoiDetector>(options);
+    }
+    catch (std::exception const&)
+    {
+      return nullptr;
+    }
+  }
+  return entry->detector;
+}
+
+void RoiModelRegistry::clear()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _entries.clear();
+}
+
+auto RoiModelRegistry::keyFor(RoiDetectorOptions const& options) -> std::string
+{
+  std::ostringstream key;
+  key << options.modelFilePath << '\n'
+      << options.weightsFilePath << '\n'
+      << options.inputChannels << ' '
+      << options.inputSize.width << 'x' << options.inputSize.height << ' '
+      << options.sizeAlignment << ' '
+      << options.batchSize;
+  for (auto threshold : options.thresholds)
+  {
+    key << ' ' << threshold;
+  }
+  return key.str();
+}
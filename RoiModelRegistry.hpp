@@ -0,0 +1,38 @@
+#pragma once
+
+#include "RoiDetector.hpp"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ * Process wide cache of ROI detectors, a network is loaded on the first request only and then
+ * shared by all dialogs and conversions which use the same model, weights and settings.
+ * Thread safe, different models could be loaded concurrently.
+ */
+class RoiModelRegistry
+{
+public:
+  static auto instance() -> RoiModelRegistry&;
+
+  /// Returns nullptr when the model could not be loaded, a failed load is retried on the next request.
+  auto detector(RoiDetectorOptions const& options) -> std::shared_ptr<RoiDetector>;
+  /// Drops the cached detectors, the ones still in use are released by their last owner.
+  void clear();
+  /// Identifies the model with its settings, equal keys share the detector.
+  static auto keyFor(RoiDetectorOptions const& options) -> std::string;
+
+private:
+  RoiModelRegistry() = default;
+
+  struct Entry
+  {
+    std::mutex mutex;
+    std::shared_ptr<RoiDetector> detector;
+  };
+
+  std::mutex _mutex;
+  std::map<std::string, std::shared_ptr<Entry>> _entries;
+};
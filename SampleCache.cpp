@@ -0,0 +1,261 @@
+#include "SampleCache.hpp"
+
+#ifdef _MSC_VER
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+
+namespace {
+auto matBytes(cv::Mat const& mat) -> uint64_t
+{
+  return static_cast<uint64_t>(mat.total()) * mat.elemSize();
+}
+
+auto modificationTime(std::string const& path) -> int64_t
+{
+  std::error_code errorCode;
+  auto const time = fs::last_write_time(path, errorCode);
+  return errorCode ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+constexpr uint64_t spillAlignment = 64;
+
+auto alignUp(uint64_t value) -> uint64_t
+{
+  return (value + spillAlignment - 1) & ~(spillAlignment - 1);
+}
+
+/// Copies the pixels row by row, matrices in the cache are continuous but their views need not be
+void writeMat(cv::Mat const& mat, uint8_t* destination)
+{
+  auto const rowBytes = static_cast<size_t>(mat.cols) * mat.elemSize();
+  for (int y = 0; y < mat.rows; ++y)
+  {
+    std::memcpy(destination + y * rowBytes, mat.ptr(y), rowBytes);
+  }
+}
+} /// end namespace anonymous
+
+auto SampleCache::instance() -> SampleCache&
+{
+  static SampleCache cache;
+  return cache;
+}
+
+SampleCache::~SampleCache()
+{
+  closeSpillFile();
+}
+
+void SampleCache::configure(SampleCacheOptions const& options)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if ((options.memoryBytesLimit == _options.memoryBytesLimit) &&
+      (options.spillBytesLimit == _options.spillBytesLimit) &&
+      (options.spillDirectoryPath == _options.spillDirectoryPath))
+  {
+    return;
+  }
+  _options = options;
+  _lru.clear();
+  _memoryEntries.clear();
+  _memoryBytes = 0;
+  closeSpillFile();
+  _isSpillFileFailed = false;
+}
+
+auto SampleCache::keyFor(std::string const& imagePath, std::string const& annotationPath, std::string const& parameters) -> std::string
+{
+  std::ostringstream key;
+  key << imagePath << '\n'
+      << annotationPath << '\n'
+      << modificationTime(imagePath) << ' ' << modificationTime(annotationPath) << '\n'
+      << parameters;
+  return key.str();
+}
+
+bool SampleCache::find(std::string const& key, cv::Mat& image, cv::Mat& mask)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto memoryEntry = _memoryEntries.find(key);
+  if (memoryEntry != _memoryEntries.end())
+  {
+    _lru.splice(_lru.begin(), _lru, memoryEntry->second.lruPosition);
+    image = memoryEntry->second.image;
+    mask = memoryEntry->second.mask;
+    ++_hitsCount;
+    return true;
+  }
+
+  auto spilledEntry = _spilledEntries.find(key);
+  if (spilledEntry == _spilledEntries.end())
+  {
+    ++_missesCount;
+    return false;
+  }
+  /// The ring overwrites spilled records, so they are copied out and moved back into the memory
+  auto const& spilled = spilledEntry->second;
+  auto data = const_cast<uint8_t*>(_spillFile.data());
+  image = cv::Mat(spilled.imageSize, spilled.imageType, data + spilled.offset).clone();
+  mask = cv::Mat(spilled.maskSize, spilled.maskType, data + spilled.maskOffset).clone();
+  dropSpilled(key);
+  insert(key, image, mask);
+  ++_hitsCount;
+  return true;
+}
+
+void SampleCache::store(std::string const& key, cv::Mat const& image, cv::Mat const& mask)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_memoryEntries.count(key) != 0)
+  {
+    return;
+  }
+  /// Two threads could miss the same key, the first one's sample could be spilled already
+  dropSpilled(key);
+  /// A crop keeps the whole decoded image alive, the cache holds just the crop
+  insert(key, image.isContinuous() ? image : image.clone(), mask.isContinuous() ? mask : mask.clone());
+}
+
+void SampleCache::clear()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _lru.clear();
+  _memoryEntries.clear();
+  _memoryBytes = 0;
+  closeSpillFile();
+  _isSpillFileFailed = false;
+}
+
+auto SampleCache::statistics() const -> Statistics
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  Statistics statistics;
+  statistics.hitsCount = _hitsCount;
+  statistics.missesCount = _missesCount;
+  statistics.memoryBytes = _memoryBytes;
+  statistics.spilledBytes = _spilledBytes;
+  return statistics;
+}
+
+void SampleCache::insert(std::string const& key, cv::Mat const& image, cv::Mat const& mask)
+{
+  _lru.push_front(key);
+  auto& entry = _memoryEntries[key];
+  entry.image = image;
+  entry.mask = mask;
+  entry.bytes = matBytes(image) + matBytes(mask);
+  entry.lruPosition = _lru.begin();
+  _memoryBytes += entry.bytes;
+
+  while ((_memoryBytes > _options.memoryBytesLimit) && !_lru.empty())
+  {
+    auto evicted = _memoryEntries.find(_lru.back());
+    spill(evicted->first, evicted->second);
+    _memoryBytes -= evicted->second.bytes;
+    _memoryEntries.erase(evicted);
+    _lru.pop_back();
+  }
+}
+
+void SampleCache::spill(std::string const& key, MemoryEntry const& entry)
+{
+  if ((_options.spillBytesLimit == 0) || (!_spillFile.isOpen() && !openSpillFile()))
+  {
+    return;
+  }
+  auto const maskBegin = alignUp(matBytes(entry.image));
+  auto const bytes = maskBegin + matBytes(entry.mask);
+  if (bytes > _spillFile.size())
+  {
+    return;
+  }
+  auto offset = alignUp(_spillCursor);
+  if ((offset + bytes) > _spillFile.size())
+  {
+    offset = 0;
+  }
+
+  /// A key has one record at most, its old offset must not be left for the ring to erase the new record by
+  dropSpilled(key);
+  /// Drops the records overwritten by this one, including the one which starts before and reaches into it
+  auto overwritten = _spilledKeys.lower_bound(offset);
+  if (overwritten != _spilledKeys.begin())
+  {
+    auto previous = std::prev(overwritten);
+    auto previousEntry = _spilledEntries.find(previous->second);
+    if ((previousEntry != _spilledEntries.end()) && ((previous->first + previousEntry->second.bytes) > offset))
+    {
+      overwritten = previous;
+    }
+  }
+  while ((overwritten != _spilledKeys.end()) && (overwritten->first < (offset + bytes)))
+  {
+    auto spilledEntry = _spilledEntries.find(overwritten->second);
+    if (spilledEntry != _spilledEntries.end())
+    {
+      _spilledBytes -= spilledEntry->second.bytes;
+      _spilledEntries.erase(spilledEntry);
+    }
+    overwritten = _spilledKeys.erase(overwritten);
+  }
+
+  writeMat(entry.image, _spillFile.mutableData() + offset);
+  writeMat(entry.mask, _spillFile.mutableData() + offset + maskBegin);
+  _spilledEntries[key] = SpillEntry{offset, offset + maskBegin, entry.image.size(), entry.image.type(),
+                                    entry.mask.size(), entry.mask.type(), bytes};
+  _spilledKeys[offset] = key;
+  _spilledBytes += bytes;
+  _spillCursor = offset + bytes;
+}
+
+void SampleCache::dropSpilled(std::string const& key)
+{
+  auto spilledEntry = _spilledEntries.find(key);
+  if (spilledEntry == _spilledEntries.end())
+  {
+    return;
+  }
+  _spilledKeys.erase(spilledEntry->second.offset);
+  _spilledBytes -= spilledEntry->second.bytes;
+  _spilledEntries.erase(spilledEntry);
+}
+
+bool SampleCache::openSpillFile()
+{
+  if (_isSpillFileFailed)
+  {
+    return false;
+  }
+  std::error_code errorCode;
+  auto directoryPath = _options.spillDirectoryPath.empty() ? fs::temp_directory_path(errorCode).string() : _options.spillDirectoryPath;
+  _spillFilePath = directoryPath + "/unet-training-tool-" +
+                   std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + ".cache";
+  _isSpillFileFailed = errorCode || !_spillFile.create(_spillFilePath, _options.spillBytesLimit);
+  /// The mapping keeps the data, the name is removed at once where the OS allows it, so nothing is left after a crash
+  fs::remove(_spillFilePath, errorCode);
+  return !_isSpillFileFailed;
+}
+
+void SampleCache::closeSpillFile()
+{
+  _spillFile.close();
+  if (!_spillFilePath.empty())
+  {
+    std::error_code errorCode;
+    fs::remove(_spillFilePath, errorCode);
+    _spillFilePath.clear();
+  }
+  _spilledEntries.clear();
+  _spilledKeys.clear();
+  _spilledBytes = 0;
+  _spillCursor = 0;
+}
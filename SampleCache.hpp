@@ -0,0 +1,103 @@
+#pragma once
+
+#include "MappedFile.hpp"
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct SampleCacheOptions
+{
+  uint64_t memoryBytesLimit{uint64_t(1) << 30};
+  /// 0 disables spilling, samples evicted from the memory are dropped
+  uint64_t spillBytesLimit{uint64_t(4) << 30};
+  /// Empty means the temporary directory
+  std::string spillDirectoryPath;
+};
+
+/**
+ * Process wide cache of preprocessed samples (decoded, ROI cropped, downscaled image and its mask), so conversions
+ * repeated in one session which convert the same samples again (into another output directory, or after their
+ * outputs were removed) skip decode and preprocessing. Used by the training dialog when the project sets cache.enabled.
+ * The least recently used samples are evicted from the memory into a spill file mapped into memory,
+ * the spill file is a ring, the oldest spilled samples are overwritten when it is full.
+ * Returned matrices are shared with the cache and must not be modified. Thread safe.
+ */
+class SampleCache
+{
+public:
+  struct Statistics
+  {
+    size_t hitsCount{};
+    size_t missesCount{};
+    uint64_t memoryBytes{};
+    uint64_t spilledBytes{};
+  };
+
+  static auto instance() -> SampleCache&;
+
+  /// Drops the cached samples when the limits or the spill directory change.
+  void configure(SampleCacheOptions const& options);
+  /// The key changes with the modification time of the image or the annotation and with the parameters.
+  static auto keyFor(std::string const& imagePath, std::string const& annotationPath, std::string const& parameters) -> std::string;
+
+  bool find(std::string const& key, cv::Mat& image, cv::Mat& mask);
+  void store(std::string const& key, cv::Mat const& image, cv::Mat const& mask);
+  void clear();
+  auto statistics() const -> Statistics;
+
+private:
+  SampleCache() = default;
+  ~SampleCache();
+
+  struct MemoryEntry
+  {
+    cv::Mat image;
+    cv::Mat mask;
+    uint64_t bytes{};
+    std::list<std::string>::iterator lruPosition;
+  };
+
+  /// Raw pixels of the image and then of the mask in the spill file, both start aligned
+  struct SpillEntry
+  {
+    uint64_t offset{};
+    uint64_t maskOffset{};
+    cv::Size imageSize;
+    int imageType{};
+    cv::Size maskSize;
+    int maskType{};
+    uint64_t bytes{};
+  };
+
+  void insert(std::string const& key, cv::Mat const& image, cv::Mat const& mask);
+  void spill(std::string const& key, MemoryEntry const& entry);
+  /// Forgets the spilled record of the key and its offset, if there is one.
+  void dropSpilled(std::string const& key);
+  bool openSpillFile();
+  void closeSpillFile();
+
+  SampleCacheOptions _options;
+  mutable std::mutex _mutex;
+  /// Most recently used first
+  std::list<std::string> _lru;
+  std::unordered_map<std::string, MemoryEntry> _memoryEntries;
+  uint64_t _memoryBytes{};
+
+  MappedFile _spillFile;
+  std::string _spillFilePath;
+  bool _isSpillFileFailed{};
+  uint64_t _spillCursor{};
+  /// Spilled records by key and their keys by offset, the latter finds the records overwritten by the ring
+  std::unordered_map<std::string, SpillEntry> _spilledEntries;
+  std::map<uint64_t, std::string> _spilledKeys;
+  uint64_t _spilledBytes{};
+
+  size_t _hitsCount{};
+  size_t _missesCount{};
+};
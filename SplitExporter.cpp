@@ -0,0 +1,124 @@
+#include "SplitExporter.hpp"
+#include "LabelMeReader.hpp"
+#include "ProcessingPipeline.hpp"
+
+#ifdef _MSC_VER
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <algorithm>
+#include <set>
+#include <thread>
+
+namespace {
+struct ExportItem
+{
+  DatasetSample sample;
+  std::vector<FileCloner::Method> methods;
+  bool isFailed{};
+};
+
+void exportSample(ExportItem& item, SplitExportOptions const& options)
+{
+  auto const imageFilename = fs::path(item.sample.imagePath).filename().string();
+  auto const annotationFilename = fs::path(item.sample.annotationPath).filename().string();
+  for (auto const& className : SplitExporter::classesOf(item.sample))
+  {
+    auto const classDirectoryPath = options.outputDirectoryPath + "/" + className;
+    auto const imagePath = classDirectoryPath + "/images/" + imageFilename;
+    auto const method = FileCloner::clone(item.sample.imagePath, imagePath, options.isHardlinkAllowed);
+    item.methods.push_back(method);
+    if ((method == FileCloner::Method::Failed) ||
+        !LabelMeReader::copyWithImagePath(item.sample.annotationPath, classDirectoryPath + "/data/" + annotationFilename, imagePath))
+    {
+      item.isFailed = true;
+      return;
+    }
+  }
+}
+} /// end namespace anonymous
+
+auto SplitExporter::classesOf(DatasetSample const& sample) -> std::vector<std::string>
+{
+  if (!sample.isValid || !sample.isLabelMe())
+  {
+    return {};
+  }
+  if (sample.labelsByName.find("trash") != sample.labelsByName.end())
+  {
+    return {"trash"};
+  }
+  std::vector<std::string> classes;
+  for (auto const& classExist : sample.labelsByName)
+  {
+    classes.push_back(classExist.first);
+  }
+  return classes;
+}
+
+auto SplitExporter::exportByClass(std::vector<DatasetSample> samples,
+                                  SplitExportOptions const& options,
+                                  std::atomic<bool> const& isCanceled,
+                                  ProgressCallback const& onProgress) -> Result
+{
+  /// Directories are created once here, not checked again for every sample on the workers
+  std::set<std::string> classes;
+  for (auto const& sample : samples)
+  {
+    auto const sampleClasses = classesOf(sample);
+    classes.insert(sampleClasses.cbegin(), sampleClasses.cend());
+  }
+  for (auto const& className : classes)
+  {
+    fs::create_directories(options.outputDirectoryPath + "/" + className + "/images");
+    fs::create_directories(options.outputDirectoryPath + "/" + className + "/data");
+  }
+
+  auto const threadsCount = (options.threadsCount != 0)
+                            ? options.threadsCount
+                            : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  /// The work is mostly waiting for the filesystem, so more threads than cores keep the storage busy
+  ProcessingPipeline<ExportItem> pipeline(threadsCount * 4);
+  pipeline.addStage([&](ExportItem& item) {
+    try
+    {
+      exportSample(item, options);
+    }
+    catch (std::exception const&)
+    {
+      item.isFailed = true;
+    }
+  }, threadsCount * 2);
+
+  std::vector<ExportItem> items(samples.size());
+  for (size_t i = 0; i < samples.size(); ++i)
+  {
+    items[i].sample = std::move(samples[i]);
+  }
+
+  Result result;
+  size_t processed = 0;
+  auto const total = items.size();
+  pipeline.run(std::move(items), isCanceled, [&](ExportItem&& item) {
+    for (auto const method : item.methods)
+    {
+      result.hardlinksCount += (method == FileCloner::Method::Hardlink) ? 1 : 0;
+      result.reflinksCount += (method == FileCloner::Method::Reflink) ? 1 : 0;
+      result.copiesCount += (method == FileCloner::Method::Copy) ? 1 : 0;
+    }
+    if (item.isFailed)
+    {
+      result.failedAnnotations.emplace_back(item.sample.annotationPath);
+    }
+    else if (!item.methods.empty())
+    {
+      ++result.exportedCount;
+    }
+    onProgress(++processed, total);
+  });
+  return result;
+}
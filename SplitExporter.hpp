@@ -0,0 +1,45 @@
+#pragma once
+
+#include "DatasetIndexer.hpp"
+#include "FileCloner.hpp"
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct SplitExportOptions
+{
+  std::string outputDirectoryPath;
+  /// 0 means the count of hardware threads
+  size_t threadsCount{0};
+  /// Hard links share the file with the dataset, they are the cheapest but an edit of one shows in both
+  bool isHardlinkAllowed{true};
+};
+
+/**
+ * Exports indexed "labelme" samples into "<output>/<class>/images" and "<output>/<class>/data", once per class
+ * present in the sample ("trash" samples go to "trash" only). Images are cloned (FileCloner), annotations are
+ * written in one pass with imagePath pointing to the exported image. Samples are exported in parallel.
+ */
+struct SplitExporter
+{
+  /// Called on the calling thread in the samples order.
+  using ProgressCallback = std::function<void(size_t processed, size_t total)>;
+
+  struct Result
+  {
+    size_t exportedCount{};
+    size_t hardlinksCount{};
+    size_t reflinksCount{};
+    size_t copiesCount{};
+    std::vector<std::string> failedAnnotations;
+  };
+
+  static auto exportByClass(std::vector<DatasetSample> samples,
+                            SplitExportOptions const& options,
+                            std::atomic<bool> const& isCanceled,
+                            ProgressCallback const& onProgress) -> Result;
+  /// Class directories the sample is exported to, empty for invalid and not "labelme" samples.
+  static auto classesOf(DatasetSample const& sample) -> std::vector<std::string>;
+};
@@ -1,7 +1,9 @@
 #include "StartTrainingDialog.hpp"
 #include "ProjectFile.hpp"
-
-#include <third_party/UNetDarknetTorch/include/UNet/TrainUnet2D.hpp>
+#include "DatasetConverter.hpp"
+#include "DatasetIndexCache.hpp"
+#include "ProjectWorkflow.hpp"
+#include "TrainingMonitorDialog.hpp"
 
 #include <QtWidgets>
 
@@ -12,7 +14,6 @@
 namespace fs = std::filesystem;
 #else
 #include <experimental/filesystem>
-#include <opencv_unet/UNet.hpp>
 
 namespace fs = std::experimental::filesystem;
 #endif
@@ -37,6 +38,8 @@ StartTrainingDialog::StartTrainingDialog(std::string const& projectFileName, QWi
   setWindowTitle(tr("Start training dialog"));
 
   boost::property_tree::read_json(_projectFileName, _pt);
+  _projectSaver = std::make_unique<ProjectSaver>(_projectFileName, _pt);
+  connect(this, &QDialog::finished, _projectSaver.get(), &ProjectSaver::flush);
 
   if (!_pt.get_optional<uint32_t>("UNet.inputChannels").is_initialized())
   {
@@ -44,7 +47,8 @@ StartTrainingDialog::StartTrainingDialog(std::string const& projectFileName, QWi
   }
   if (!_pt.get_optional<uint32_t>("UNet.outputChannels").is_initialized())
   {
-    _pt.put<uint32_t>("UNet.outputChannels", 1);
+    /// One output channel per class
+    _pt.put<uint32_t>("UNet.outputChannels", std::max<uint32_t>(static_cast<uint32_t>(ProjectFile::loadColors(_pt).size()), 1));
   }
   if (!_pt.get_optional<uint32_t>("UNet.layersCount").is_initialized())
   {
@@ -54,32 +58,32 @@ StartTrainingDialog::StartTrainingDialog(std::string const& projectFileName, QWi
   {
     _pt.put<uint32_t>("UNet.featuresCount", 3);
   }
-  boost::property_tree::write_json(_projectFileName, _pt);
+  _projectSaver->scheduleSave();
 
   auto inputChannelsComboBox = createComboBox({"1", "3"},this);
   connect(inputChannelsComboBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), [this](int index) {
     _pt.put<uint32_t>("UNet.inputChannels", index == 0 ? 1 : 3);
-    boost::property_tree::write_json(_projectFileName, _pt);
+    _projectSaver->scheduleSave();
   });
 
   auto outputChannelsSpinBox = new QSpinBox{this};
   outputChannelsSpinBox->setSingleStep(1);
-  outputChannelsSpinBox->setValue(_pt.get<uint32_t>("UNet.outputChannels", 1));
   outputChannelsSpinBox->setMinimum(1);
   outputChannelsSpinBox->setMaximum(256);
+  outputChannelsSpinBox->setValue(_pt.get<uint32_t>("UNet.outputChannels", 1));
   connect(outputChannelsSpinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), [this](int value) {
     _pt.put<uint32_t>("UNet.outputChannels", value);
-    boost::property_tree::write_json(_projectFileName, _pt);
+    _projectSaver->scheduleSave();
   });
 
   auto levelsCountSpinBox = new QSpinBox{this};
   levelsCountSpinBox->setSingleStep(1);
+  levelsCountSpinBox->setMinimum(1);
+  levelsCountSpinBox->setMaximum(16);
   levelsCountSpinBox->setValue(_pt.get<uint32_t>("UNet.layersCount", 1));
-  outputChannelsSpinBox->setMinimum(1);
-  outputChannelsSpinBox->setMaximum(16);
   connect(levelsCountSpinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), [this](int value) {
     _pt.put<uint32_t>("UNet.layersCount", value);
-    boost::property_tree::write_json(_projectFileName, _pt);
+    _projectSaver->scheduleSave();
   });
 
   auto featuresCountPowSpinBox = new QSpinBox{this};
@@ -87,7 +91,7 @@ StartTrainingDialog::StartTrainingDialog(std::string const& projectFileName, QWi
   featuresCountPowSpinBox->setValue(std::log2(_pt.get<uint32_t>("UNet.featuresCount", 8)));
   connect(featuresCountPowSpinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), [this](int value) {
     _pt.put<uint32_t>("UNet.featuresCount", (1 << value));
-    boost::property_tree::write_json(_projectFileName, _pt);
+    _projectSaver->scheduleSave();
   });
 
   auto heightDownscaleSpinBox = new QSpinBox{this};
@@ -97,7 +101,7 @@ StartTrainingDialog::StartTrainingDialog(std::string const& projectFileName, QWi
   heightDownscaleSpinBox->setMaximum(16);
   connect(heightDownscaleSpinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), [this](int value) {
     _pt.put<uint32_t>("UNet.heightDownscale", value);
-    boost::property_tree::write_json(_projectFileName, _pt);
+    _projectSaver->scheduleSave();
   });
 
   auto widthDownscaleSpinBox = new QSpinBox{this};
@@ -107,7 +111,7 @@ StartTrainingDialog::StartTrainingDialog(std::string const& projectFileName, QWi
   widthDownscaleSpinBox->setMaximum(16);
   connect(widthDownscaleSpinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), [this](int value) {
     _pt.put<uint32_t>("UNet.widthDownscale", value);
-    boost::property_tree::write_json(_projectFileName, _pt);
+    _projectSaver->scheduleSave();
   });
 
   auto epochsCountSpinBox = new QSpinBox{this};
@@ -117,7 +121,7 @@ StartTrainingDialog::StartTrainingDialog(std::string const& projectFileName, QWi
   epochsCountSpinBox->setMaximum(100000);
   connect(epochsCountSpinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), [this](int value) {
     _pt.put<uint32_t>("UNet.epochsCount", value);
-    boost::property_tree::write_json(_projectFileName, _pt);
+    _projectSaver->scheduleSave();
   });
 
   auto startTrainingButton = new QPushButton(tr("Start training"), this);
@@ -128,13 +132,127 @@ StartTrainingDialog::StartTrainingDialog(std::string const& projectFileName, QWi
   connect(weightsFilePathButton, &QAbstractButton::clicked, [this](){
       auto weightsFilePath = QFileDialog::getOpenFileName(this, tr("Select weights file"),".",tr("Darknet weights (*.weights)")).toStdString();
       _pt.put<std::string>("UNet.weightsFilePath", weightsFilePath);
-      boost::property_tree::write_json(_projectFileName, _pt);
+      _projectSaver->scheduleSave();
   });
   auto isEvalCheckBox = new QCheckBox(tr("Evaluation only"), this);
   connect(isEvalCheckBox, &QCheckBox::clicked, [this](bool isChecked){
       _pt.put<bool>("UNet.evaluationOnly", isChecked);
-      boost::property_tree::write_json(_projectFileName, _pt);
+      _projectSaver->scheduleSave();
+  });
+  auto isResumedCheckBox = new QCheckBox(tr("Resume from the latest checkpoint"), this);
+  isResumedCheckBox->setToolTip(tr("Continue training the current network instead of generating a new one"));
+  isResumedCheckBox->setChecked(_pt.get<bool>("UNet.resumeFromCheckpoint", false));
+  connect(isResumedCheckBox, &QCheckBox::clicked, [this](bool isChecked){
+      _pt.put<bool>("UNet.resumeFromCheckpoint", isChecked);
+      _projectSaver->scheduleSave();
   });
+  auto isClassIndexMasksCheckBox = new QCheckBox(tr("Class index masks"), this);
+  isClassIndexMasksCheckBox->setToolTip(tr("Write single channel masks with class indices instead of class colors"));
+  isClassIndexMasksCheckBox->setChecked(_pt.get<bool>("UNet.classIndexMasks", false));
+  /// Training refuses class index masks the trainer does not read, a project which has them could only turn them off
+  auto const isClassIndexMasksTrainable = ProjectWorkflow::isClassIndexMasksTrainable();
+  if (!isClassIndexMasksTrainable)
+  {
+    isClassIndexMasksCheckBox->setToolTip(tr("The trainer of this build does not read class index masks"));
+    isClassIndexMasksCheckBox->setEnabled(isClassIndexMasksCheckBox->isChecked());
+  }
+  connect(isClassIndexMasksCheckBox, &QCheckBox::clicked, [this, isClassIndexMasksCheckBox, isClassIndexMasksTrainable](bool isChecked){
+      _pt.put<bool>("UNet.classIndexMasks", isChecked);
+      _projectSaver->scheduleSave();
+      isClassIndexMasksCheckBox->setEnabled(isClassIndexMasksTrainable || isChecked);
+  });
+  auto isRoiEnabledCheckBox = new QCheckBox(tr("Crop by ROI detector"), this);
+  isRoiEnabledCheckBox->setChecked(_pt.get<bool>("ROI.enabled", false));
+  connect(isRoiEnabledCheckBox, &QCheckBox::clicked, [this](bool isChecked){
+      _pt.put<bool>("ROI.enabled", isChecked);
+      _projectSaver->scheduleSave();
+  });
+  auto roiModelFilePathButton = new QPushButton(tr("ROI model path"), this);
+  connect(roiModelFilePathButton, &QAbstractButton::clicked, [this](){
+      auto modelFilePath = QFileDialog::getOpenFileName(this, tr("Select ROI model file"),".",tr("Darknet config (*.cfg)")).toStdString();
+      if (!modelFilePath.empty())
+      {
+        _pt.put<std::string>("ROI.modelFilePath", modelFilePath);
+        _projectSaver->scheduleSave();
+      }
+  });
+  auto roiWeightsFilePathButton = new QPushButton(tr("ROI weights path"), this);
+  connect(roiWeightsFilePathButton, &QAbstractButton::clicked, [this](){
+      auto weightsFilePath = QFileDialog::getOpenFileName(this, tr("Select ROI weights file"),".",tr("Darknet weights (*.weights)")).toStdString();
+      if (!weightsFilePath.empty())
+      {
+        _pt.put<std::string>("ROI.weightsFilePath", weightsFilePath);
+        _projectSaver->scheduleSave();
+      }
+  });
+  auto roiThresholdSpinBox = new QDoubleSpinBox{this};
+  roiThresholdSpinBox->setRange(0.0, 1.0);
+  roiThresholdSpinBox->setDecimals(3);
+  roiThresholdSpinBox->setSingleStep(0.01);
+  auto roiThresholds = _pt.get_child_optional("ROI.thresholds");
+  roiThresholdSpinBox->setValue((roiThresholds.is_initialized() && !roiThresholds->empty())
+                                ? roiThresholds->front().second.get_value<double>()
+                                : 0.99);
+  connect(roiThresholdSpinBox, static_cast<void (QDoubleSpinBox::*)(double)>(&QDoubleSpinBox::valueChanged), [this](double value) {
+    bp::ptree thresholds;
+    bp::ptree threshold;
+    threshold.put_value(value);
+    thresholds.push_back(bp::ptree::value_type("", threshold));
+    _pt.put_child("ROI.thresholds", thresholds);
+    _projectSaver->scheduleSave();
+  });
+
+  /// Every class of the project is trained by one network, with its own threshold and loss weight
+  auto const classesColors = ProjectFile::loadColors(_pt);
+  auto classSettings = ProjectFile::loadClassSettings(_pt);
+  auto classSettingsTable = new QTableWidget(static_cast<int>(classesColors.size()), 3, this);
+  classSettingsTable->setHorizontalHeaderLabels({tr("Class name"), tr("Threshold"), tr("Weight")});
+  classSettingsTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+  classSettingsTable->verticalHeader()->hide();
+  /// Training refuses weights other than 1 the trainer does not accept, such a weight could only be set back to 1
+  auto const isClassWeightsTrainable = ProjectWorkflow::isClassWeightsTrainable();
+  int classRow = 0;
+  for (auto const& classColor : classesColors)
+  {
+    auto const& settings = classSettings[classColor.first];
+    auto classNameItem = new QTableWidgetItem(QString::fromStdString(classColor.first));
+    classNameItem->setFlags(classNameItem->flags() & ~Qt::ItemIsEditable);
+    classNameItem->setBackground(QColor(classColor.second[2], classColor.second[1], classColor.second[0]));
+    classSettingsTable->setItem(classRow, 0, classNameItem);
+    auto thresholdSpinBox = new QDoubleSpinBox(classSettingsTable);
+    thresholdSpinBox->setRange(0.01, 0.99);
+    thresholdSpinBox->setDecimals(3);
+    thresholdSpinBox->setSingleStep(0.01);
+    thresholdSpinBox->setValue(settings.threshold);
+    connect(thresholdSpinBox, static_cast<void (QDoubleSpinBox::*)(double)>(&QDoubleSpinBox::valueChanged), [this, className = classColor.first](double value) {
+      auto settings = ProjectFile::loadClassSettings(_pt);
+      settings[className].threshold = static_cast<float>(value);
+      ProjectFile::saveClassSettings(_pt, settings);
+      _projectSaver->scheduleSave();
+    });
+    classSettingsTable->setCellWidget(classRow, 1, thresholdSpinBox);
+    auto weightSpinBox = new QDoubleSpinBox(classSettingsTable);
+    weightSpinBox->setRange(0.01, 100.0);
+    weightSpinBox->setDecimals(2);
+    weightSpinBox->setSingleStep(0.1);
+    weightSpinBox->setValue(settings.weight);
+    if (!isClassWeightsTrainable)
+    {
+      weightSpinBox->setToolTip(tr("The trainer of this build does not accept class weights"));
+      weightSpinBox->setEnabled(settings.weight != 1.0f);
+    }
+    connect(weightSpinBox, static_cast<void (QDoubleSpinBox::*)(double)>(&QDoubleSpinBox::valueChanged),
+            [this, weightSpinBox, isClassWeightsTrainable, className = classColor.first](double value) {
+      auto settings = ProjectFile::loadClassSettings(_pt);
+      settings[className].weight = static_cast<float>(value);
+      ProjectFile::saveClassSettings(_pt, settings);
+      _projectSaver->scheduleSave();
+      weightSpinBox->setEnabled(isClassWeightsTrainable || (settings[className].weight != 1.0f));
+    });
+    classSettingsTable->setCellWidget(classRow++, 2, weightSpinBox);
+  }
+  outputChannelsSpinBox->setToolTip(tr("One channel per class, the project has %n classes", nullptr, static_cast<int>(classesColors.size())));
+
   auto mainLayout = new QGridLayout;
   mainLayout->addWidget(new QLabel(tr("Input channels count:")), 0, 0);
   mainLayout->addWidget(inputChannelsComboBox, 0, 1);
@@ -152,8 +270,18 @@ StartTrainingDialog::StartTrainingDialog(std::string const& projectFileName, QWi
   mainLayout->addWidget(epochsCountSpinBox, 6, 1);
   mainLayout->addWidget(new QLabel(tr("Weights file path:")), 7, 0);
   mainLayout->addWidget(weightsFilePathButton, 7, 1);
-  mainLayout->addWidget(isEvalCheckBox, 8, 0);
-  mainLayout->addWidget(startTrainingButton, 9, 0);
+  mainLayout->addWidget(isRoiEnabledCheckBox, 8, 0);
+  mainLayout->addWidget(new QLabel(tr("ROI model file path:")), 9, 0);
+  mainLayout->addWidget(roiModelFilePathButton, 9, 1);
+  mainLayout->addWidget(new QLabel(tr("ROI weights file path:")), 10, 0);
+  mainLayout->addWidget(roiWeightsFilePathButton, 10, 1);
+  mainLayout->addWidget(new QLabel(tr("ROI threshold:")), 11, 0);
+  mainLayout->addWidget(roiThresholdSpinBox, 11, 1);
+  mainLayout->addWidget(isClassIndexMasksCheckBox, 12, 0);
+  mainLayout->addWidget(isEvalCheckBox, 13, 0);
+  mainLayout->addWidget(isResumedCheckBox, 14, 0);
+  mainLayout->addWidget(classSettingsTable, 15, 0, 1, 2);
+  mainLayout->addWidget(startTrainingButton, 16, 0);
 
   setLayout(mainLayout);
 }
@@ -169,33 +297,48 @@ void StartTrainingDialog::trainingProcess()
     return;
   }
 
-  QString dir = QFileDialog::getExistingDirectory(this, tr("Open directory for saving generated network"),
-                                                  ".",
-                                                  QFileDialog::ShowDirsOnly | QFileDialog::DontResolveSymlinks);
-  if (dir.isEmpty())
+  auto problem = ProjectWorkflow::validateClasses(_pt);
+  if (problem.empty())
+  {
+    problem = ProjectWorkflow::validateTrainerSupport(_pt);
+  }
+  if (!problem.empty())
+  {
+    QMessageBox msgBox;
+    msgBox.setText(QString::fromStdString(problem));
+    msgBox.exec();
+    return;
+  }
+
+  /// A resumed run keeps the network, its checkpoints are next to the model file
+  auto const isResumed = _pt.get<bool>("UNet.resumeFromCheckpoint", false);
+  if (isResumed && ProjectWorkflow::latestCheckpoint(_pt).empty())
   {
     QMessageBox msgBox;
-    msgBox.setText("Should be selected folder for saving model!");
+    msgBox.setText("Could not be found any checkpoint of the current network to resume from!");
     msgBox.exec();
     return;
   }
-  auto modelFilePath = dir.toStdString() + "/unet_" +
-                       _pt.get<std::string>("UNet.inputChannels", "1") + "c" +
-                       _pt.get<std::string>("UNet.outputChannels", "7") + "cl" +
-                       _pt.get<std::string>("UNet.layersCount", "4") + "l" +
-                       _pt.get<std::string>("UNet.featuresCount", "5") + "f" + ".cfg";
-  auto weightsFilePath = _pt.get<std::string>("UNet.weightsFilePath", "");
-  _pt.put<std::string>("UNet.modelFilePath", modelFilePath);
-  boost::property_tree::write_json(_projectFileName, _pt);
-  runOpts({{std::string("--generate-custom-unet"), {
-                                                     _pt.get<std::string>("UNet.inputChannels"),
-                                                     _pt.get<std::string>("UNet.outputChannels"),
-                                                     _pt.get<std::string>("UNet.layersCount"),
-                                                     _pt.get<std::string>("UNet.featuresCount"),
-                                                     dir.toStdString()}}});
+  if (!isResumed)
+  {
+    QString dir = QFileDialog::getExistingDirectory(this, tr("Open directory for saving generated network"),
+                                                    ".",
+                                                    QFileDialog::ShowDirsOnly | QFileDialog::DontResolveSymlinks);
+    if (dir.isEmpty())
+    {
+      QMessageBox msgBox;
+      msgBox.setText("Should be selected folder for saving model!");
+      msgBox.exec();
+      return;
+    }
+    ProjectWorkflow::generateModel(_pt, dir.toStdString());
+    _projectSaver->scheduleSave();
+    _projectSaver->flush();
+  }
 
+  /// The same directory is offered again, only changed samples are converted into it
   auto convertedDatasetDir = QFileDialog::getExistingDirectory(this, tr("Open directory for saving converted dataset"),
-                                                               ".",
+                                                               QString::fromStdString(_pt.get<std::string>("UNet.convertedDatasetPath", ".")),
                                                                QFileDialog::ShowDirsOnly | QFileDialog::DontResolveSymlinks);
   if (convertedDatasetDir.isEmpty())
   {
@@ -204,125 +347,61 @@ void StartTrainingDialog::trainingProcess()
     msgBox.exec();
     return;
   }
+  _pt.put<std::string>("UNet.convertedDatasetPath", convertedDatasetDir.toStdString());
+  _projectSaver->scheduleSave();
 #if 1
-  fs::create_directories(convertedDatasetDir.toStdString() + "/masksT");
-  fs::create_directories(convertedDatasetDir.toStdString() + "/imagesT");
-  fs::create_directories(convertedDatasetDir.toStdString() + "/masksV");
-  fs::create_directories(convertedDatasetDir.toStdString() + "/imagesV");
-
-  auto const isClahe = false;
-  auto const heightDownscale = _pt.get<uint32_t>("UNet.heightDownscale");
-  auto const widthDownscale = _pt.get<uint32_t>("UNet.widthDownscale");
-  auto const initialFeatureCount = _pt.get<uint32_t>("UNet.featuresCount");
-  auto colorToClass = ProjectFile::loadColors(_pt);
-
-  /// Getting whole list
-  std::vector<std::pair<std::string, std::string>> wholeDatasetList;
-  for (auto const& datasetFolderPath : datasetFolderPathes.get())
+  auto conversionOptions = ProjectWorkflow::conversionOptions(_pt, convertedDatasetDir.toStdString());
+  /// Off unless the project asks for it: unchanged samples are skipped by the incremental conversion before
+  /// the cache is looked up, so it pays off only when the same samples are converted into other directories
+  conversionOptions.isSampleCacheUsed = _pt.get<bool>("cache.enabled", false);
+  if (conversionOptions.isSampleCacheUsed)
   {
-      auto annotations = datasetFolderPath.second.get_optional<std::string>("annotations");
-      auto images = datasetFolderPath.second.get_optional<std::string>("images");
-      if (!annotations.is_initialized() || !images.is_initialized())
-      {
-          continue;
-      }
-      for (auto const& file : fs::directory_iterator{images.get()})
-      {
-          if (fs::is_directory(file))
-          {
-              continue;
-          }
-          auto filename = file.path().filename().string();
-          filename = filename.substr(0, filename.size() - 4);
-          wholeDatasetList.emplace_back(std::make_pair(file.path().string(), annotations.get() + "/" + filename + ".json"));
-      }
+    SampleCache::instance().configure(ProjectWorkflow::sampleCacheOptions(_pt));
   }
-  std::random_device rd;
-  std::mt19937 g(rd());
-  std::shuffle(wholeDatasetList.begin(), wholeDatasetList.end(), g);
-  ////
+  else
+  {
+    SampleCache::instance().clear();
+  }
+  /// The split is kept in the project, so samples do not move between the splits from run to run
+  auto wholeDatasetList = ProjectWorkflow::conversionSamples(_pt, DatasetIndexCache::indexFilePathForProject(_projectFileName));
+  _projectSaver->scheduleSave();
 
-  UNet unet{"/home/oleksandr/WORK/09_05_2021/unet_training_tool/unet_3c1cl3l8f.cfg",
-            "/home/oleksandr/WORK/09_05_2021/unet_training_tool/checkpoints_3c1cl3l8f/best_28.weights",
-            cv::Size{8, 8},
-            std::vector<float>{0.99},
-            true};
+  DatasetConverter::RoiCallback roiCallback;
+  if (!ProjectWorkflow::roiCallback(_pt, roiCallback))
+  {
+    QMessageBox msgBox;
+    msgBox.setText(QString::fromStdString("Could not be loaded ROI model: " + _pt.get<std::string>("ROI.modelFilePath", "")));
+    msgBox.exec();
+    return;
+  }
+  QElapsedTimer conversionTimer;
+  conversionTimer.start();
   QProgressDialog progressDialog(this);
   progressDialog.setCancelButtonText(tr("&Cancel"));
   progressDialog.setRange(0, wholeDatasetList.size());
   progressDialog.setWindowTitle(tr("Counting labels"));
 
-  auto currentLabel = 0;
-  for (auto const& datasetItem : wholeDatasetList)
+  std::atomic<bool> isCanceled{false};
+  auto conversionResult = DatasetConverter::convert(std::move(wholeDatasetList),
+                                                    conversionOptions,
+                                                    roiCallback,
+                                                    isCanceled,
+                                                    [&](size_t processed, size_t total) {
+                                                      progressDialog.setValue(static_cast<int>(processed));
+                                                      progressDialog.setLabelText(tr("Processed label number %1 of %n ...", nullptr, static_cast<int>(total)).arg(processed));
+                                                      QCoreApplication::processEvents();
+                                                      isCanceled = progressDialog.wasCanceled();
+                                                    });
+  if (!conversionResult.failedAnnotations.empty())
   {
-      cv::Mat mask = ConvertPolygonsToMask(datasetItem.second, colorToClass);
-      if (mask.empty())
-      {
-          QMessageBox msgBox;
-          msgBox.setText(QString("Could not be gotten mask from annotation file: ") + QString::fromStdString(datasetItem.second));
-          msgBox.exec();
-          continue;
-      }
-      /////////////////////
-      cv::Rect unionBox;
-      cv::Mat frame = cv::imread(datasetItem.first);
-      std::vector<cv::Mat> predictedImages = unet.performPrediction(frame, [](std::vector<cv::Mat> const&){}, true, false);
-      auto boundingBoxesAll = UNet::foundBoundingBoxes(predictedImages);
-      for (auto& boundingBoxesClass : boundingBoxesAll) {
-          std::sort(boundingBoxesClass.begin(), boundingBoxesClass.end(), [](auto& a, auto& b){
-              return a.area() > b.area();
-          });
-          for(auto const& boundingBox : boundingBoxesClass) {
-              unionBox |= boundingBox;
-              break;
-          }
-      }
-      //cv::rectangle(frame, unionBox, cv::Scalar(255, 255, 255), 4);
-      /////////////////////
-      cv::resize(mask, mask, cv::Size((mask.cols) / widthDownscale, (((uint32_t)mask.rows) / heightDownscale)), 0, 0, cv::INTER_NEAREST);
-      unionBox.width /= widthDownscale;
-      unionBox.height /= heightDownscale;
-      auto truncatedCols = mask.cols & (~(initialFeatureCount - 1));
-      auto truncatedRows = mask.rows & (~(initialFeatureCount - 1));
-      auto const fractWidth = initialFeatureCount - (unionBox.width % initialFeatureCount);
-      auto const fractHeight = initialFeatureCount - (unionBox.height % initialFeatureCount);
-      unionBox.width -= initialFeatureCount - fractWidth;
-      unionBox.height += fractHeight;
-      auto const sizeSubY = 0;
-      auto const sizeSubX = 0;
-      auto const offsetX = 0;
-      auto const offsetY = 0;
-      auto roi = unionBox.empty()
-              ? cv::Rect(((mask.cols - truncatedCols) / 2) + offsetX,
-                         ((mask.rows - truncatedRows) / 2) + offsetY,
-                         truncatedCols - sizeSubX,
-                         truncatedRows - sizeSubY)
-              : unionBox;
-
-      auto isTraining = currentLabel > wholeDatasetList.size() * 0.1f;
-      cv::Mat maskCropped = roi.empty() ? mask : mask(roi);
-      auto filename = fs::path(datasetItem.first).filename().replace_extension("png").string();
-      cv::imwrite(convertedDatasetDir.toStdString() + "/masks" + (isTraining ? "T/" : "V/") + filename, maskCropped);
-
-      cv::Mat image = cv::imread(datasetItem.first);
-      cv::resize(image, image, cv::Size((image.cols / widthDownscale), (image.rows / heightDownscale)), 0, 0, cv::INTER_NEAREST);
-      if (isClahe)
-      {
-          auto clahe = cv::createCLAHE();
-          cv::cvtColor(image, image, cv::COLOR_BGR2GRAY);
-          clahe->apply(image, image);
-      }
-      cv::Mat imageCropped = roi.empty() ? image : image(roi);
-      cv::imwrite(convertedDatasetDir.toStdString() + "/images" + (isTraining ? "T/" : "V/") + filename, imageCropped);
-
-      progressDialog.setValue(currentLabel);
-      progressDialog.setLabelText(tr("Processed label number %1 of %n ...", nullptr, wholeDatasetList.size()).arg(currentLabel++));
-      QCoreApplication::processEvents();
-
-      if (progressDialog.wasCanceled())
+      std::string text = "Could not be converted the following annotation files:";
+      for (auto const& failedAnnotation : conversionResult.failedAnnotations)
       {
-          break;
+          text += "\n" + failedAnnotation;
       }
+      QMessageBox msgBox;
+      msgBox.setText(QString::fromStdString(text));
+      msgBox.exec();
   }
 #if 0
   auto currentLabel = 0;
@@ -391,43 +470,19 @@ void StartTrainingDialog::trainingProcess()
   }
 #endif
 #endif
-  QMessageBox msgBox;
-  msgBox.setText("Are you ready to train?");
-  msgBox.exec();
+  auto const conversionMs = conversionTimer.elapsed();
 
-  auto colorsToClassMap = ProjectFile::loadColors(_pt);
-  std::map<std::string, std::vector<std::string>> params;
-  for (auto const& colorToClass : colorsToClassMap)
+  /// The trainer runs in the command line tool, it reads the saved project
+  _projectSaver->flush();
+  QStringList arguments{"train", QString::fromStdString(_projectFileName), "--converted", convertedDatasetDir};
+  if (_pt.get<bool>("UNet.evaluationOnly", false))
   {
-    params["--colors-to-class-map"].emplace_back(colorToClass.first);
-    params["--colors-to-class-map"].emplace_back(std::to_string(colorToClass.second[2]));
-    params["--colors-to-class-map"].emplace_back(std::to_string(colorToClass.second[1]));
-    params["--colors-to-class-map"].emplace_back(std::to_string(colorToClass.second[0]));
-    params["--selected-classes-and-thresholds"].emplace_back(colorToClass.first);
-    params["--selected-classes-and-thresholds"].emplace_back("0.3");
-    // TODO: tempoarry hack
-    break;
+    arguments << "--eval";
   }
-  params["--eval"] = {_pt.get<bool>("UNet.evaluationOnly") ? "yes" : "no"};
-  params["--epochs"] = {std::to_string(_pt.get<uint32_t>("UNet.epochsCount"))};
-  fs::create_directories(modelFilePath + "_checkpoints");
-  params["--checkpoints-output"] = {modelFilePath + "_checkpoints"};
-  params["--train-directories"] = {convertedDatasetDir.toStdString() + "/imagesT/",convertedDatasetDir.toStdString() + "/masksT/"};
-  params["--valid-directories"] = {convertedDatasetDir.toStdString() + "/imagesV/",convertedDatasetDir.toStdString() + "/masksV/"};
-  if (weightsFilePath.empty())
+  if (isResumed)
   {
-      params["--model-darknet"] = {modelFilePath};
+    arguments << "--resume";
   }
-  else
-  {
-      params["--model-darknet"] = {modelFilePath, weightsFilePath};
-  }
-
-  params["--size-downscaled"] = {"0","0"};
-  params["--grayscale"] = {(_pt.get<uint32_t>("UNet.inputChannels") == 1) ? "yes" : "no"};
-  runOpts(params);
-
-  QMessageBox msgBox1;
-  msgBox1.setText("Not implemented to be continued!");
-  msgBox1.exec();
+  TrainingMonitorDialog monitorDialog(arguments, {{tr("conversion"), conversionMs}}, _pt.get<uint32_t>("UNet.epochsCount", 200), this);
+  monitorDialog.exec();
 }
@@ -3,9 +3,13 @@
 #include <QDialog>
 #include <QDir>
 
+#include "ProjectSaver.hpp"
+
 #include <opencv2/core/types.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include <memory>
+
 QT_BEGIN_NAMESPACE
 class QComboBox;
 class QLabel;
@@ -28,4 +32,5 @@ private:
 public:
   std::string _projectFileName;
   boost::property_tree::ptree _pt;
+  std::unique_ptr<ProjectSaver> _projectSaver;
 };
@@ -1,7 +1,7 @@
 #include "StartValidatingDialog.hpp"
 #include "ProjectFile.hpp"
-
-#include <third_party/UNetDarknetTorch/include/UNet/TrainUnet2D.hpp>
+#include "ProjectWorkflow.hpp"
+#include "TrainingMonitorDialog.hpp"
 
 #include <QtWidgets>
 
@@ -35,6 +35,8 @@ StartValidatingDialog::StartValidatingDialog(std::string const& projectFileName,
     setWindowTitle(tr("Start validating dialog"));
 
     boost::property_tree::read_json(_projectFileName, _pt);
+    _projectSaver = std::make_unique<ProjectSaver>(_projectFileName, _pt);
+    connect(this, &QDialog::finished, _projectSaver.get(), &ProjectSaver::flush);
 
     if (!_pt.get_optional<uint32_t>("UNet.inputChannels").is_initialized())
     {
@@ -52,32 +54,32 @@ StartValidatingDialog::StartValidatingDialog(std::string const& projectFileName,
     {
         _pt.put<uint32_t>("UNet.featuresCount", 3);
     }
-    boost::property_tree::write_json(_projectFileName, _pt);
+    _projectSaver->scheduleSave();
 
     auto inputChannelsComboBox = createComboBox({"1", "3"},this);
     connect(inputChannelsComboBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), [this](int index) {
         _pt.put<uint32_t>("UNet.inputChannels", index == 0 ? 1 : 3);
-        boost::property_tree::write_json(_projectFileName, _pt);
+        _projectSaver->scheduleSave();
     });
 
     auto outputChannelsSpinBox = new QSpinBox{this};
     outputChannelsSpinBox->setSingleStep(1);
-    outputChannelsSpinBox->setValue(_pt.get<uint32_t>("UNet.outputChannels", 1));
     outputChannelsSpinBox->setMinimum(1);
     outputChannelsSpinBox->setMaximum(256);
+    outputChannelsSpinBox->setValue(_pt.get<uint32_t>("UNet.outputChannels", 1));
     connect(outputChannelsSpinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), [this](int value) {
         _pt.put<uint32_t>("UNet.outputChannels", value);
-        boost::property_tree::write_json(_projectFileName, _pt);
+        _projectSaver->scheduleSave();
     });
 
     auto levelsCountSpinBox = new QSpinBox{this};
     levelsCountSpinBox->setSingleStep(1);
+    levelsCountSpinBox->setMinimum(1);
+    levelsCountSpinBox->setMaximum(16);
     levelsCountSpinBox->setValue(_pt.get<uint32_t>("UNet.layersCount", 1));
-    outputChannelsSpinBox->setMinimum(1);
-    outputChannelsSpinBox->setMaximum(16);
     connect(levelsCountSpinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), [this](int value) {
         _pt.put<uint32_t>("UNet.layersCount", value);
-        boost::property_tree::write_json(_projectFileName, _pt);
+        _projectSaver->scheduleSave();
     });
 
     auto featuresCountPowSpinBox = new QSpinBox{this};
@@ -85,7 +87,7 @@ StartValidatingDialog::StartValidatingDialog(std::string const& projectFileName,
     featuresCountPowSpinBox->setValue(std::log2(_pt.get<uint32_t>("UNet.featuresCount", 8)));
     connect(featuresCountPowSpinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), [this](int value) {
         _pt.put<uint32_t>("UNet.featuresCount", (1 << value));
-        boost::property_tree::write_json(_projectFileName, _pt);
+        _projectSaver->scheduleSave();
     });
 
     auto heightDownscaleSpinBox = new QSpinBox{this};
@@ -95,7 +97,7 @@ StartValidatingDialog::StartValidatingDialog(std::string const& projectFileName,
     heightDownscaleSpinBox->setMaximum(16);
     connect(heightDownscaleSpinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), [this](int value) {
         _pt.put<uint32_t>("UNet.heightDownscale", value);
-        boost::property_tree::write_json(_projectFileName, _pt);
+        _projectSaver->scheduleSave();
     });
 
     auto widthDownscaleSpinBox = new QSpinBox{this};
@@ -105,7 +107,7 @@ StartValidatingDialog::StartValidatingDialog(std::string const& projectFileName,
     widthDownscaleSpinBox->setMaximum(16);
     connect(widthDownscaleSpinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), [this](int value) {
         _pt.put<uint32_t>("UNet.widthDownscale", value);
-        boost::property_tree::write_json(_projectFileName, _pt);
+        _projectSaver->scheduleSave();
     });
 
     auto epochsCountSpinBox = new QSpinBox{this};
@@ -115,35 +117,35 @@ StartValidatingDialog::StartValidatingDialog(std::string const& projectFileName,
     epochsCountSpinBox->setMaximum(100000);
     connect(epochsCountSpinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), [this](int value) {
         _pt.put<uint32_t>("UNet.epochsCount", value);
-        boost::property_tree::write_json(_projectFileName, _pt);
+        _projectSaver->scheduleSave();
     });
     auto weightsFilePathButton = new QPushButton(tr("Weights path"), this);
     connect(weightsFilePathButton, &QAbstractButton::clicked, [this](){
         auto weightsFilePath = QFileDialog::getOpenFileName(this, tr("Select weights file"),".",tr("Darknet weights (*.weights)")).toStdString();
         _pt.put<std::string>("UNet.weightsFilePath", weightsFilePath);
-        boost::property_tree::write_json(_projectFileName, _pt);
+        _projectSaver->scheduleSave();
     });
     auto modelFilePathButton = new QPushButton(tr("Model path"), this);
     connect(modelFilePathButton, &QAbstractButton::clicked, [this](){
         auto modelFilePath = QFileDialog::getOpenFileName(this, tr("Select model file"),".",tr("Darknet model (*.cfg)")).toStdString();
         _pt.put<std::string>("UNet.modelFilePath", modelFilePath);
-        boost::property_tree::write_json(_projectFileName, _pt);
+        _projectSaver->scheduleSave();
     });
     auto validDatasetPathButton = new QPushButton(tr("Valid dataset path"), this);
     connect(validDatasetPathButton, &QAbstractButton::clicked, [this](){
         auto validDatasetPath = QFileDialog::getExistingDirectory(this, tr("Open dataset directory"), "", QFileDialog::ShowDirsOnly | QFileDialog::DontResolveSymlinks).toStdString();
         _pt.put<std::string>("UNet.validDatasetPath", validDatasetPath);
-        boost::property_tree::write_json(_projectFileName, _pt);
-    });
-    auto isEvalCheckBox = new QCheckBox(tr("Evaluation only"), this);
-    connect(isEvalCheckBox, &QCheckBox::clicked, [this](bool isChecked){
-        _pt.put<bool>("UNet.evaluationOnly", isChecked);
-        boost::property_tree::write_json(_projectFileName, _pt);
+        _projectSaver->scheduleSave();
     });
+    _sweepCheckBox = new QCheckBox(tr("Sweep thresholds and apply the best IoU ones"), this);
     auto startTrainingButton = new QPushButton(tr("Start validating"), this);
     connect(startTrainingButton, &QAbstractButton::clicked, [this](){
         validatingProcess();
     });
+    auto rankCheckpointsButton = new QPushButton(tr("Rank checkpoints"), this);
+    connect(rankCheckpointsButton, &QAbstractButton::clicked, [this](){
+        rankingProcess();
+    });
     auto mainLayout = new QGridLayout;
     mainLayout->addWidget(new QLabel(tr("Input channels count:")), 0, 0);
     mainLayout->addWidget(inputChannelsComboBox, 0, 1);
@@ -165,38 +167,54 @@ StartValidatingDialog::StartValidatingDialog(std::string const& projectFileName,
     mainLayout->addWidget(weightsFilePathButton, 8, 1);
     mainLayout->addWidget(new QLabel(tr("Valid dataset path:")), 9, 0);
     mainLayout->addWidget(validDatasetPathButton, 9, 1);
-    mainLayout->addWidget(isEvalCheckBox, 10, 0);
+    mainLayout->addWidget(_sweepCheckBox, 10, 0, 1, 2);
     mainLayout->addWidget(startTrainingButton, 11, 0);
+    mainLayout->addWidget(rankCheckpointsButton, 11, 1);
 
     setLayout(mainLayout);
 }
 
 void StartValidatingDialog::validatingProcess()
 {
-    auto modelFilePath = _pt.get<std::string>("UNet.modelFilePath", "");
-    auto weightsFilePath = _pt.get<std::string>("UNet.weightsFilePath", "");
-    auto convertedDatasetDir = _pt.get<std::string>("UNet.validDatasetPath", "");
-    auto colorsToClassMap = ProjectFile::loadColors(_pt);
-    std::map<std::string, std::vector<std::string>> params;
-    for (auto const& colorToClass : colorsToClassMap)
+    auto const problem = ProjectWorkflow::validateClasses(_pt);
+    if (!problem.empty())
+    {
+        QMessageBox msgBox;
+        msgBox.setText(QString::fromStdString(problem));
+        msgBox.exec();
+        return;
+    }
+    /// The tool validates what is saved in the project, UNet.validDatasetPath by default
+    _projectSaver->flush();
+    QStringList arguments{"validate", QString::fromStdString(_projectFileName)};
+    if (_sweepCheckBox->isChecked())
+    {
+        arguments << "--sweep" << "--apply-best" << "iou";
+    }
+    TrainingMonitorDialog monitorDialog(arguments, {}, _pt.get<uint32_t>("UNet.epochsCount", 200), this);
+    monitorDialog.setWindowTitle(tr("Validation"));
+    monitorDialog.exec();
+    if (_sweepCheckBox->isChecked())
+    {
+        /// The tool has stored the thresholds, the next save of the dialog must not bring back the old ones
+        boost::property_tree::read_json(_projectFileName, _pt);
+    }
+}
+
+void StartValidatingDialog::rankingProcess()
+{
+    auto const problem = ProjectWorkflow::validateClasses(_pt);
+    if (!problem.empty())
     {
-        params["--colors-to-class-map"].emplace_back(colorToClass.first);
-        params["--colors-to-class-map"].emplace_back(std::to_string(colorToClass.second[2]));
-        params["--colors-to-class-map"].emplace_back(std::to_string(colorToClass.second[1]));
-        params["--colors-to-class-map"].emplace_back(std::to_string(colorToClass.second[0]));
-        params["--selected-classes-and-thresholds"].emplace_back(colorToClass.first);
-        params["--selected-classes-and-thresholds"].emplace_back("0.3");
-        // TODO: tempoarry hack
-        break;
+        QMessageBox msgBox;
+        msgBox.setText(QString::fromStdString(problem));
+        msgBox.exec();
+        return;
     }
-    params["--eval"] = {"yes"};
-    params["--epochs"] = {std::to_string(_pt.get<uint32_t>("UNet.epochsCount"))};
-    fs::create_directories(modelFilePath + "_checkpoints");
-    params["--checkpoints-output"] = {modelFilePath + "_checkpoints"};
-    params["--train-directories"] = {convertedDatasetDir + "/imagesT/",convertedDatasetDir + "/masksT/"};
-    params["--valid-directories"] = {convertedDatasetDir + "/imagesV/",convertedDatasetDir + "/masksV/"};
-    params["--model-darknet"] = {modelFilePath, weightsFilePath};
-    params["--size-downscaled"] = {"0","0"};
-    params["--grayscale"] = {(_pt.get<uint32_t>("UNet.inputChannels") == 1) ? "yes" : "no"};
-    runOpts(params);
+    _projectSaver->flush();
+    TrainingMonitorDialog monitorDialog({"rank", QString::fromStdString(_projectFileName)}, {}, _pt.get<uint32_t>("UNet.epochsCount", 200), this);
+    monitorDialog.setWindowTitle(tr("Checkpoints ranking"));
+    monitorDialog.exec();
+    /// The tool has stored the leaderboard and the best weights
+    boost::property_tree::read_json(_projectFileName, _pt);
 }
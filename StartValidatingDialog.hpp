@@ -3,10 +3,15 @@
 #include <QDialog>
 #include <QDir>
 
+#include "ProjectSaver.hpp"
+
 #include <opencv2/core/types.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include <memory>
+
 QT_BEGIN_NAMESPACE
+class QCheckBox;
 class QComboBox;
 class QLabel;
 class QPushButton;
@@ -24,8 +29,11 @@ public:
 
 private:
     void validatingProcess();
+    void rankingProcess();
 
 public:
     std::string _projectFileName;
     boost::property_tree::ptree _pt;
+    std::unique_ptr<ProjectSaver> _projectSaver;
+    QCheckBox* _sweepCheckBox{};
 };
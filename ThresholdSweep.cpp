@@ -0,0 +1,175 @@
+#include "ThresholdSweep.hpp"
+#include "ProcessingPipeline.hpp"
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#ifdef _MSC_VER
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+namespace bp = boost::property_tree;
+
+namespace {
+struct SweepItem
+{
+  size_t recordIndex{};
+  /// classes * levelsCount counts of the class pixels and of the rest
+  std::vector<uint64_t> positives;
+  std::vector<uint64_t> negatives;
+};
+
+void countLevels(ProbabilitySample const& sample, SweepItem& item)
+{
+  auto const classesCount = sample.probabilities.size();
+  item.positives.assign(classesCount * ThresholdSweep::levelsCount, 0);
+  item.negatives.assign(classesCount * ThresholdSweep::levelsCount, 0);
+  for (size_t c = 0; c < classesCount; ++c)
+  {
+    auto const label = static_cast<uint8_t>(c + 1);
+    auto positives = item.positives.data() + c * ThresholdSweep::levelsCount;
+    auto negatives = item.negatives.data() + c * ThresholdSweep::levelsCount;
+    for (int y = 0; y < sample.labels.rows; ++y)
+    {
+      auto const labels = sample.labels.ptr<uint8_t>(y);
+      auto const levels = sample.probabilities[c].ptr<uint8_t>(y);
+      for (int x = 0; x < sample.labels.cols; ++x)
+      {
+        ++((labels[x] == label) ? positives : negatives)[levels[x]];
+      }
+    }
+  }
+}
+
+auto pointTree(ThresholdPoint const& point) -> bp::ptree
+{
+  bp::ptree tree;
+  tree.put("threshold", point.threshold);
+  tree.put("f1", point.metrics.dice());
+  tree.put("iou", point.metrics.iou());
+  tree.put("precision", point.metrics.precision());
+  tree.put("recall", point.metrics.recall());
+  return tree;
+}
+} /// end namespace anonymous
+
+auto ThresholdSweep::sweep(ProbabilityCacheReader const& cache,
+                           std::vector<std::string> const& classNames,
+                           size_t threadsCount,
+                           std::atomic<bool> const& isCanceled) -> std::vector<ClassSweep>
+{
+  auto const classesCount = cache.classesCount();
+  std::vector<uint64_t> positives(classesCount * levelsCount);
+  std::vector<uint64_t> negatives(classesCount * levelsCount);
+
+  threadsCount = (threadsCount != 0) ? threadsCount : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  std::vector<SweepItem> items(cache.size());
+  for (size_t i = 0; i < items.size(); ++i)
+  {
+    items[i].recordIndex = i;
+  }
+  ProcessingPipeline<SweepItem> pipeline(threadsCount * 2);
+  pipeline.addStage([&](SweepItem& item) {
+    ProbabilitySample sample;
+    if (cache.read(item.recordIndex, sample))
+    {
+      countLevels(sample, item);
+    }
+  }, threadsCount);
+  pipeline.run(std::move(items), isCanceled, [&](SweepItem&& item) {
+    for (size_t i = 0; i < item.positives.size(); ++i)
+    {
+      positives[i] += item.positives[i];
+      negatives[i] += item.negatives[i];
+    }
+  });
+
+  std::vector<ClassSweep> sweeps(classesCount);
+  for (size_t c = 0; c < classesCount; ++c)
+  {
+    auto& classSweep = sweeps[c];
+    classSweep.className = (c < classNames.size()) ? classNames[c] : std::to_string(c + 1);
+    uint64_t truePixels = 0;
+    for (int level = 0; level < levelsCount; ++level)
+    {
+      truePixels += positives[c * levelsCount + level];
+    }
+    /// Level 0 would predict every pixel, so the sweep starts at the first level
+    classSweep.points.resize(levelsCount - 1);
+    uint64_t truePositives = 0;
+    uint64_t falsePositives = 0;
+    for (int level = levelsCount - 1; level >= 1; --level)
+    {
+      truePositives += positives[c * levelsCount + level];
+      falsePositives += negatives[c * levelsCount + level];
+      auto& point = classSweep.points[level - 1];
+      /// Levels are rounded, level L holds the probabilities from (L - 0.5) / 255
+      point.threshold = (static_cast<float>(level) - 0.5f) / (levelsCount - 1);
+      point.metrics.truePositives = truePositives;
+      point.metrics.falsePositives = falsePositives;
+      point.metrics.falseNegatives = truePixels - truePositives;
+    }
+    for (size_t i = 1; i < classSweep.points.size(); ++i)
+    {
+      if (classSweep.points[i].metrics.dice() > classSweep.points[classSweep.bestF1].metrics.dice())
+      {
+        classSweep.bestF1 = i;
+      }
+      if (classSweep.points[i].metrics.iou() > classSweep.points[classSweep.bestIou].metrics.iou())
+      {
+        classSweep.bestIou = i;
+      }
+    }
+  }
+  return sweeps;
+}
+
+bool ThresholdSweep::saveSweep(std::vector<ClassSweep> const& sweeps, std::string const& directoryPath)
+{
+  std::error_code errorCode;
+  fs::create_directories(directoryPath, errorCode);
+
+  bp::ptree classes;
+  for (auto const& classSweep : sweeps)
+  {
+    bp::ptree item;
+    item.put("className", classSweep.className);
+    if (!classSweep.points.empty())
+    {
+      item.put_child("bestF1", pointTree(classSweep.points[classSweep.bestF1]));
+      item.put_child("bestIou", pointTree(classSweep.points[classSweep.bestIou]));
+    }
+    classes.push_back(bp::ptree::value_type("", item));
+  }
+  bp::ptree tree;
+  tree.put_child("classes", classes);
+
+  std::ofstream jsonFile(directoryPath + "/thresholds.json");
+  std::ofstream sweepFile(directoryPath + "/sweep.csv");
+  if (!jsonFile || !sweepFile)
+  {
+    return false;
+  }
+  bp::write_json(jsonFile, tree);
+
+  sweepFile << "class,threshold,precision,recall,f1,iou,true_positives,false_positives,false_negatives\n";
+  for (auto const& classSweep : sweeps)
+  {
+    for (auto const& point : classSweep.points)
+    {
+      auto const& metrics = point.metrics;
+      sweepFile << classSweep.className << ',' << point.threshold << ',' << metrics.precision() << ',' << metrics.recall() << ','
+                << metrics.dice() << ',' << metrics.iou() << ',' << metrics.truePositives << ',' << metrics.falsePositives << ','
+                << metrics.falseNegatives << '\n';
+    }
+  }
+  return jsonFile.flush() && sweepFile.flush();
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "ProbabilityCache.hpp"
+#include "ValidationMetrics.hpp"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+struct ThresholdPoint
+{
+  float threshold{};
+  /// Pixel counts only, the Dice of them is the F1 score
+  ClassMetrics metrics;
+};
+
+struct ClassSweep
+{
+  std::string className;
+  /// Ascending thresholds, one per quantization level; the precision/recall curve
+  std::vector<ThresholdPoint> points;
+  size_t bestF1{};
+  size_t bestIou{};
+};
+
+/**
+ * Picks per class thresholds from a probability cache of a validation run without running the network again.
+ * Every sample adds its pixels to per class histograms of the quantized probability, one for the pixels
+ * of the class and one for the rest; the counts at every threshold are the suffix sums of the histograms,
+ * so the whole sweep costs one pass over the cache. Samples are counted in parallel and merged on the calling thread.
+ * Probabilities are quantized by rounding, so a level of at least k means a probability of at least (k - 0.5) / 255,
+ * which is the threshold reported for k.
+ */
+struct ThresholdSweep
+{
+  static constexpr int levelsCount = 256;
+
+  /// Classes are the planes of the cache in order, the names are taken for the report only.
+  static auto sweep(ProbabilityCacheReader const& cache,
+                    std::vector<std::string> const& classNames,
+                    size_t threadsCount,
+                    std::atomic<bool> const& isCanceled) -> std::vector<ClassSweep>;
+  /// Writes sweep.csv (every point of every class) and thresholds.json (the best points) into the directory.
+  static bool saveSweep(std::vector<ClassSweep> const& sweeps, std::string const& directoryPath);
+};
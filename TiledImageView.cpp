@@ -0,0 +1,230 @@
+#include "TiledImageView.hpp"
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <QRunnable>
+#include <QThread>
+#include <QWheelEvent>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace {
+/// Pixmaps of recent tiles, in KiB
+constexpr int tilesCacheCost = 256 * 1024;
+constexpr double maxScale = 16.0;
+
+auto tileKey(int level, QPoint tile) -> quint64
+{
+  return (static_cast<quint64>(level) << 48) | (static_cast<quint64>(tile.y()) << 24) | static_cast<quint64>(tile.x());
+}
+
+class RenderTask : public QRunnable
+{
+public:
+  explicit RenderTask(std::function<void()> task)
+    : _task(std::move(task))
+  {
+  }
+
+  void run() override
+  {
+    _task();
+  }
+
+private:
+  std::function<void()> _task;
+};
+} /// end namespace anonymous
+
+TiledImageView::TiledImageView(QWidget* parent)
+  : QWidget(parent)
+  , _tiles(tilesCacheCost)
+  , _isCanceled(std::make_shared<std::atomic<bool>>(false))
+{
+  setBackgroundRole(QPalette::Dark);
+  setAutoFillBackground(true);
+  setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+  _renderPool.setMaxThreadCount(std::max(QThread::idealThreadCount() / 2, 1));
+}
+
+TiledImageView::~TiledImageView()
+{
+  /// Renders post their tiles to this view, they must be done before it is gone
+  cancelRendering();
+  _renderPool.waitForDone();
+}
+
+void TiledImageView::setImage(QImage overview, std::shared_ptr<ImagePyramid> pyramid, QRect roi)
+{
+  cancelRendering();
+  _overview = std::move(overview);
+  _pyramid = std::move(pyramid);
+  _roi = roi;
+  fit();
+}
+
+void TiledImageView::clear()
+{
+  setImage(QImage(), nullptr);
+}
+
+void TiledImageView::paintEvent(QPaintEvent*)
+{
+  auto const size = imageSize();
+  if (size.isEmpty())
+  {
+    return;
+  }
+  QPainter painter(this);
+  painter.setRenderHint(QPainter::SmoothPixmapTransform, _scale < 1.0);
+  painter.scale(_scale, _scale);
+  painter.translate(-_origin);
+  painter.drawImage(QRectF(QPointF(), QSizeF(size)), _overview);
+
+  auto const devicePixelScale = _scale * devicePixelRatioF();
+  if (_pyramid && (_overview.width() < size.width() * devicePixelScale))
+  {
+    auto const level = _pyramid->levelFor(devicePixelScale);
+    auto const tilesCount = _pyramid->tilesCount(level);
+    auto const step = static_cast<double>(ImagePyramid::tileSize << level);
+    auto const visible = QRectF(_origin, QSizeF(width() / _scale, height() / _scale));
+    auto const first = QPoint(std::max(static_cast<int>(visible.left() / step), 0), std::max(static_cast<int>(visible.top() / step), 0));
+    auto const last = QPoint(std::min(static_cast<int>(visible.right() / step), tilesCount.width - 1),
+                             std::min(static_cast<int>(visible.bottom() / step), tilesCount.height - 1));
+    /// Only the tiles of this view are wanted, queued renders of scrolled away ones are dropped
+    _renderPool.clear();
+    _pendingTiles.clear();
+    for (int y = first.y(); y <= last.y(); ++y)
+    {
+      for (int x = first.x(); x <= last.x(); ++x)
+      {
+        auto const tile = QPoint(x, y);
+        if (auto const pixmap = _tiles.object(tileKey(level, tile)))
+        {
+          auto const rect = _pyramid->tileRect(level, cv::Point(x, y));
+          painter.drawPixmap(QRectF(rect.x, rect.y, rect.width, rect.height), *pixmap, QRectF(pixmap->rect()));
+        }
+        else
+        {
+          requestTile(level, tile);
+        }
+      }
+    }
+  }
+
+  if (!_roi.isEmpty())
+  {
+    painter.setPen(QPen(Qt::white, 2.0 / _scale));
+    painter.drawRect(_roi);
+  }
+}
+
+void TiledImageView::resizeEvent(QResizeEvent* event)
+{
+  QWidget::resizeEvent(event);
+  if (_isFitted)
+  {
+    fit();
+  }
+}
+
+void TiledImageView::wheelEvent(QWheelEvent* event)
+{
+  if (imageSize().isEmpty())
+  {
+    return;
+  }
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+  auto const position = event->position();
+#else
+  auto const position = QPointF(event->pos());
+#endif
+  auto const imagePoint = _origin + position / _scale;
+  auto const fitScale = std::min(static_cast<double>(width()) / imageSize().width(), static_cast<double>(height()) / imageSize().height());
+  _scale = std::clamp(_scale * std::pow(1.0015, event->angleDelta().y()), std::min(fitScale, 1.0) / 2.0, maxScale);
+  _origin = imagePoint - position / _scale;
+  _isFitted = false;
+  update();
+}
+
+void TiledImageView::mousePressEvent(QMouseEvent* event)
+{
+  _dragPosition = event->pos();
+}
+
+void TiledImageView::mouseMoveEvent(QMouseEvent* event)
+{
+  if (!(event->buttons() & Qt::LeftButton))
+  {
+    return;
+  }
+  _origin -= QPointF(event->pos() - _dragPosition) / _scale;
+  _dragPosition = event->pos();
+  _isFitted = false;
+  update();
+}
+
+void TiledImageView::mouseDoubleClickEvent(QMouseEvent*)
+{
+  fit();
+}
+
+auto TiledImageView::imageSize() const -> QSize
+{
+  if (_pyramid)
+  {
+    return QSize(_pyramid->imageSize().width, _pyramid->imageSize().height);
+  }
+  return _overview.size();
+}
+
+void TiledImageView::fit()
+{
+  auto const size = imageSize();
+  _isFitted = true;
+  if (!size.isEmpty() && !rect().isEmpty())
+  {
+    _scale = std::min(static_cast<double>(width()) / size.width(), static_cast<double>(height()) / size.height());
+    _origin = -QPointF(width() / _scale - size.width(), height() / _scale - size.height()) / 2.0;
+  }
+  update();
+}
+
+void TiledImageView::cancelRendering()
+{
+  _renderPool.clear();
+  *_isCanceled = true;
+  _isCanceled = std::make_shared<std::atomic<bool>>(false);
+  _pendingTiles.clear();
+  _tiles.clear();
+}
+
+void TiledImageView::requestTile(int level, QPoint tile)
+{
+  auto const key = tileKey(level, tile);
+  if (_pendingTiles.contains(key))
+  {
+    return;
+  }
+  _pendingTiles.insert(key);
+  auto task = new RenderTask([this, pyramid = _pyramid, isCanceled = _isCanceled, level, tile, key]() {
+    auto const frame = pyramid->renderTile(level, cv::Point(tile.x(), tile.y()), *isCanceled);
+    if (frame.empty() || *isCanceled)
+    {
+      return;
+    }
+    auto image = QImage(frame.data, frame.cols, frame.rows, static_cast<int>(frame.step), QImage::Format_BGR888).copy();
+    QMetaObject::invokeMethod(this, [this, pyramid, image, key]() {
+      _pendingTiles.remove(key);
+      /// Pixmaps are made on the GUI thread only
+      if (pyramid == _pyramid)
+      {
+        _tiles.insert(key, new QPixmap(QPixmap::fromImage(image)), static_cast<int>(std::max<qint64>(image.sizeInBytes() / 1024, 1)));
+        update();
+      }
+    }, Qt::QueuedConnection);
+  });
+  _renderPool.start(task);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ImagePyramid.hpp"
+
+#include <QCache>
+#include <QImage>
+#include <QPixmap>
+#include <QSet>
+#include <QThreadPool>
+#include <QWidget>
+
+#include <atomic>
+#include <memory>
+
+/**
+ * Zoomable and pannable view of images of any size. A scaled down overview is shown at once and
+ * covers the fitted view; once zoomed in past its resolution, only the visible tiles of the matching
+ * pyramid level are rendered on a thread pool and uploaded as pixmaps, recent tiles are kept in a cache.
+ * Wheel zooms around the cursor, drag pans, double click fits the image again.
+ */
+class TiledImageView : public QWidget
+{
+Q_OBJECT
+
+public:
+  explicit TiledImageView(QWidget* parent = nullptr);
+  ~TiledImageView() override;
+
+  /// The ROI is in the full resolution coordinates, the view is fitted to the new image.
+  void setImage(QImage overview, std::shared_ptr<ImagePyramid> pyramid, QRect roi = QRect());
+  void clear();
+
+protected:
+  void paintEvent(QPaintEvent* event) override;
+  void resizeEvent(QResizeEvent* event) override;
+  void wheelEvent(QWheelEvent* event) override;
+  void mousePressEvent(QMouseEvent* event) override;
+  void mouseMoveEvent(QMouseEvent* event) override;
+  void mouseDoubleClickEvent(QMouseEvent* event) override;
+
+private:
+  auto imageSize() const -> QSize;
+  void fit();
+  void cancelRendering();
+  void requestTile(int level, QPoint tile);
+
+  QImage _overview;
+  std::shared_ptr<ImagePyramid> _pyramid;
+  QRect _roi;
+
+  /// View pixels per image pixel and the image point shown at the top left corner
+  double _scale{1.0};
+  QPointF _origin;
+  bool _isFitted{true};
+  QPoint _dragPosition;
+
+  QCache<quint64, QPixmap> _tiles;
+  QSet<quint64> _pendingTiles;
+  QThreadPool _renderPool;
+  /// Shared with the renders of the current pyramid, replaced with the pyramid
+  std::shared_ptr<std::atomic<bool>> _isCanceled;
+};
@@ -0,0 +1,98 @@
+#include "TrainingLog.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+#include <locale>
+#include <regex>
+#include <sstream>
+
+namespace {
+/// Key, value and the optional total after '/'
+std::regex const pairPattern(R"((^|[^a-z_])(epoch|iteration|iter|loss|miou|iou|images/s|img/s)\s*[:=]?\s*([-+]?[0-9]*\.?[0-9]+(?:e[-+]?[0-9]+)?)(\s*/\s*([0-9]+))?)");
+
+/// The trainer prints C locale numbers whatever the locale of the GUI; false when the text is no finite number
+bool parseNumber(std::string const& text, double& value)
+{
+  std::istringstream stream(text);
+  stream.imbue(std::locale::classic());
+  stream >> value;
+  return !stream.fail() && std::isfinite(value);
+}
+
+/// Counts out of the range of the field are dropped rather than wrapped
+template<typename T>
+auto toCount(double value) -> std::optional<T>
+{
+  if ((value < 0.0) || (value >= static_cast<double>(std::numeric_limits<T>::max()) + 1.0))
+  {
+    return std::nullopt;
+  }
+  return static_cast<T>(value);
+}
+} /// end namespace anonymous
+
+auto TrainingMetrics::isEmpty() const -> bool
+{
+  return !epoch && !iteration && !loss && !iou && !imagesPerSecond;
+}
+
+void TrainingMetrics::merge(TrainingMetrics const& newer)
+{
+  epoch = newer.epoch ? newer.epoch : epoch;
+  epochsCount = newer.epochsCount ? newer.epochsCount : epochsCount;
+  iteration = newer.iteration ? newer.iteration : iteration;
+  loss = newer.loss ? newer.loss : loss;
+  iou = newer.iou ? newer.iou : iou;
+  imagesPerSecond = newer.imagesPerSecond ? newer.imagesPerSecond : imagesPerSecond;
+}
+
+bool TrainingLog::parse(std::string const& line, TrainingMetrics& metrics)
+{
+  std::string text = line;
+  std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+  TrainingMetrics parsed;
+  for (std::sregex_iterator it(text.cbegin(), text.cend(), pairPattern), end; it != end; ++it)
+  {
+    auto const& key = (*it)[2].str();
+    double value{};
+    if (!parseNumber((*it)[3].str(), value))
+    {
+      continue;
+    }
+    if (key == "epoch")
+    {
+      parsed.epoch = toCount<uint32_t>(value);
+      double epochsCount{};
+      /// A total of 0 is no total, the configured epochs count is kept
+      if ((*it)[5].matched && parseNumber((*it)[5].str(), epochsCount) && (epochsCount > 0.0))
+      {
+        parsed.epochsCount = toCount<uint32_t>(epochsCount);
+      }
+    }
+    else if ((key == "iteration") || (key == "iter"))
+    {
+      parsed.iteration = toCount<uint64_t>(value);
+    }
+    else if (key == "loss")
+    {
+      parsed.loss = value;
+    }
+    else if ((key == "iou") || (key == "miou"))
+    {
+      parsed.iou = value;
+    }
+    else
+    {
+      parsed.imagesPerSecond = value;
+    }
+  }
+  if (parsed.isEmpty())
+  {
+    return false;
+  }
+  metrics.merge(parsed);
+  return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+/// Values reported by the trainer, only the ones found in the output are set.
+struct TrainingMetrics
+{
+  std::optional<uint32_t> epoch;
+  std::optional<uint32_t> epochsCount;
+  std::optional<uint64_t> iteration;
+  std::optional<double> loss;
+  std::optional<double> iou;
+  std::optional<double> imagesPerSecond;
+
+  auto isEmpty() const -> bool;
+  /// Takes the values set in the newer metrics, keeps the rest.
+  void merge(TrainingMetrics const& newer);
+};
+
+/**
+ * Reads progress from the trainer console output. The trainer prints no machine readable format,
+ * so "key: value", "key=value" and "key value" pairs of the known keys are picked from any line,
+ * case insensitive: epoch (also "epoch 3/200"), iteration/iter, loss, iou/miou, images/s/img/s.
+ * Numbers are read in the C locale; values which do not parse or do not fit their field are left unset, nothing throws.
+ */
+struct TrainingLog
+{
+  /// Returns false when the line has none of the known values.
+  static bool parse(std::string const& line, TrainingMetrics& metrics);
+};
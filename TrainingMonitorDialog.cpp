@@ -0,0 +1,247 @@
+#include "TrainingMonitorDialog.hpp"
+
+#include <QtWidgets>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+/// Lines of the tool output kept in the view
+constexpr int outputLinesLimit = 5000;
+/// Points of the loss curve, older points are merged pairwise when it is full
+constexpr size_t curvePointsLimit = 2048;
+
+auto formatDuration(qint64 ms) -> QString
+{
+  auto const seconds = ms / 1000;
+  return QString("%1:%2:%3").arg(seconds / 3600).arg((seconds / 60) % 60, 2, 10, QChar('0')).arg(seconds % 60, 2, 10, QChar('0'));
+}
+} /// end namespace anonymous
+
+/// Loss per report, drawn on a log scale since it falls by orders of magnitude
+class LossCurveWidget : public QWidget
+{
+public:
+  explicit LossCurveWidget(QWidget* parent = nullptr)
+    : QWidget(parent)
+  {
+    setMinimumSize(320, 160);
+    setBackgroundRole(QPalette::Base);
+    setAutoFillBackground(true);
+  }
+
+  void append(double loss)
+  {
+    if (!(loss > 0.0) || !std::isfinite(loss))
+    {
+      return;
+    }
+    _points.push_back(std::log10(loss));
+    if (_points.size() > curvePointsLimit)
+    {
+      for (size_t i = 0; (2 * i + 1) < _points.size(); ++i)
+      {
+        _points[i] = (_points[2 * i] + _points[2 * i + 1]) / 2.0;
+      }
+      _points.resize(_points.size() / 2);
+    }
+    update();
+  }
+
+protected:
+  void paintEvent(QPaintEvent*) override
+  {
+    if (_points.size() < 2)
+    {
+      return;
+    }
+    auto const [minIt, maxIt] = std::minmax_element(_points.cbegin(), _points.cend());
+    auto const range = std::max(*maxIt - *minIt, 1e-6);
+    QPolygonF polyline;
+    for (size_t i = 0; i < _points.size(); ++i)
+    {
+      polyline << QPointF(static_cast<double>(i) * (width() - 1) / (_points.size() - 1), (*maxIt - _points[i]) * (height() - 1) / range);
+    }
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(palette().color(QPalette::Highlight), 1.5));
+    painter.drawPolyline(polyline);
+    painter.setPen(palette().color(QPalette::Text));
+    painter.drawText(rect().adjusted(4, 2, -4, -2), Qt::AlignTop | Qt::AlignRight, QString::number(std::pow(10.0, *maxIt), 'g', 4));
+    painter.drawText(rect().adjusted(4, 2, -4, -2), Qt::AlignBottom | Qt::AlignRight, QString::number(std::pow(10.0, *minIt), 'g', 4));
+  }
+
+private:
+  std::vector<double> _points;
+};
+
+TrainingMonitorDialog::TrainingMonitorDialog(QStringList const& arguments,
+                                             std::vector<std::pair<QString, qint64>> stages,
+                                             uint32_t epochsCount,
+                                             QWidget* parent)
+  : QDialog(parent)
+  , _session(new TrainingSession(this))
+  , _stages(std::move(stages))
+  , _epochsCount(epochsCount)
+{
+  setWindowTitle(tr("Training"));
+
+  _stateLabel = new QLabel(this);
+  _epochLabel = new QLabel(this);
+  _lossLabel = new QLabel(this);
+  _iouLabel = new QLabel(this);
+  _throughputLabel = new QLabel(this);
+  _timeLabel = new QLabel(this);
+  _stagesLabel = new QLabel(this);
+  _lossCurve = new LossCurveWidget(this);
+  _outputEdit = new QPlainTextEdit(this);
+  _outputEdit->setReadOnly(true);
+  _outputEdit->setMaximumBlockCount(outputLinesLimit);
+  _outputEdit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+  _pauseButton = new QPushButton(tr("&Pause"), this);
+  _pauseButton->setEnabled(TrainingSession::isPauseSupported());
+  connect(_pauseButton, &QAbstractButton::clicked, [this]() {
+    if (_session->state() == TrainingSession::State::Paused)
+    {
+      _session->resume();
+    }
+    else
+    {
+      _session->pause();
+    }
+  });
+  _cancelButton = new QPushButton(tr("&Cancel"), this);
+  connect(_cancelButton, &QAbstractButton::clicked, [this]() {
+    if (_session->state() == TrainingSession::State::Finished)
+    {
+      accept();
+    }
+    else
+    {
+      _session->cancel();
+    }
+  });
+
+  connect(_session, &TrainingSession::outputLine, _outputEdit, &QPlainTextEdit::appendPlainText);
+  connect(_session, &TrainingSession::metricsUpdated, [this](TrainingMetrics const& reported) {
+    if (reported.loss)
+    {
+      _lossCurve->append(*reported.loss);
+    }
+    updateMetrics();
+  });
+  connect(_session, &TrainingSession::stateChanged, this, &TrainingMonitorDialog::updateState);
+  connect(_session, &TrainingSession::finished, [this](bool isSucceeded, bool isCanceled) {
+    _isSucceeded = isSucceeded;
+    _stateLabel->setText(isCanceled ? tr("Canceled") : (isSucceeded ? tr("Finished") : tr("Failed, see the output")));
+    updateMetrics();
+  });
+  /// Elapsed time and ETA move on between reports too
+  auto timer = new QTimer(this);
+  connect(timer, &QTimer::timeout, this, &TrainingMonitorDialog::updateMetrics);
+  timer->start(1000);
+
+  auto metricsLayout = new QFormLayout;
+  metricsLayout->addRow(tr("State:"), _stateLabel);
+  metricsLayout->addRow(tr("Epoch:"), _epochLabel);
+  metricsLayout->addRow(tr("Loss:"), _lossLabel);
+  metricsLayout->addRow(tr("IoU:"), _iouLabel);
+  metricsLayout->addRow(tr("Throughput:"), _throughputLabel);
+  metricsLayout->addRow(tr("Time:"), _timeLabel);
+  metricsLayout->addRow(tr("Stages:"), _stagesLabel);
+
+  auto mainLayout = new QGridLayout(this);
+  mainLayout->addLayout(metricsLayout, 0, 0);
+  mainLayout->addWidget(_lossCurve, 0, 1);
+  mainLayout->addWidget(_outputEdit, 1, 0, 1, 2);
+  mainLayout->addWidget(_pauseButton, 2, 0);
+  mainLayout->addWidget(_cancelButton, 2, 1);
+  resize(QGuiApplication::primaryScreen()->availableSize() / 2);
+
+  updateState(TrainingSession::State::Idle);
+  updateMetrics();
+  _session->start(arguments);
+}
+
+auto TrainingMonitorDialog::isSucceeded() const -> bool
+{
+  return _isSucceeded;
+}
+
+void TrainingMonitorDialog::reject()
+{
+  auto const state = _session->state();
+  if ((state == TrainingSession::State::Running) || (state == TrainingSession::State::Paused))
+  {
+    if (QMessageBox::question(this, windowTitle(), tr("Cancel the run?")) != QMessageBox::Yes)
+    {
+      return;
+    }
+    _session->cancel();
+  }
+  QDialog::reject();
+}
+
+void TrainingMonitorDialog::updateMetrics()
+{
+  auto const& metrics = _session->metrics();
+  auto const epochsCount = metrics.epochsCount ? *metrics.epochsCount : _epochsCount;
+  _epochLabel->setText(metrics.epoch ? tr("%1 of %2, iteration %3").arg(*metrics.epoch).arg(epochsCount).arg(metrics.iteration ? QString::number(*metrics.iteration) : tr("-"))
+                                     : tr("-"));
+  _lossLabel->setText(metrics.loss ? QString::number(*metrics.loss, 'g', 5) : tr("-"));
+  _iouLabel->setText(metrics.iou ? QString::number(*metrics.iou, 'f', 4) : tr("-"));
+  if (metrics.imagesPerSecond)
+  {
+    _throughputLabel->setText(tr("%1 images/s").arg(*metrics.imagesPerSecond, 0, 'f', 1));
+  }
+  else if (_session->iterationsPerSecond() > 0.0)
+  {
+    _throughputLabel->setText(tr("%1 iterations/s, %2 ms per iteration").arg(_session->iterationsPerSecond(), 0, 'f', 2)
+                                                                        .arg(1000.0 / _session->iterationsPerSecond(), 0, 'f', 0));
+  }
+  else
+  {
+    _throughputLabel->setText(tr("-"));
+  }
+
+  auto const elapsedMs = _session->elapsedMs();
+  auto timeText = tr("%1 elapsed").arg(formatDuration(elapsedMs));
+  /// Epochs are the only progress all trainers report, the first one gives no estimate yet
+  if (metrics.epoch && (*metrics.epoch > 0) && (epochsCount > *metrics.epoch) && (_session->state() == TrainingSession::State::Running))
+  {
+    timeText += tr(", %1 left").arg(formatDuration(elapsedMs * (epochsCount - *metrics.epoch) / *metrics.epoch));
+  }
+  _timeLabel->setText(timeText);
+
+  QStringList stagesText;
+  for (auto const& stage : _stages)
+  {
+    stagesText << tr("%1 %2").arg(stage.first, formatDuration(stage.second));
+  }
+  stagesText << tr("run %1").arg(formatDuration(elapsedMs));
+  _stagesLabel->setText(stagesText.join(", "));
+}
+
+void TrainingMonitorDialog::updateState(TrainingSession::State state)
+{
+  switch (state)
+  {
+    case TrainingSession::State::Idle:
+      _stateLabel->setText(tr("Starting"));
+      break;
+    case TrainingSession::State::Running:
+      _stateLabel->setText(tr("Running"));
+      _pauseButton->setText(tr("&Pause"));
+      break;
+    case TrainingSession::State::Paused:
+      _stateLabel->setText(tr("Paused"));
+      _pauseButton->setText(tr("&Resume"));
+      break;
+    case TrainingSession::State::Finished:
+      /// The outcome is shown once the session has finished
+      _pauseButton->setEnabled(false);
+      _cancelButton->setText(tr("&Close"));
+      break;
+  }
+}
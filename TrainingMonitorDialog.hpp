@@ -0,0 +1,58 @@
+#pragma once
+
+#include "TrainingSession.hpp"
+
+#include <QDialog>
+
+#include <utility>
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+class QLabel;
+class QPlainTextEdit;
+class QPushButton;
+QT_END_NAMESPACE
+
+class LossCurveWidget;
+
+/**
+ * Live view of a training or validation run: metrics, throughput, ETA, the loss curve and the tool
+ * output, with pause, resume and cancel. Closing the dialog cancels a run which is still going.
+ */
+class TrainingMonitorDialog : public QDialog
+{
+Q_OBJECT
+
+public:
+  /// Stages are the steps done before the run with their durations (conversion for example), shown with the run time.
+  TrainingMonitorDialog(QStringList const& arguments,
+                        std::vector<std::pair<QString, qint64>> stages,
+                        uint32_t epochsCount,
+                        QWidget* parent = nullptr);
+
+  auto isSucceeded() const -> bool;
+
+public slots:
+  void reject() override;
+
+private:
+  void updateMetrics();
+  void updateState(TrainingSession::State state);
+
+  TrainingSession* _session{};
+  std::vector<std::pair<QString, qint64>> _stages;
+  uint32_t _epochsCount{};
+  bool _isSucceeded{};
+
+  QLabel* _stateLabel{};
+  QLabel* _epochLabel{};
+  QLabel* _lossLabel{};
+  QLabel* _iouLabel{};
+  QLabel* _throughputLabel{};
+  QLabel* _timeLabel{};
+  QLabel* _stagesLabel{};
+  LossCurveWidget* _lossCurve{};
+  QPlainTextEdit* _outputEdit{};
+  QPushButton* _pauseButton{};
+  QPushButton* _cancelButton{};
+};
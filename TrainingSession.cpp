@@ -0,0 +1,192 @@
+#include "TrainingSession.hpp"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QTimer>
+
+#ifndef _WIN32
+#include <signal.h>
+#endif
+
+namespace {
+constexpr int killDelayMs = 5000;
+/// Smoothing of the throughput between reports
+constexpr double throughputSmoothing = 0.2;
+
+auto toolPath() -> QString
+{
+  return QDir(QCoreApplication::applicationDirPath()).filePath("unet-training-tool-cli");
+}
+} /// end namespace anonymous
+
+TrainingSession::TrainingSession(QObject* parent)
+  : QObject(parent)
+  , _process(new QProcess(this))
+  , _killTimer(new QTimer(this))
+{
+  _process->setProcessChannelMode(QProcess::MergedChannels);
+  connect(_process, &QProcess::readyReadStandardOutput, this, &TrainingSession::readOutput);
+  connect(_process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), this, [this](int exitCode, QProcess::ExitStatus exitStatus) {
+    _killTimer->stop();
+    readOutput();
+    if (!_pendingOutput.isEmpty())
+    {
+      emit outputLine(QString::fromLocal8Bit(_pendingOutput));
+      _pendingOutput.clear();
+    }
+    _pausedElapsedMs = elapsedMs();
+    setState(State::Finished);
+    emit finished(!_isCanceled && (exitStatus == QProcess::NormalExit) && (exitCode == 0), _isCanceled);
+  });
+  connect(_process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+    if ((error == QProcess::FailedToStart) && (_state == State::Running))
+    {
+      emit outputLine(tr("Could not be started: %1").arg(_process->program()));
+      setState(State::Finished);
+      emit finished(false, false);
+    }
+  });
+
+  _killTimer->setSingleShot(true);
+  connect(_killTimer, &QTimer::timeout, _process, &QProcess::kill);
+}
+
+TrainingSession::~TrainingSession()
+{
+  if (_process->state() != QProcess::NotRunning)
+  {
+    _process->disconnect();
+    resume();
+    _process->kill();
+    _process->waitForFinished(killDelayMs);
+  }
+}
+
+bool TrainingSession::start(QStringList const& arguments)
+{
+  if ((_state == State::Running) || (_state == State::Paused))
+  {
+    return false;
+  }
+  _metrics = TrainingMetrics();
+  _isCanceled = false;
+  _pausedElapsedMs = 0;
+  _lastIteration.reset();
+  _iterationsPerSecond = 0.0;
+  _pendingOutput.clear();
+  _runningTimer.start();
+  setState(State::Running);
+  _process->start(toolPath(), arguments);
+  return _process->waitForStarted();
+}
+
+auto TrainingSession::isPauseSupported() -> bool
+{
+#ifdef _WIN32
+  return false;
+#else
+  return true;
+#endif
+}
+
+void TrainingSession::pause()
+{
+#ifndef _WIN32
+  if ((_state == State::Running) && (::kill(static_cast<pid_t>(_process->processId()), SIGSTOP) == 0))
+  {
+    _pausedElapsedMs = elapsedMs();
+    setState(State::Paused);
+  }
+#endif
+}
+
+void TrainingSession::resume()
+{
+#ifndef _WIN32
+  if ((_state == State::Paused) && (::kill(static_cast<pid_t>(_process->processId()), SIGCONT) == 0))
+  {
+    _runningTimer.restart();
+    /// The interval over the pause would underestimate the throughput
+    _lastIteration.reset();
+    setState(State::Running);
+  }
+#endif
+}
+
+void TrainingSession::cancel()
+{
+  if (_process->state() == QProcess::NotRunning)
+  {
+    return;
+  }
+  _isCanceled = true;
+  /// A stopped process would not handle SIGTERM until continued
+  resume();
+  _process->terminate();
+  _killTimer->start(killDelayMs);
+}
+
+auto TrainingSession::state() const -> State
+{
+  return _state;
+}
+
+auto TrainingSession::metrics() const -> TrainingMetrics const&
+{
+  return _metrics;
+}
+
+auto TrainingSession::elapsedMs() const -> qint64
+{
+  return (_state == State::Running) ? (_pausedElapsedMs + _runningTimer.elapsed()) : _pausedElapsedMs;
+}
+
+auto TrainingSession::iterationsPerSecond() const -> double
+{
+  return _iterationsPerSecond;
+}
+
+void TrainingSession::setState(State state)
+{
+  if (_state != state)
+  {
+    _state = state;
+    emit stateChanged(state);
+  }
+}
+
+void TrainingSession::readOutput()
+{
+  _pendingOutput += _process->readAllStandardOutput();
+  /// Progress bars rewrite their line with '\r', every rewrite is a report
+  _pendingOutput.replace('\r', '\n');
+  int begin = 0;
+  for (int end = _pendingOutput.indexOf('\n'); end >= 0; begin = end + 1, end = _pendingOutput.indexOf('\n', begin))
+  {
+    auto const line = QString::fromLocal8Bit(_pendingOutput.constData() + begin, end - begin).trimmed();
+    if (line.isEmpty())
+    {
+      continue;
+    }
+    emit outputLine(line);
+    TrainingMetrics parsed;
+    if (!TrainingLog::parse(line.toStdString(), parsed))
+    {
+      continue;
+    }
+    auto const nowMs = elapsedMs();
+    if (parsed.iteration && _lastIteration && (*parsed.iteration > *_lastIteration) && (nowMs > _lastIterationMs))
+    {
+      auto const current = 1000.0 * static_cast<double>(*parsed.iteration - *_lastIteration) / static_cast<double>(nowMs - _lastIterationMs);
+      _iterationsPerSecond = (_iterationsPerSecond > 0.0) ? ((1.0 - throughputSmoothing) * _iterationsPerSecond + throughputSmoothing * current) : current;
+    }
+    if (parsed.iteration)
+    {
+      _lastIteration = parsed.iteration;
+      _lastIterationMs = nowMs;
+    }
+    _metrics.merge(parsed);
+    emit metricsUpdated(parsed);
+  }
+  _pendingOutput.remove(0, begin);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "TrainingLog.hpp"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+/**
+ * Runs the trainer in the command line tool process next to the application, so the GUI stays
+ * responsive and the run could be canceled or paused (POSIX only, the process is stopped by SIGSTOP).
+ * Progress is read from the tool output (TrainingLog), throughput is measured between reports
+ * without the paused time.
+ */
+class TrainingSession : public QObject
+{
+Q_OBJECT
+
+public:
+  enum class State
+  {
+    Idle,
+    Running,
+    Paused,
+    Finished
+  };
+
+  explicit TrainingSession(QObject* parent = nullptr);
+  /// Kills a run which is still going.
+  ~TrainingSession() override;
+
+  /// Arguments of "unet-training-tool-cli", e.g. {"train", project, "--converted", dir}. Returns false when it could not start.
+  bool start(QStringList const& arguments);
+  static auto isPauseSupported() -> bool;
+  void pause();
+  void resume();
+  /// Terminates the tool and kills it when it does not exit in a few seconds.
+  void cancel();
+
+  auto state() const -> State;
+  auto metrics() const -> TrainingMetrics const&;
+  /// Running time without pauses
+  auto elapsedMs() const -> qint64;
+  auto iterationsPerSecond() const -> double;
+
+signals:
+  void outputLine(QString const& line);
+  /// Only the values of the last report are set, metrics() has all of them.
+  void metricsUpdated(TrainingMetrics const& reported);
+  void stateChanged(TrainingSession::State state);
+  void finished(bool isSucceeded, bool isCanceled);
+
+private:
+  void setState(State state);
+  void readOutput();
+
+  QProcess* _process{};
+  QTimer* _killTimer{};
+  State _state{State::Idle};
+  bool _isCanceled{};
+  QByteArray _pendingOutput;
+
+  TrainingMetrics _metrics;
+  QElapsedTimer _runningTimer;
+  qint64 _pausedElapsedMs{};
+  /// Iteration and running time of the previous report, reset by pauses
+  std::optional<uint64_t> _lastIteration;
+  qint64 _lastIterationMs{};
+  double _iterationsPerSecond{};
+};
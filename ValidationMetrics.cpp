@@ -0,0 +1,609 @@
+#include "ValidationMetrics.hpp"
+#include "ConversionManifest.hpp"
+#include "FileStamp.hpp"
+#include "ProbabilityCache.hpp"
+#include "ProcessingPipeline.hpp"
+
+#include <opencv_unet/UNet.hpp>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#ifdef _MSC_VER
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+namespace bp = boost::property_tree;
+
+namespace {
+struct ValidationItem
+{
+  std::string name;
+  std::string imagePath;
+  std::string maskPath;
+  /// Index in the ValidationSet when the samples are decoded already
+  size_t sampleIndex{};
+  cv::Mat image;
+  cv::Mat truth;
+  std::vector<cv::Mat> probabilities;
+  std::vector<cv::Mat> predictions;
+  std::vector<ClassMetrics> classes;
+  std::vector<uint64_t> confusion;
+  bool isFailed{};
+};
+
+auto ratio(uint64_t numerator, uint64_t denominator) -> double
+{
+  return (denominator == 0) ? 1.0 : (static_cast<double>(numerator) / static_cast<double>(denominator));
+}
+
+/// Class index per pixel at the given size, 0 is the background and unknown colors
+auto truthLabels(cv::Mat const& truth, cv::Size size, ValidationOptions const& options) -> cv::Mat
+{
+  cv::Mat labels;
+  if (options.isClassIndexMasks)
+  {
+    cv::Mat indices = (truth.channels() == 1) ? truth : cv::Mat();
+    if (indices.empty())
+    {
+      cv::extractChannel(truth, indices, 0);
+    }
+    indices.copyTo(labels);
+    labels.setTo(0, labels > static_cast<double>(options.classNames.size()));
+  }
+  else
+  {
+    labels = cv::Mat::zeros(truth.size(), CV_8UC1);
+    cv::Mat colors = truth;
+    if (colors.channels() == 1)
+    {
+      cv::cvtColor(truth, colors, cv::COLOR_GRAY2BGR);
+    }
+    cv::Mat classMask;
+    for (size_t i = 0; i < options.classColors.size(); ++i)
+    {
+      cv::inRange(colors, options.classColors[i], options.classColors[i], classMask);
+      labels.setTo(static_cast<double>(i + 1), classMask);
+    }
+  }
+  if (labels.size() != size)
+  {
+    cv::resize(labels, labels, size, 0.0, 0.0, cv::INTER_NEAREST);
+  }
+  return labels;
+}
+
+auto boxIou(cv::Rect const& a, cv::Rect const& b) -> double
+{
+  auto const intersection = (a & b).area();
+  auto const unionArea = a.area() + b.area() - intersection;
+  return (unionArea > 0) ? (static_cast<double>(intersection) / unionArea) : 0.0;
+}
+
+/// Greedy one to one matching, the pairs with the highest IoU go first
+auto matchedCount(std::vector<cv::Rect> const& predicted, std::vector<cv::Rect> const& truth, double minIou) -> uint64_t
+{
+  std::vector<std::tuple<double, size_t, size_t>> pairs;
+  for (size_t p = 0; p < predicted.size(); ++p)
+  {
+    for (size_t t = 0; t < truth.size(); ++t)
+    {
+      auto const iou = boxIou(predicted[p], truth[t]);
+      if (iou >= minIou)
+      {
+        pairs.emplace_back(iou, p, t);
+      }
+    }
+  }
+  std::sort(pairs.begin(), pairs.end(), [](auto const& a, auto const& b) { return std::get<0>(a) > std::get<0>(b); });
+  std::vector<bool> isPredictedMatched(predicted.size());
+  std::vector<bool> isTruthMatched(truth.size());
+  uint64_t count = 0;
+  for (auto const& pair : pairs)
+  {
+    if (!isPredictedMatched[std::get<1>(pair)] && !isTruthMatched[std::get<2>(pair)])
+    {
+      isPredictedMatched[std::get<1>(pair)] = true;
+      isTruthMatched[std::get<2>(pair)] = true;
+      ++count;
+    }
+  }
+  return count;
+}
+
+void writeClassesCsv(std::ostream& stream, std::vector<std::string> const& classNames, std::vector<ClassMetrics> const& classes, std::string const& prefix)
+{
+  for (size_t i = 0; i < classes.size(); ++i)
+  {
+    auto const& metrics = classes[i];
+    stream << prefix << classNames[i] << ',' << metrics.iou() << ',' << metrics.dice() << ',' << metrics.precision() << ',' << metrics.recall() << ','
+           << metrics.objectPrecision() << ',' << metrics.objectRecall() << ',' << metrics.truePositives << ',' << metrics.falsePositives << ','
+           << metrics.falseNegatives << ',' << metrics.matchedObjects << ',' << metrics.predictedObjects << ',' << metrics.trueObjects << '\n';
+  }
+}
+
+auto classesTree(std::vector<std::string> const& classNames, std::vector<ClassMetrics> const& classes) -> bp::ptree
+{
+  bp::ptree tree;
+  for (size_t i = 0; i < classes.size(); ++i)
+  {
+    auto const& metrics = classes[i];
+    bp::ptree item;
+    item.put("className", classNames[i]);
+    item.put("iou", metrics.iou());
+    item.put("dice", metrics.dice());
+    item.put("precision", metrics.precision());
+    item.put("recall", metrics.recall());
+    item.put("objectPrecision", metrics.objectPrecision());
+    item.put("objectRecall", metrics.objectRecall());
+    item.put("truePositives", metrics.truePositives);
+    item.put("falsePositives", metrics.falsePositives);
+    item.put("falseNegatives", metrics.falseNegatives);
+    item.put("matchedObjects", metrics.matchedObjects);
+    item.put("predictedObjects", metrics.predictedObjects);
+    item.put("trueObjects", metrics.trueObjects);
+    tree.push_back(bp::ptree::value_type("", item));
+  }
+  return tree;
+}
+
+auto emptyReport(ValidationOptions const& options) -> ValidationReport
+{
+  ValidationReport report;
+  report.classNames = options.classNames;
+  report.classes.assign(options.classNames.size(), ClassMetrics{});
+  report.confusion.assign((options.classNames.size() + 1) * (options.classNames.size() + 1), 0);
+  return report;
+}
+
+/// Validation samples of the dataset in the imagesV/masksV layout, in the names order
+auto listItems(std::string const& convertedDatasetPath) -> std::vector<ValidationItem>
+{
+  std::vector<ValidationItem> items;
+  std::error_code errorCode;
+  for (fs::directory_iterator it(convertedDatasetPath + "/imagesV", errorCode), end; !errorCode && (it != end); it.increment(errorCode))
+  {
+    if (it->path().extension().string() != ".png")
+    {
+      continue;
+    }
+    ValidationItem item;
+    item.name = it->path().filename().string();
+    item.imagePath = it->path().string();
+    item.maskPath = convertedDatasetPath + "/masksV/" + item.name;
+    items.emplace_back(std::move(item));
+  }
+  std::sort(items.begin(), items.end(), [](auto const& a, auto const& b) { return a.name < b.name; });
+  return items;
+}
+
+void loadItem(ValidationItem& item)
+{
+  item.image = cv::imread(item.imagePath, cv::IMREAD_UNCHANGED);
+  item.truth = cv::imread(item.maskPath, cv::IMREAD_UNCHANGED);
+  item.isFailed = item.image.empty() || item.truth.empty();
+}
+
+/// Forwards the loaded items in batches and accumulates them in parallel, the counts are merged into the report
+/// on the calling thread. The probability cache is written when the options ask for it.
+void validateItems(std::vector<ValidationItem>&& items,
+                   std::function<void(ValidationItem&)> const& load,
+                   RoiDetector& detector,
+                   std::string const& convertedDatasetPath,
+                   ValidationOptions const& options,
+                   std::atomic<bool> const& isCanceled,
+                   ValidationMetrics::ProgressCallback const& onProgress,
+                   ValidationReport& report)
+{
+  std::unique_ptr<ProbabilityCacheWriter> cacheWriter;
+  if (!options.probabilityCachePath.empty())
+  {
+    cacheWriter = std::make_unique<ProbabilityCacheWriter>(options.probabilityCachePath,
+                                                           static_cast<uint32_t>(options.classNames.size()),
+                                                           ValidationMetrics::probabilityCacheKey(convertedDatasetPath, options));
+  }
+
+  auto const threadsCount = (options.threadsCount != 0)
+                            ? options.threadsCount
+                            : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  ProcessingPipeline<ValidationItem> pipeline(threadsCount * 2);
+  pipeline.addStage(load, threadsCount);
+  pipeline.addBatchStage([&](std::vector<ValidationItem*> const& batch) {
+    std::vector<cv::Mat> frames;
+    for (auto item : batch)
+    {
+      if (!item->isFailed)
+      {
+        frames.push_back(item->image);
+      }
+    }
+    if (frames.empty())
+    {
+      return;
+    }
+    std::vector<std::vector<cv::Mat>> probabilities;
+    try
+    {
+      probabilities = detector.probabilities(frames);
+    }
+    catch (cv::Exception const&)
+    {
+      probabilities.clear();
+    }
+    size_t next = 0;
+    for (auto item : batch)
+    {
+      if (item->isFailed)
+      {
+        continue;
+      }
+      item->isFailed = (next >= probabilities.size());
+      if (!item->isFailed)
+      {
+        item->probabilities = std::move(probabilities[next++]);
+      }
+      item->image.release();
+    }
+  }, options.network.batchSize);
+  pipeline.addStage([&](ValidationItem& item) {
+    if (!item.isFailed)
+    {
+      /// Thresholding is cheap next to the forward, so the network runs once for the metrics and the cache
+      item.predictions = detector.threshold(item.probabilities);
+      ValidationMetrics::accumulate(item.predictions, item.truth, options, item.classes, item.confusion);
+    }
+    if (!item.isFailed && cacheWriter)
+    {
+      ProbabilitySample sample;
+      sample.name = item.name;
+      sample.labels = truthLabels(item.truth, item.probabilities.front().size(), options);
+      for (auto const& probabilities : item.probabilities)
+      {
+        sample.probabilities.emplace_back(ProbabilityCacheWriter::quantize(probabilities));
+      }
+      sample.probabilities.resize(options.classNames.size(), cv::Mat::zeros(sample.labels.size(), CV_8UC1));
+      item.isFailed = !cacheWriter->append(sample);
+    }
+    item.probabilities.clear();
+    item.predictions.clear();
+    item.truth.release();
+  }, threadsCount);
+
+  size_t processed = 0;
+  auto const total = items.size();
+  auto sink = [&](ValidationItem&& item) {
+    if (item.isFailed)
+    {
+      report.failedSamples.emplace_back(item.name);
+    }
+    else
+    {
+      for (size_t i = 0; i < report.classes.size(); ++i)
+      {
+        report.classes[i].merge(item.classes[i]);
+      }
+      for (size_t i = 0; i < report.confusion.size(); ++i)
+      {
+        report.confusion[i] += item.confusion[i];
+      }
+      report.images.push_back(ImageMetrics{std::move(item.name), std::move(item.classes)});
+    }
+    onProgress(++processed, total);
+  };
+  auto removeCache = [&]() {
+    std::error_code errorCode;
+    fs::remove(options.probabilityCachePath, errorCode);
+  };
+  try
+  {
+    pipeline.run(std::move(items), isCanceled, sink);
+  }
+  catch (...)
+  {
+    /// The cache has not seen every sample, it must not be taken for the whole dataset
+    if (cacheWriter)
+    {
+      cacheWriter->close();
+      removeCache();
+    }
+    throw;
+  }
+  if (cacheWriter && (!cacheWriter->close() || isCanceled))
+  {
+    removeCache();
+    if (!isCanceled)
+    {
+      report.failedSamples.emplace_back(options.probabilityCachePath);
+    }
+  }
+}
+} /// end namespace anonymous
+
+auto ClassMetrics::iou() const -> double
+{
+  return ratio(truePositives, truePositives + falsePositives + falseNegatives);
+}
+
+auto ClassMetrics::dice() const -> double
+{
+  return ratio(2 * truePositives, 2 * truePositives + falsePositives + falseNegatives);
+}
+
+auto ClassMetrics::precision() const -> double
+{
+  return ratio(truePositives, truePositives + falsePositives);
+}
+
+auto ClassMetrics::recall() const -> double
+{
+  return ratio(truePositives, truePositives + falseNegatives);
+}
+
+auto ClassMetrics::objectPrecision() const -> double
+{
+  return ratio(matchedObjects, predictedObjects);
+}
+
+auto ClassMetrics::objectRecall() const -> double
+{
+  return ratio(matchedObjects, trueObjects);
+}
+
+void ClassMetrics::merge(ClassMetrics const& other)
+{
+  truePositives += other.truePositives;
+  falsePositives += other.falsePositives;
+  falseNegatives += other.falseNegatives;
+  matchedObjects += other.matchedObjects;
+  predictedObjects += other.predictedObjects;
+  trueObjects += other.trueObjects;
+}
+
+auto ValidationReport::meanIou() const -> double
+{
+  double sum = 0.0;
+  for (auto const& metrics : classes)
+  {
+    sum += metrics.iou();
+  }
+  return classes.empty() ? 0.0 : (sum / classes.size());
+}
+
+void ValidationMetrics::accumulate(std::vector<cv::Mat> const& predictions,
+                                   cv::Mat const& truth,
+                                   ValidationOptions const& options,
+                                   std::vector<ClassMetrics>& classes,
+                                   std::vector<uint64_t>& confusion)
+{
+  auto const classesCount = options.classNames.size();
+  classes.assign(classesCount, ClassMetrics{});
+  confusion.assign((classesCount + 1) * (classesCount + 1), 0);
+  if (predictions.empty() || truth.empty())
+  {
+    return;
+  }
+  auto const size = predictions.front().size();
+  auto const labels = truthLabels(truth, size, options);
+
+  /// The first predicted class of every pixel, for the confusion matrix
+  cv::Mat predictedLabels = cv::Mat::zeros(size, CV_8UC1);
+  std::vector<cv::Mat> trueMasks(classesCount);
+  cv::Mat intersection;
+  for (size_t i = 0; i < classesCount; ++i)
+  {
+    trueMasks[i] = (labels == static_cast<double>(i + 1));
+    if (i >= predictions.size())
+    {
+      /// The network has fewer outputs than classes, the class is never predicted
+      classes[i].falseNegatives = static_cast<uint64_t>(cv::countNonZero(trueMasks[i]));
+      continue;
+    }
+    auto const& predicted = predictions[i];
+    cv::bitwise_and(predicted, trueMasks[i], intersection);
+    auto const truePositives = static_cast<uint64_t>(cv::countNonZero(intersection));
+    classes[i].truePositives = truePositives;
+    classes[i].falsePositives = static_cast<uint64_t>(cv::countNonZero(predicted)) - truePositives;
+    classes[i].falseNegatives = static_cast<uint64_t>(cv::countNonZero(trueMasks[i])) - truePositives;
+    predictedLabels.setTo(static_cast<double>(i + 1), predicted & (predictedLabels == 0));
+  }
+
+  for (int y = 0; y < size.height; ++y)
+  {
+    auto const trueRow = labels.ptr<uint8_t>(y);
+    auto const predictedRow = predictedLabels.ptr<uint8_t>(y);
+    for (int x = 0; x < size.width; ++x)
+    {
+      ++confusion[trueRow[x] * (classesCount + 1) + predictedRow[x]];
+    }
+  }
+
+  auto const predictedBoxes = UNet::foundBoundingBoxes(std::vector<cv::Mat>(predictions.begin(), predictions.begin() + std::min(predictions.size(), classesCount)));
+  auto const trueBoxes = UNet::foundBoundingBoxes(trueMasks);
+  for (size_t i = 0; i < classesCount; ++i)
+  {
+    auto const& predictedClassBoxes = (i < predictedBoxes.size()) ? predictedBoxes[i] : std::vector<cv::Rect>{};
+    auto const& trueClassBoxes = (i < trueBoxes.size()) ? trueBoxes[i] : std::vector<cv::Rect>{};
+    classes[i].predictedObjects = predictedClassBoxes.size();
+    classes[i].trueObjects = trueClassBoxes.size();
+    classes[i].matchedObjects = matchedCount(predictedClassBoxes, trueClassBoxes, options.objectIou);
+  }
+}
+
+auto ValidationMetrics::evaluate(std::string const& convertedDatasetPath,
+                                 ValidationOptions const& options,
+                                 std::atomic<bool> const& isCanceled,
+                                 ProgressCallback const& onProgress) -> ValidationReport
+{
+  auto report = emptyReport(options);
+  auto items = listItems(convertedDatasetPath);
+
+  /// Built for this run only: the registry keys detectors by their paths, a network retrained into the same
+  /// files would be taken from it stale
+  std::unique_ptr<RoiDetector> detector;
+  try
+  {
+    detector = std::make_unique<RoiDetector>(options.network);
+  }
+  catch (std::exception const&)
+  {
+    detector.reset();
+  }
+  if (!detector)
+  {
+    for (auto const& item : items)
+    {
+      report.failedSamples.emplace_back(item.name);
+    }
+    return report;
+  }
+  validateItems(std::move(items), loadItem,
+                *detector, convertedDatasetPath, options, isCanceled, onProgress, report);
+  return report;
+}
+
+auto ValidationMetrics::loadValidationSet(std::string const& convertedDatasetPath,
+                                          size_t threadsCount,
+                                          std::atomic<bool> const& isCanceled) -> ValidationSet
+{
+  ValidationSet set;
+  set.convertedDatasetPath = convertedDatasetPath;
+  auto items = listItems(convertedDatasetPath);
+
+  threadsCount = (threadsCount != 0) ? threadsCount : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  ProcessingPipeline<ValidationItem> pipeline(threadsCount * 2);
+  pipeline.addStage(loadItem, threadsCount);
+  pipeline.run(std::move(items), isCanceled, [&](ValidationItem&& item) {
+    if (item.isFailed)
+    {
+      set.failedSamples.emplace_back(item.name);
+      return;
+    }
+    set.samples.push_back(ValidationSample{std::move(item.name), std::move(item.image), std::move(item.truth)});
+  });
+  return set;
+}
+
+auto ValidationMetrics::evaluate(ValidationSet const& set,
+                                 RoiDetector& detector,
+                                 ValidationOptions const& options,
+                                 std::atomic<bool> const& isCanceled,
+                                 ProgressCallback const& onProgress) -> ValidationReport
+{
+  auto report = emptyReport(options);
+  report.failedSamples = set.failedSamples;
+  std::vector<ValidationItem> items(set.samples.size());
+  for (size_t i = 0; i < items.size(); ++i)
+  {
+    items[i].name = set.samples[i].name;
+    items[i].sampleIndex = i;
+  }
+  validateItems(std::move(items), [&](ValidationItem& item) {
+    item.image = set.samples[item.sampleIndex].image;
+    item.truth = set.samples[item.sampleIndex].truth;
+  }, detector, set.convertedDatasetPath, options, isCanceled, onProgress, report);
+  return report;
+}
+
+auto ValidationMetrics::probabilityCacheKey(std::string const& convertedDatasetPath, ValidationOptions const& options) -> std::string
+{
+  auto const modelStamp = FileStamp::of(options.network.modelFilePath, false);
+  auto const weightsStamp = FileStamp::of(options.network.weightsFilePath, false);
+  auto const manifestStamp = FileStamp::of(convertedDatasetPath + "/" + ConversionManifest::fileName, false);
+  std::ostringstream key;
+  key << options.network.modelFilePath << ' ' << modelStamp.modificationTime << ' ' << modelStamp.size << '\n'
+      << options.network.weightsFilePath << ' ' << weightsStamp.modificationTime << ' ' << weightsStamp.size << '\n'
+      << convertedDatasetPath << ' ' << manifestStamp.modificationTime << ' ' << manifestStamp.size << '\n'
+      << options.network.inputChannels << ' '
+      << options.network.inputSize.width << 'x' << options.network.inputSize.height << ' '
+      << options.network.sizeAlignment << ' ' << options.isClassIndexMasks << '\n';
+  for (auto const& className : options.classNames)
+  {
+    key << className << '\n';
+  }
+  return key.str();
+}
+
+bool ValidationMetrics::saveReport(ValidationReport const& report, std::string const& directoryPath)
+{
+  std::error_code errorCode;
+  fs::create_directories(directoryPath, errorCode);
+
+  bp::ptree tree;
+  tree.put("meanIou", report.meanIou());
+  tree.put("imagesCount", report.images.size());
+  tree.put_child("classes", classesTree(report.classNames, report.classes));
+  bp::ptree confusion;
+  auto const side = report.classNames.size() + 1;
+  for (size_t row = 0; row < side; ++row)
+  {
+    bp::ptree rowTree;
+    for (size_t column = 0; column < side; ++column)
+    {
+      bp::ptree value;
+      value.put_value(report.confusion[row * side + column]);
+      rowTree.push_back(bp::ptree::value_type("", value));
+    }
+    confusion.push_back(bp::ptree::value_type("", rowTree));
+  }
+  tree.put_child("confusion", confusion);
+  bp::ptree failed;
+  for (auto const& name : report.failedSamples)
+  {
+    bp::ptree value;
+    value.put_value(name);
+    failed.push_back(bp::ptree::value_type("", value));
+  }
+  tree.put_child("failedSamples", failed);
+
+  std::ofstream jsonFile(directoryPath + "/report.json");
+  std::ofstream classesFile(directoryPath + "/classes.csv");
+  std::ofstream confusionFile(directoryPath + "/confusion.csv");
+  std::ofstream imagesFile(directoryPath + "/images.csv");
+  if (!jsonFile || !classesFile || !confusionFile || !imagesFile)
+  {
+    return false;
+  }
+  bp::write_json(jsonFile, tree);
+
+  auto const header = "class,iou,dice,precision,recall,object_precision,object_recall,"
+                      "true_positives,false_positives,false_negatives,matched_objects,predicted_objects,true_objects\n";
+  classesFile << header;
+  writeClassesCsv(classesFile, report.classNames, report.classes, "");
+
+  /// Rows are the truth, columns the prediction
+  confusionFile << "truth\\prediction,background";
+  for (auto const& className : report.classNames)
+  {
+    confusionFile << ',' << className;
+  }
+  confusionFile << '\n';
+  for (size_t row = 0; row < side; ++row)
+  {
+    confusionFile << ((row == 0) ? std::string("background") : report.classNames[row - 1]);
+    for (size_t column = 0; column < side; ++column)
+    {
+      confusionFile << ',' << report.confusion[row * side + column];
+    }
+    confusionFile << '\n';
+  }
+
+  imagesFile << "image," << header;
+  for (auto const& image : report.images)
+  {
+    writeClassesCsv(imagesFile, report.classNames, image.classes, image.name + ",");
+  }
+  return jsonFile.flush() && classesFile.flush() && confusionFile.flush() && imagesFile.flush();
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "RoiDetector.hpp"
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct ValidationOptions
+{
+  /// The network, its outputs are per class probabilities in the classes order
+  RoiDetectorOptions network;
+  /// Classes in the index order (MaskRasterizer::classIndices), with the colors of color masks
+  std::vector<std::string> classNames;
+  std::vector<cv::Scalar> classColors;
+  bool isClassIndexMasks{};
+  /// Boxes of a predicted and a true object are matched when their IoU is at least it
+  double objectIou{0.5};
+  /// 0 means the count of hardware threads
+  size_t threadsCount{0};
+  /// When set, the quantized probabilities and the truth labels of every sample are written there for ThresholdSweep
+  std::string probabilityCachePath;
+};
+
+struct ClassMetrics
+{
+  uint64_t truePositives{};
+  uint64_t falsePositives{};
+  uint64_t falseNegatives{};
+  uint64_t matchedObjects{};
+  uint64_t predictedObjects{};
+  uint64_t trueObjects{};
+
+  /// Ratios of empty sets (no truth and no prediction) are 1, nothing has been missed.
+  auto iou() const -> double;
+  auto dice() const -> double;
+  auto precision() const -> double;
+  auto recall() const -> double;
+  auto objectPrecision() const -> double;
+  auto objectRecall() const -> double;
+  void merge(ClassMetrics const& other);
+};
+
+struct ImageMetrics
+{
+  std::string name;
+  std::vector<ClassMetrics> classes;
+};
+
+struct ValidationReport
+{
+  std::vector<std::string> classNames;
+  std::vector<ClassMetrics> classes;
+  /// (classes + 1)^2 pixel counts, the row is the truth and the column the prediction, 0 is the background
+  std::vector<uint64_t> confusion;
+  std::vector<ImageMetrics> images;
+  std::vector<std::string> failedSamples;
+
+  auto meanIou() const -> double;
+};
+
+struct ValidationSample
+{
+  std::string name;
+  cv::Mat image;
+  /// Class colors or indices, as converted
+  cv::Mat truth;
+};
+
+/// The decoded validation part of a converted dataset, shared by the evaluations of several networks.
+struct ValidationSet
+{
+  std::string convertedDatasetPath;
+  std::vector<ValidationSample> samples;
+  std::vector<std::string> failedSamples;
+};
+
+/**
+ * Validates a network on the validation part of a converted dataset (imagesV/masksV).
+ * Samples are decoded and accumulated in parallel, forwarded in batches; every sample gets its own counts
+ * which are merged on the calling thread, so nothing is locked per pixel and the result does not depend
+ * on the threads count. Metrics are computed at the network output resolution, the truth is scaled to it
+ * by the nearest neighbour. A pixel predicted as several classes counts as the first one in the confusion matrix.
+ * Objects are the boxes of UNet::foundBoundingBoxes on the predicted and on the true masks, matched greedily by IoU.
+ * The probability cache of a canceled run is removed, so an incomplete cache is never taken for the whole dataset.
+ */
+struct ValidationMetrics
+{
+  /// Called on the calling thread in the samples order.
+  using ProgressCallback = std::function<void(size_t processed, size_t total)>;
+
+  /// Loads options.network for this evaluation, outside of RoiModelRegistry, so retrained weights are always read.
+  static auto evaluate(std::string const& convertedDatasetPath,
+                       ValidationOptions const& options,
+                       std::atomic<bool> const& isCanceled,
+                       ProgressCallback const& onProgress) -> ValidationReport;
+  /// Decodes the validation part into memory once (in parallel), so every further network is evaluated
+  /// without reading and decoding the images and masks again. The whole set is kept decoded.
+  static auto loadValidationSet(std::string const& convertedDatasetPath,
+                                size_t threadsCount,
+                                std::atomic<bool> const& isCanceled) -> ValidationSet;
+  /// The same as evaluate of the dataset on the decoded set, with the detector instead of options.network,
+  /// so detectors of different weights could evaluate one set at once.
+  static auto evaluate(ValidationSet const& set,
+                       RoiDetector& detector,
+                       ValidationOptions const& options,
+                       std::atomic<bool> const& isCanceled,
+                       ProgressCallback const& onProgress) -> ValidationReport;
+  /// Counts of one sample: binary masks (0/255) per class against the truth mask (class colors or indices).
+  static void accumulate(std::vector<cv::Mat> const& predictions,
+                         cv::Mat const& truth,
+                         ValidationOptions const& options,
+                         std::vector<ClassMetrics>& classes,
+                         std::vector<uint64_t>& confusion);
+  /// Identity of the network outputs on the dataset: the model and weights stamps, the input settings,
+  /// the classes and the conversion manifest stamp. Thresholds are not a part of it.
+  static auto probabilityCacheKey(std::string const& convertedDatasetPath, ValidationOptions const& options) -> std::string;
+  /// Writes report.json, classes.csv, confusion.csv and images.csv into the directory.
+  static bool saveReport(ValidationReport const& report, std::string const& directoryPath);
+};
@@ -0,0 +1,490 @@
+#include "CheckpointRanking.hpp"
+#include "DatasetIndexCache.hpp"
+#include "ProjectFile.hpp"
+#include "ProjectWorkflow.hpp"
+#include "ThresholdSweep.hpp"
+
+#include <UNet/TrainUnet2D.hpp>
+
+#include <boost/property_tree/json_parser.hpp>
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace bp = boost::property_tree;
+
+namespace {
+std::atomic<bool> isCanceled{false};
+
+void cancel(int)
+{
+  isCanceled = true;
+}
+
+void prepareTrainer()
+{
+  /// The trainer does not check the cancel flag, it is stopped by the default handlers instead
+  std::signal(SIGINT, SIG_DFL);
+  std::signal(SIGTERM, SIG_DFL);
+  /// Progress reaches a monitoring parent (the GUI training session) line by line, not in pipe buffer chunks
+  std::setvbuf(stdout, nullptr, _IOLBF, BUFSIZ);
+}
+
+void printUsage()
+{
+  std::cerr << "Usage: unet-training-tool-cli <command> <project.json> [options]\n"
+               "Commands:\n"
+               "  index\n"
+               "            index the project datasets and update the persistent index\n"
+               "  split     --output DIR [--threads N] [--no-hardlinks]\n"
+               "            export the samples into DIR/<class>/images|data, images are hard linked, reflinked or copied\n"
+               "  convert   --output DIR [--threads N] [--validation-fraction F] [--seed N] [--not-stratified]\n"
+               "            [--class-index-masks] [--full]\n"
+               "            the split options are stored in the project \"split\" section with the split itself\n"
+               "            convert the project datasets into the training layout\n"
+               "            only changed samples are converted again unless --full is set\n"
+               "  train     --converted DIR [--model-dir DIR] [--eval] [--class-index-masks] [--resume]\n"
+               "            generate the network (when --model-dir is set) and train it\n"
+               "            --resume starts from the latest checkpoint of UNet.modelFilePath instead of UNet.weightsFilePath\n"
+               "            --class-index-masks overrides UNet.classIndexMasks, it must match between convert and train\n"
+               "            and is refused unless the build knows the trainer reads class index masks\n"
+               "  validate  [--converted DIR] [--report DIR] [--threads N] [--min-iou X]\n"
+               "            evaluate UNet.modelFilePath/UNet.weightsFilePath on the validation part, UNet.validDatasetPath by default\n"
+               "            per class IoU, Dice, precision/recall, object matching and the confusion matrix are written\n"
+               "            into --report (DIR/validation-report by default), exits with 3 when the mean IoU is below --min-iou\n"
+               "            --sweep [--apply-best f1|iou]\n"
+               "            keep the quantized probabilities in the report probabilities.cache and sweep the thresholds on them,\n"
+               "            PR curves and the best thresholds per class go to sweep.csv and thresholds.json, the network is not run\n"
+               "            again while the cache matches it (unless --min-iou is set); --apply-best stores the thresholds\n"
+               "            of the best F1 or IoU into the project \"classSettings\"\n"
+               "  rank      [--converted DIR] [--checkpoints DIR] [--parallel N] [--threads N]\n"
+               "            evaluate every checkpoint (of UNet.modelFilePath by default) on the validation part decoded once,\n"
+               "            N checkpoints at once (2 by default); the ranking is stored in the project \"leaderboard\" section\n"
+               "            and the best checkpoint becomes UNet.weightsFilePath\n";
+}
+
+/// "--key value" pairs and "--flag" switches after the project file
+auto parseOptions(int argc, char* argv[]) -> std::map<std::string, std::string>
+{
+  std::map<std::string, std::string> options;
+  for (int i = 3; i < argc; ++i)
+  {
+    std::string key = argv[i];
+    if (((i + 1) < argc) && (std::string(argv[i + 1]).rfind("--", 0) != 0))
+    {
+      options[key] = argv[++i];
+    }
+    else
+    {
+      options[key] = "yes";
+    }
+  }
+  return options;
+}
+
+auto option(std::map<std::string, std::string> const& options, std::string const& key, std::string const& defaultValue = {}) -> std::string
+{
+  auto it = options.find(key);
+  return (it != options.end()) ? it->second : defaultValue;
+}
+
+int runIndex(std::string const& projectFile, bp::ptree const& pt)
+{
+  size_t total = 0;
+  size_t processed = 0;
+  size_t wrong = 0;
+  ProjectWorkflow::indexDatasets(ProjectWorkflow::datasets(pt),
+                                 DatasetIndexCache::indexFilePathForProject(projectFile),
+                                 pt.get<bool>("index.contentHash", false),
+                                 isCanceled,
+                                 [&](size_t count) {
+                                   total = count;
+                                 },
+                                 [&](std::vector<DatasetSample>&& batch) {
+                                   for (auto const& sample : batch)
+                                   {
+                                     if (!sample.isValid)
+                                     {
+                                       ++wrong;
+                                       std::cerr << "Wrong annotation: " << sample.annotationPath << "\n";
+                                     }
+                                   }
+                                   processed += batch.size();
+                                   std::cout << "Indexed " << processed << " of " << total << std::endl;
+                                 });
+  std::cout << "Indexed " << processed << " samples, " << wrong << " wrong" << std::endl;
+  return isCanceled ? 1 : 0;
+}
+
+int runSplit(std::string const& projectFile, bp::ptree& pt, std::map<std::string, std::string> const& options)
+{
+  SplitExportOptions exportOptions;
+  exportOptions.outputDirectoryPath = option(options, "--output");
+  if (exportOptions.outputDirectoryPath.empty())
+  {
+    std::cerr << "split: --output is required\n";
+    return 2;
+  }
+  exportOptions.threadsCount = std::stoul(option(options, "--threads", "0"));
+  exportOptions.isHardlinkAllowed = (options.count("--no-hardlinks") == 0);
+  auto result = ProjectWorkflow::exportSplit(pt,
+                                             DatasetIndexCache::indexFilePathForProject(projectFile),
+                                             exportOptions,
+                                             isCanceled,
+                                             [](size_t processed, size_t total) {
+                                               if (((processed % 1000) == 0) || (processed == total))
+                                               {
+                                                 std::cout << "Exported " << processed << " of " << total << std::endl;
+                                               }
+                                             });
+  for (auto const& failedAnnotation : result.failedAnnotations)
+  {
+    std::cerr << "Could not be exported: " << failedAnnotation << "\n";
+  }
+  std::cout << "Exported " << result.exportedCount << " samples: " << result.hardlinksCount << " hard links, "
+            << result.reflinksCount << " reflinks, " << result.copiesCount << " copies, "
+            << result.failedAnnotations.size() << " failed" << std::endl;
+  return (isCanceled || !result.failedAnnotations.empty()) ? 1 : 0;
+}
+
+int runConvert(std::string const& projectFile, bp::ptree& pt, std::map<std::string, std::string> const& options)
+{
+  auto outputDirectoryPath = option(options, "--output");
+  if (options.count("--class-index-masks") != 0)
+  {
+    pt.put<bool>("UNet.classIndexMasks", true);
+  }
+  if (outputDirectoryPath.empty())
+  {
+    std::cerr << "convert: --output is required\n";
+    return 2;
+  }
+  auto conversionOptions = ProjectWorkflow::conversionOptions(pt, outputDirectoryPath);
+  conversionOptions.threadsCount = std::stoul(option(options, "--threads", "0"));
+  conversionOptions.isIncremental = (options.count("--full") == 0);
+  if (options.count("--validation-fraction") != 0)
+  {
+    pt.put<float>("split.validationFraction", std::stof(option(options, "--validation-fraction")));
+  }
+  if (options.count("--seed") != 0)
+  {
+    pt.put<uint32_t>("split.seed", static_cast<uint32_t>(std::stoul(option(options, "--seed"))));
+  }
+  if (options.count("--not-stratified") != 0)
+  {
+    pt.put<bool>("split.stratified", false);
+  }
+  auto samples = ProjectWorkflow::conversionSamples(pt, DatasetIndexCache::indexFilePathForProject(projectFile));
+  ProjectFile::save(projectFile, pt);
+  DatasetConverter::RoiCallback roiCallback;
+  if (!ProjectWorkflow::roiCallback(pt, roiCallback))
+  {
+    std::cerr << "Could not be loaded ROI model: " << pt.get<std::string>("ROI.modelFilePath", "") << "\n";
+    return 1;
+  }
+  auto result = DatasetConverter::convert(std::move(samples), conversionOptions, roiCallback, isCanceled, [](size_t processed, size_t total) {
+    if (((processed % 100) == 0) || (processed == total))
+    {
+      std::cout << "Converted " << processed << " of " << total << std::endl;
+    }
+  });
+  for (auto const& failedAnnotation : result.failedAnnotations)
+  {
+    std::cerr << "Could not be converted: " << failedAnnotation << "\n";
+  }
+  std::cout << "Converted " << result.convertedCount << " samples, " << result.upToDateCount << " up to date, "
+            << result.removedCount << " outputs removed, " << result.failedAnnotations.size() << " failed" << std::endl;
+  return (isCanceled || !result.failedAnnotations.empty()) ? 1 : 0;
+}
+
+int runTrain(std::string const& projectFile, bp::ptree& pt, std::map<std::string, std::string> const& options)
+{
+  auto convertedDatasetPath = option(options, "--converted");
+  if (convertedDatasetPath.empty())
+  {
+    std::cerr << "train: --converted is required\n";
+    return 2;
+  }
+  auto modelDirectoryPath = option(options, "--model-dir");
+  if (!modelDirectoryPath.empty())
+  {
+    ProjectWorkflow::generateModel(pt, modelDirectoryPath);
+    ProjectFile::save(projectFile, pt);
+  }
+  if (options.count("--class-index-masks") != 0)
+  {
+    pt.put<bool>("UNet.classIndexMasks", true);
+  }
+  if (pt.get<std::string>("UNet.modelFilePath", "").empty())
+  {
+    std::cerr << "train: UNet.modelFilePath is not set, use --model-dir to generate the network\n";
+    return 2;
+  }
+  if (auto const problem = ProjectWorkflow::validateClasses(pt); !problem.empty())
+  {
+    std::cerr << "train: " << problem << "\n";
+    return 2;
+  }
+  if (auto const problem = ProjectWorkflow::validateTrainerSupport(pt); !problem.empty())
+  {
+    std::cerr << "train: " << problem << "\n";
+    return 2;
+  }
+  if (options.count("--resume") != 0)
+  {
+    auto const checkpoint = ProjectWorkflow::latestCheckpoint(pt);
+    if (checkpoint.empty())
+    {
+      std::cerr << "train: no checkpoint of " << pt.get<std::string>("UNet.modelFilePath") << " to resume from\n";
+      return 2;
+    }
+    std::cout << "Resuming from " << checkpoint << std::endl;
+    pt.put<std::string>("UNet.weightsFilePath", checkpoint);
+  }
+  prepareTrainer();
+  runOpts(ProjectWorkflow::trainingParams(pt, convertedDatasetPath, options.count("--eval") != 0));
+  return 0;
+}
+
+int runSweep(std::string const& projectFile, bp::ptree& pt, std::map<std::string, std::string> const& options,
+             std::string const& cachePath, std::string const& reportDirectoryPath, size_t threadsCount)
+{
+  ProbabilityCacheReader cache;
+  if (!cache.open(cachePath))
+  {
+    std::cerr << "validate: the probability cache " << cachePath << " could not be read\n";
+    return 1;
+  }
+  auto const validationOptions = ProjectWorkflow::validationOptions(pt);
+  auto const sweeps = ThresholdSweep::sweep(cache, validationOptions.classNames, threadsCount, isCanceled);
+  if (isCanceled)
+  {
+    return 1;
+  }
+  for (auto const& classSweep : sweeps)
+  {
+    auto const& bestF1 = classSweep.points[classSweep.bestF1];
+    auto const& bestIou = classSweep.points[classSweep.bestIou];
+    std::cout << classSweep.className << ": best F1 " << bestF1.metrics.dice() << " at " << bestF1.threshold
+              << ", best IoU " << bestIou.metrics.iou() << " at " << bestIou.threshold << "\n";
+  }
+  if (!ThresholdSweep::saveSweep(sweeps, reportDirectoryPath))
+  {
+    std::cerr << "Could not be written the sweep into " << reportDirectoryPath << "\n";
+    return 1;
+  }
+
+  auto const apply = option(options, "--apply-best");
+  if (apply.empty())
+  {
+    return 0;
+  }
+  if ((apply != "f1") && (apply != "iou"))
+  {
+    std::cerr << "validate: --apply-best is f1 or iou\n";
+    return 2;
+  }
+  auto classSettings = ProjectFile::loadClassSettings(pt);
+  for (auto const& classSweep : sweeps)
+  {
+    auto const best = (apply == "f1") ? classSweep.bestF1 : classSweep.bestIou;
+    classSettings[classSweep.className].threshold = classSweep.points[best].threshold;
+  }
+  ProjectFile::saveClassSettings(pt, classSettings);
+  if (!ProjectFile::save(projectFile, pt))
+  {
+    std::cerr << "Could not be saved the project " << projectFile << "\n";
+    return 1;
+  }
+  std::cout << "Thresholds of the best " << apply << " are stored in the project" << std::endl;
+  return 0;
+}
+
+int runValidate(std::string const& projectFile, bp::ptree& pt, std::map<std::string, std::string> const& options)
+{
+  auto convertedDatasetPath = option(options, "--converted", pt.get<std::string>("UNet.validDatasetPath", ""));
+  if (convertedDatasetPath.empty() || pt.get<std::string>("UNet.modelFilePath", "").empty())
+  {
+    std::cerr << "validate: UNet.modelFilePath and the converted dataset (--converted or UNet.validDatasetPath) are required\n";
+    return 2;
+  }
+  if (auto const problem = ProjectWorkflow::validateClasses(pt); !problem.empty())
+  {
+    std::cerr << "validate: " << problem << "\n";
+    return 2;
+  }
+  auto validationOptions = ProjectWorkflow::validationOptions(pt);
+  validationOptions.threadsCount = std::stoul(option(options, "--threads", "0"));
+  auto const reportDirectoryPath = option(options, "--report", convertedDatasetPath + "/validation-report");
+  auto const isSweep = (options.count("--sweep") != 0);
+  auto const cachePath = reportDirectoryPath + "/probabilities.cache";
+  if (isSweep)
+  {
+    ProbabilityCacheReader cache;
+    if ((options.count("--min-iou") == 0) && cache.open(cachePath) &&
+        (cache.key() == ValidationMetrics::probabilityCacheKey(convertedDatasetPath, validationOptions)))
+    {
+      std::cout << "Probabilities are taken from " << cachePath << std::endl;
+      return runSweep(projectFile, pt, options, cachePath, reportDirectoryPath, validationOptions.threadsCount);
+    }
+    validationOptions.probabilityCachePath = cachePath;
+  }
+  auto const report = ValidationMetrics::evaluate(convertedDatasetPath, validationOptions, isCanceled, [](size_t processed, size_t total) {
+    if (((processed % 100) == 0) || (processed == total))
+    {
+      std::cout << "Validated " << processed << " of " << total << std::endl;
+    }
+  });
+  for (auto const& failedSample : report.failedSamples)
+  {
+    std::cerr << "Could not be validated: " << failedSample << "\n";
+  }
+  for (size_t i = 0; i < report.classes.size(); ++i)
+  {
+    auto const& metrics = report.classes[i];
+    std::cout << report.classNames[i] << ": IoU " << metrics.iou() << ", Dice " << metrics.dice() << ", precision " << metrics.precision()
+              << ", recall " << metrics.recall() << ", objects " << metrics.matchedObjects << " matched of " << metrics.trueObjects
+              << " true and " << metrics.predictedObjects << " predicted\n";
+  }
+  std::cout << "Validated " << report.images.size() << " images, mean IoU: " << report.meanIou() << std::endl;
+
+  if (!ValidationMetrics::saveReport(report, reportDirectoryPath))
+  {
+    std::cerr << "Could not be written the report into " << reportDirectoryPath << "\n";
+    return 1;
+  }
+  std::cout << "Report: " << reportDirectoryPath << std::endl;
+  if (isCanceled || report.images.empty())
+  {
+    return 1;
+  }
+  /// Release gate, e.g. in CI
+  if ((options.count("--min-iou") != 0) && (report.meanIou() < std::stod(option(options, "--min-iou"))))
+  {
+    std::cerr << "validate: mean IoU " << report.meanIou() << " is below " << option(options, "--min-iou") << "\n";
+    return 3;
+  }
+  return isSweep ? runSweep(projectFile, pt, options, cachePath, reportDirectoryPath, validationOptions.threadsCount) : 0;
+}
+
+int runRank(std::string const& projectFile, bp::ptree& pt, std::map<std::string, std::string> const& options)
+{
+  auto convertedDatasetPath = option(options, "--converted", pt.get<std::string>("UNet.validDatasetPath", ""));
+  if (convertedDatasetPath.empty() || pt.get<std::string>("UNet.modelFilePath", "").empty())
+  {
+    std::cerr << "rank: UNet.modelFilePath and the converted dataset (--converted or UNet.validDatasetPath) are required\n";
+    return 2;
+  }
+  if (auto const problem = ProjectWorkflow::validateClasses(pt); !problem.empty())
+  {
+    std::cerr << "rank: " << problem << "\n";
+    return 2;
+  }
+  auto const checkpointsDirectoryPath = option(options, "--checkpoints", ProjectWorkflow::checkpointsDirectory(pt));
+  auto const weightsFilePaths = ProjectWorkflow::checkpoints(checkpointsDirectoryPath);
+  if (weightsFilePaths.empty())
+  {
+    std::cerr << "rank: no checkpoints in " << checkpointsDirectoryPath << "\n";
+    return 2;
+  }
+  auto validationOptions = ProjectWorkflow::validationOptions(pt);
+  validationOptions.threadsCount = std::stoul(option(options, "--threads", "0"));
+
+  auto const set = ValidationMetrics::loadValidationSet(convertedDatasetPath, validationOptions.threadsCount, isCanceled);
+  for (auto const& failedSample : set.failedSamples)
+  {
+    std::cerr << "Could not be loaded: " << failedSample << "\n";
+  }
+  if (isCanceled || set.samples.empty())
+  {
+    std::cerr << "rank: no validation samples in " << convertedDatasetPath << "\n";
+    return 1;
+  }
+  std::cout << "Loaded " << set.samples.size() << " validation samples, ranking " << weightsFilePaths.size() << " checkpoints" << std::endl;
+
+  auto const scores = CheckpointRanking::rank(set, weightsFilePaths, validationOptions, std::stoul(option(options, "--parallel", "2")), isCanceled,
+                                              [](CheckpointScore const& score, size_t evaluated, size_t total) {
+    if (score.isLoaded)
+    {
+      std::cout << "Evaluated " << evaluated << " of " << total << ": " << score.weightsFilePath << ", mean IoU " << score.report.meanIou() << std::endl;
+    }
+    else
+    {
+      std::cerr << "Could not be loaded: " << score.weightsFilePath << "\n";
+    }
+  });
+  if (isCanceled || scores.empty() || !scores.front().isLoaded)
+  {
+    return 1;
+  }
+  for (size_t i = 0; (i < scores.size()) && scores[i].isLoaded; ++i)
+  {
+    std::cout << (i + 1) << ". " << scores[i].weightsFilePath << ": mean IoU " << scores[i].report.meanIou() << "\n";
+  }
+  CheckpointRanking::saveLeaderboard(pt, scores);
+  pt.put<std::string>("UNet.weightsFilePath", scores.front().weightsFilePath);
+  if (!ProjectFile::save(projectFile, pt))
+  {
+    std::cerr << "Could not be saved the project " << projectFile << "\n";
+    return 1;
+  }
+  std::cout << "Best checkpoint: " << scores.front().weightsFilePath << std::endl;
+  return 0;
+}
+} /// end namespace anonymous
+
+int main(int argc, char* argv[])
+{
+  if (argc < 3)
+  {
+    printUsage();
+    return 2;
+  }
+  std::signal(SIGINT, cancel);
+  std::signal(SIGTERM, cancel);
+
+  std::string const command = argv[1];
+  std::string const projectFile = argv[2];
+  auto const options = parseOptions(argc, argv);
+  bp::ptree pt;
+  try
+  {
+    bp::read_json(projectFile, pt);
+    if (command == "index")
+    {
+      return runIndex(projectFile, pt);
+    }
+    if (command == "split")
+    {
+      return runSplit(projectFile, pt, options);
+    }
+    if (command == "convert")
+    {
+      return runConvert(projectFile, pt, options);
+    }
+    if (command == "train")
+    {
+      return runTrain(projectFile, pt, options);
+    }
+    if (command == "validate")
+    {
+      return runValidate(projectFile, pt, options);
+    }
+    if (command == "rank")
+    {
+      return runRank(projectFile, pt, options);
+    }
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << command << ": " << e.what() << "\n";
+    return 1;
+  }
+  printUsage();
+  return 2;
+}
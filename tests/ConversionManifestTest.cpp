@@ -0,0 +1,74 @@
+#include "ConversionManifest.hpp"
+#include "TemporaryDirectory.hpp"
+
+#include <gtest/gtest.h>
+
+TEST(ConversionManifest, OutputIsFreshWhileSourcesAreTheSame)
+{
+  TemporaryDirectory directory;
+  auto const image = directory.write("image.png", "image");
+  auto const annotation = directory.write("image.json", "{}");
+  {
+    ConversionManifest manifest(directory.path(), "parameters");
+    EXPECT_FALSE(manifest.load());
+    EXPECT_FALSE(manifest.isFresh("T/image.png", image, annotation));
+    manifest.store("T/image.png", image, annotation);
+    ASSERT_TRUE(manifest.save());
+  }
+  ConversionManifest manifest(directory.path(), "parameters");
+  ASSERT_TRUE(manifest.load());
+  EXPECT_TRUE(manifest.isFresh("T/image.png", image, annotation));
+  EXPECT_FALSE(manifest.isFresh("V/image.png", image, annotation));
+}
+
+TEST(ConversionManifest, ChangedSourceIsStale)
+{
+  TemporaryDirectory directory;
+  auto const image = directory.write("image.png", "image");
+  auto const annotation = directory.write("image.json", "{}");
+  ConversionManifest manifest(directory.path(), "parameters");
+  manifest.store("T/image.png", image, annotation);
+  ASSERT_TRUE(manifest.save());
+
+  directory.write("image.json", "{\"shapes\": []}");
+  ConversionManifest loaded(directory.path(), "parameters");
+  ASSERT_TRUE(loaded.load());
+  EXPECT_FALSE(loaded.isFresh("T/image.png", image, annotation));
+}
+
+TEST(ConversionManifest, OtherParametersDropTheManifest)
+{
+  TemporaryDirectory directory;
+  auto const image = directory.write("image.png", "image");
+  auto const annotation = directory.write("image.json", "{}");
+  ConversionManifest manifest(directory.path(), "size=256");
+  manifest.store("T/image.png", image, annotation);
+  ASSERT_TRUE(manifest.save());
+
+  ConversionManifest loaded(directory.path(), "size=512");
+  EXPECT_FALSE(loaded.load());
+  EXPECT_FALSE(loaded.isFresh("T/image.png", image, annotation));
+}
+
+TEST(ConversionManifest, PruneKeepsOnlyUsedOutputs)
+{
+  TemporaryDirectory directory;
+  auto const image = directory.write("image.png", "image");
+  auto const annotation = directory.write("image.json", "{}");
+  {
+    ConversionManifest manifest(directory.path(), "parameters");
+    manifest.store("T/kept.png", image, annotation);
+    manifest.store("T/removed.png", image, annotation);
+    ASSERT_TRUE(manifest.save());
+  }
+  {
+    ConversionManifest manifest(directory.path(), "parameters");
+    ASSERT_TRUE(manifest.load());
+    EXPECT_TRUE(manifest.isFresh("T/kept.png", image, annotation));
+    ASSERT_TRUE(manifest.save());
+  }
+  ConversionManifest manifest(directory.path(), "parameters");
+  ASSERT_TRUE(manifest.load());
+  EXPECT_TRUE(manifest.isFresh("T/kept.png", image, annotation));
+  EXPECT_FALSE(manifest.isFresh("T/removed.png", image, annotation));
+}
@@ -0,0 +1,92 @@
+#include "DatasetSplitter.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+namespace {
+auto samples(size_t count, size_t first = 0) -> std::vector<ConversionSample>
+{
+  std::vector<ConversionSample> result;
+  for (size_t i = first; i < first + count; ++i)
+  {
+    result.push_back(ConversionSample{"images/" + std::to_string(i) + ".png", "images/" + std::to_string(i) + ".json", true});
+  }
+  return result;
+}
+
+auto validationCount(std::vector<ConversionSample> const& samples) -> size_t
+{
+  return static_cast<size_t>(std::count_if(samples.cbegin(), samples.cend(), [](auto const& sample) { return !sample.isTraining; }));
+}
+} /// end namespace anonymous
+
+TEST(DatasetSplitter, DoesNotDependOnTheSamplesOrder)
+{
+  SplitOptions const options{0.2f, 7, false};
+  auto forward = samples(50);
+  auto backward = std::vector<ConversionSample>(forward.rbegin(), forward.rend());
+  SplitAssignment forwardAssignment;
+  SplitAssignment backwardAssignment;
+  DatasetSplitter::split(forward, {}, options, forwardAssignment);
+  DatasetSplitter::split(backward, {}, options, backwardAssignment);
+
+  EXPECT_EQ(validationCount(forward), 10u);
+  EXPECT_EQ(forwardAssignment.validation, backwardAssignment.validation);
+  EXPECT_EQ(forwardAssignment.training, backwardAssignment.training);
+}
+
+TEST(DatasetSplitter, SeedChangesTheSplit)
+{
+  auto first = samples(50);
+  auto second = samples(50);
+  SplitAssignment firstAssignment;
+  SplitAssignment secondAssignment;
+  DatasetSplitter::split(first, {}, SplitOptions{0.2f, 1, false}, firstAssignment);
+  DatasetSplitter::split(second, {}, SplitOptions{0.2f, 2, false}, secondAssignment);
+
+  EXPECT_NE(firstAssignment.validation, secondAssignment.validation);
+}
+
+TEST(DatasetSplitter, NewSamplesDoNotMoveAssignedOnes)
+{
+  SplitOptions const options{0.2f, 3, false};
+  auto initial = samples(20);
+  SplitAssignment assignment;
+  DatasetSplitter::split(initial, {}, options, assignment);
+  auto const initialValidation = assignment.validation;
+
+  auto grown = samples(30);
+  DatasetSplitter::split(grown, {}, options, assignment);
+
+  for (auto const& imagePath : initialValidation)
+  {
+    EXPECT_EQ(assignment.validation.count(imagePath), 1u) << imagePath;
+  }
+  EXPECT_EQ(validationCount(grown), 6u);
+}
+
+TEST(DatasetSplitter, StratifiesByTheRarestClass)
+{
+  /// Every tenth sample has the rare class, a plain split of 20% could miss all of them
+  auto all = samples(100);
+  std::vector<std::map<std::string, uint32_t>> labelsCount(all.size());
+  for (size_t i = 0; i < all.size(); ++i)
+  {
+    labelsCount[i]["common"] = 1;
+    if (i % 10 == 0)
+    {
+      labelsCount[i]["rare"] = 1;
+    }
+  }
+  SplitAssignment assignment;
+  DatasetSplitter::split(all, labelsCount, SplitOptions{0.2f, 5, true}, assignment);
+
+  size_t rareValidation = 0;
+  for (size_t i = 0; i < all.size(); i += 10)
+  {
+    rareValidation += all[i].isTraining ? 0 : 1;
+  }
+  EXPECT_EQ(rareValidation, 2u);
+  EXPECT_EQ(validationCount(all), 20u);
+}
@@ -0,0 +1,84 @@
+#include "LabelMeReader.hpp"
+#include "TemporaryDirectory.hpp"
+
+#include <gtest/gtest.h>
+
+TEST(LabelMeReader, ParsesRequestedFields)
+{
+  auto const json = R"({
+    "version": "4.5.6",
+    "flags": {},
+    "shapes": [
+      {"label": "cat", "points": [[1, 2], [3.5, 4], [5, 6e1]], "group_id": null, "shape_type": "polygon", "flags": {}},
+      {"label": "dog", "points": [[0, 0], [10, 10]], "shape_type": "rectangle"}
+    ],
+    "imagePath": "images\/cat \"1\".png",
+    "imageData": "iVBORw0KGgoAAAANSUhEUgAA\"escaped\"AAAA",
+    "imageHeight": 480,
+    "imageWidth": 640
+  })";
+  LabelMeAnnotation annotation;
+  ASSERT_TRUE(LabelMeReader::parse(json, annotation));
+  EXPECT_EQ(annotation.imagePath, "images/cat \"1\".png");
+  EXPECT_EQ(annotation.imageWidth, 640);
+  EXPECT_EQ(annotation.imageHeight, 480);
+  ASSERT_EQ(annotation.shapes.size(), 2u);
+  EXPECT_EQ(annotation.shapes[0].label, "cat");
+  EXPECT_EQ(annotation.shapes[0].shapeType, "polygon");
+  ASSERT_EQ(annotation.shapes[0].points.size(), 3u);
+  EXPECT_FLOAT_EQ(annotation.shapes[0].points[1].x, 3.5f);
+  EXPECT_FLOAT_EQ(annotation.shapes[0].points[2].y, 60.0f);
+  EXPECT_EQ(annotation.shapes[1].shapeType, "rectangle");
+  EXPECT_EQ((annotation.labelsCount()), (std::map<std::string, uint32_t>{{"cat", 1}, {"dog", 1}}));
+}
+
+TEST(LabelMeReader, SkipsFieldsNotRequested)
+{
+  LabelMeAnnotation annotation;
+  ASSERT_TRUE(LabelMeReader::parse(R"({"shapes": [{"label": "cat", "points": [[1, 2]]}], "imagePath": "a.png"})",
+                                   annotation,
+                                   LabelMeReader::ImagePath));
+  EXPECT_EQ(annotation.imagePath, "a.png");
+  EXPECT_TRUE(annotation.shapes.empty());
+}
+
+TEST(LabelMeReader, KeepsPolygonForMissingShapeType)
+{
+  LabelMeAnnotation annotation;
+  ASSERT_TRUE(LabelMeReader::parse(R"({"shapes": [{"label": "cat", "points": [], "shape_type": null}]})", annotation));
+  ASSERT_EQ(annotation.shapes.size(), 1u);
+  EXPECT_EQ(annotation.shapes[0].shapeType, "polygon");
+}
+
+TEST(LabelMeReader, RejectsInvalidJson)
+{
+  LabelMeAnnotation annotation;
+  EXPECT_FALSE(LabelMeReader::parse(R"({"imagePath": "a.png")", annotation));
+  EXPECT_FALSE(LabelMeReader::parse(R"(["imagePath"])", annotation));
+}
+
+TEST(LabelMeReader, CopyReplacesOnlyTheImagePath)
+{
+  TemporaryDirectory directory;
+  auto const source = directory.write("source.json", "{\n  \"imagePath\" : \"old.png\",\n  \"imageData\": null\n}\n");
+  auto const destination = directory.path() + "/destination.json";
+  ASSERT_TRUE(LabelMeReader::copyWithImagePath(source, destination, "new.png"));
+  EXPECT_EQ(TemporaryDirectory::read(destination), "{\n  \"imagePath\" : \"new.png\",\n  \"imageData\": null\n}\n");
+}
+
+TEST(LabelMeReader, CopyAddsTheImagePath)
+{
+  TemporaryDirectory directory;
+  auto const destination = directory.path() + "/destination.json";
+
+  ASSERT_TRUE(LabelMeReader::copyWithImagePath(directory.write("members.json", "{\"shapes\": []}"), destination, "a.png"));
+  EXPECT_EQ(TemporaryDirectory::read(destination), "{\"imagePath\": \"a.png\",\"shapes\": []}");
+  LabelMeAnnotation annotation;
+  EXPECT_TRUE(LabelMeReader::read(destination, annotation));
+
+  /// No trailing comma in an empty object
+  ASSERT_TRUE(LabelMeReader::copyWithImagePath(directory.write("empty.json", "{}"), destination, "a.png"));
+  EXPECT_EQ(TemporaryDirectory::read(destination), "{\"imagePath\": \"a.png\"}");
+  EXPECT_TRUE(LabelMeReader::read(destination, annotation));
+  EXPECT_EQ(annotation.imagePath, "a.png");
+}
@@ -0,0 +1,61 @@
+#include "LabelStatistics.hpp"
+
+#include <gtest/gtest.h>
+
+namespace {
+cv::Vec3b const background(0, 0, 0);
+cv::Vec3b const red(0, 0, 255);
+cv::Vec3b const green(0, 255, 0);
+} /// end namespace anonymous
+
+TEST(LabelStatistics, JoinsComponentsMetLater)
+{
+  /// A "U": both arms get their own provisional labels, joined only by the bottom row
+  cv::Mat labels(4, 5, CV_8UC3, cv::Scalar::all(0));
+  for (int r = 0; r < 4; ++r)
+  {
+    labels.at<cv::Vec3b>(r, 0) = red;
+    labels.at<cv::Vec3b>(r, 4) = red;
+  }
+  for (int c = 0; c < 5; ++c)
+  {
+    labels.at<cv::Vec3b>(3, c) = red;
+  }
+
+  auto const statistics = LabelStatistics::calculate(labels);
+  ASSERT_EQ(statistics.boundingBoxes.at(red).size(), 1u);
+  EXPECT_EQ(statistics.boundingBoxes.at(red).front(), cv::Rect(0, 0, 5, 4));
+  EXPECT_EQ(statistics.pixelsCount.at(red), 11u);
+  EXPECT_EQ(statistics.pixelsCount.at(background), 9u);
+}
+
+TEST(LabelStatistics, UsesEightConnectivity)
+{
+  cv::Mat labels(3, 3, CV_8UC3, cv::Scalar::all(0));
+  labels.at<cv::Vec3b>(0, 0) = green;
+  labels.at<cv::Vec3b>(1, 1) = green;
+  labels.at<cv::Vec3b>(0, 2) = red;
+  labels.at<cv::Vec3b>(2, 0) = red;
+
+  auto const statistics = LabelStatistics::calculate(labels);
+  ASSERT_EQ(statistics.boundingBoxes.at(green).size(), 1u);
+  EXPECT_EQ(statistics.boundingBoxes.at(green).front(), cv::Rect(0, 0, 2, 2));
+  /// The red pixels touch the green diagonal only, they are two components
+  EXPECT_EQ(statistics.boundingBoxes.at(red).size(), 2u);
+  EXPECT_EQ(statistics.pixelsCount.at(red), 2u);
+}
+
+TEST(LabelStatistics, MergeAddsBoxesAndCounts)
+{
+  cv::Mat labels(2, 2, CV_8UC3, cv::Scalar(0, 0, 255));
+  auto statistics = LabelStatistics::calculate(labels);
+  statistics.merge(LabelStatistics::calculate(labels));
+  EXPECT_EQ(statistics.boundingBoxes.at(red).size(), 2u);
+  EXPECT_EQ(statistics.pixelsCount.at(red), 8u);
+}
+
+TEST(LabelStatistics, SkipsOtherTypes)
+{
+  EXPECT_TRUE(LabelStatistics::calculate(cv::Mat(2, 2, CV_8UC1, cv::Scalar::all(1))).pixelsCount.empty());
+  EXPECT_TRUE(LabelStatistics::calculate(cv::Mat()).pixelsCount.empty());
+}
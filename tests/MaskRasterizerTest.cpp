@@ -0,0 +1,63 @@
+#include "MaskRasterizer.hpp"
+
+#include <gtest/gtest.h>
+
+namespace {
+auto square(std::string const& label, std::string const& shapeType) -> LabelMeShape
+{
+  LabelMeShape shape;
+  shape.label = label;
+  shape.shapeType = shapeType;
+  shape.points = {{2.0f, 2.0f}, {7.0f, 2.0f}, {7.0f, 7.0f}, {2.0f, 7.0f}};
+  return shape;
+}
+} /// end namespace anonymous
+
+TEST(MaskRasterizer, NumbersClassesInTheNamesOrder)
+{
+  auto const indices = MaskRasterizer::classIndices({{"dog", cv::Scalar(0, 255, 0)}, {"cat", cv::Scalar(0, 0, 255)}});
+  EXPECT_EQ(indices.at("cat"), 1);
+  EXPECT_EQ(indices.at("dog"), 2);
+}
+
+TEST(MaskRasterizer, DrawsClassIndices)
+{
+  LabelMeAnnotation annotation;
+  annotation.imageWidth = 10;
+  annotation.imageHeight = 10;
+  annotation.shapes = {square("dog", "polygon"), square("unknown", "polygon")};
+  annotation.shapes[1].points = {{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}};
+  cv::Mat target(10, 10, CV_8UC1, cv::Scalar::all(9));
+  MaskRasterizer::rasterize(annotation, {{"cat", cv::Scalar(0, 0, 255)}, {"dog", cv::Scalar(0, 255, 0)}}, {}, target);
+
+  EXPECT_EQ(target.at<uint8_t>(0, 0), 0);
+  EXPECT_EQ(target.at<uint8_t>(4, 4), 2);
+  EXPECT_EQ(cv::countNonZero(target), 36);
+}
+
+TEST(MaskRasterizer, DrawsEmptyShapeTypeAsPolygon)
+{
+  LabelMeAnnotation annotation;
+  annotation.shapes = {square("cat", "")};
+  cv::Mat target(10, 10, CV_8UC3);
+  MaskRasterizer::rasterize(annotation, {{"cat", cv::Scalar(0, 0, 255)}}, {}, target);
+
+  EXPECT_EQ(target.at<cv::Vec3b>(4, 4), cv::Vec3b(0, 0, 255));
+  EXPECT_EQ(target.at<cv::Vec3b>(0, 0), cv::Vec3b(0, 0, 0));
+}
+
+TEST(MaskRasterizer, ScalesAndOffsetsIntoTheTarget)
+{
+  LabelMeAnnotation annotation;
+  annotation.shapes = {square("cat", "polygon")};
+  MaskRasterizer::Transform transform;
+  transform.scaleX = 0.5;
+  transform.scaleY = 0.5;
+  transform.offset = cv::Point(1, 1);
+  cv::Mat target(4, 4, CV_8UC1);
+  MaskRasterizer::rasterize(annotation, {{"cat", cv::Scalar(0, 0, 255)}}, transform, target);
+
+  /// The square is (1, 1)-(3.5, 3.5) scaled, (0, 0)-(2.5, 2.5) in the target
+  EXPECT_EQ(target.at<uint8_t>(0, 0), 1);
+  EXPECT_EQ(target.at<uint8_t>(3, 3), 0);
+}
@@ -0,0 +1,96 @@
+#include "ProcessingPipeline.hpp"
+
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+auto numbers(size_t count) -> std::vector<int>
+{
+  std::vector<int> items(count);
+  std::iota(items.begin(), items.end(), 0);
+  return items;
+}
+} /// end namespace anonymous
+
+TEST(ProcessingPipeline, KeepsTheInputOrder)
+{
+  ProcessingPipeline<int> pipeline(2);
+  pipeline.addStage([](int& item) {
+    /// Later items are done first
+    std::this_thread::sleep_for(std::chrono::microseconds((100 - item % 100) * 10));
+    item *= 2;
+  }, 4);
+  std::vector<int> result;
+  std::atomic<bool> isCanceled{false};
+  pipeline.run(numbers(200), isCanceled, [&](int&& item) { result.push_back(item); });
+
+  ASSERT_EQ(result.size(), 200u);
+  for (size_t i = 0; i < result.size(); ++i)
+  {
+    EXPECT_EQ(result[i], static_cast<int>(i) * 2);
+  }
+}
+
+TEST(ProcessingPipeline, BatchStageFlushesPartialBatchForSlowItem)
+{
+  /// The window is smaller than the batch, the batch stage has to send what it has to let the slow item through
+  ProcessingPipeline<int> pipeline(1);
+  pipeline.addStage([](int& item) {
+    if (item == 0)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+  }, 2);
+  std::vector<size_t> batchSizes;
+  pipeline.addBatchStage([&](std::vector<int*> const& batch) { batchSizes.push_back(batch.size()); }, 16);
+  std::vector<int> result;
+  std::atomic<bool> isCanceled{false};
+  pipeline.run(numbers(40), isCanceled, [&](int&& item) { result.push_back(item); });
+
+  EXPECT_EQ(result, numbers(40));
+  EXPECT_EQ(std::accumulate(batchSizes.begin(), batchSizes.end(), size_t{0}), 40u);
+}
+
+TEST(ProcessingPipeline, StopsOnCancel)
+{
+  ProcessingPipeline<int> pipeline(2);
+  std::atomic<bool> isCanceled{false};
+  pipeline.addStage([&](int& item) {
+    if (item == 10)
+    {
+      isCanceled = true;
+    }
+  }, 2);
+  size_t sunk = 0;
+  pipeline.run(numbers(10000), isCanceled, [&](int&&) { ++sunk; });
+
+  EXPECT_LT(sunk, 10000u);
+}
+
+TEST(ProcessingPipeline, RethrowsStageException)
+{
+  ProcessingPipeline<int> pipeline(2);
+  pipeline.addStage([](int& item) {
+    if (item == 5)
+    {
+      throw std::runtime_error("stage failed");
+    }
+  }, 3);
+  std::atomic<bool> isCanceled{false};
+  EXPECT_THROW(pipeline.run(numbers(1000), isCanceled, [](int&&) {}), std::runtime_error);
+}
+
+TEST(ProcessingPipeline, RethrowsSinkException)
+{
+  ProcessingPipeline<int> pipeline(2);
+  pipeline.addStage([](int&) {}, 2);
+  std::atomic<bool> isCanceled{false};
+  EXPECT_THROW(pipeline.run(numbers(1000), isCanceled, [](int&& item) {
+    if (item == 5)
+    {
+      throw std::runtime_error("sink failed");
+    }
+  }), std::runtime_error);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#ifdef _MSC_VER
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <fstream>
+#include <random>
+#include <string>
+
+/// Empty directory under the system temporary one, removed with everything in it on destruction.
+class TemporaryDirectory
+{
+public:
+  TemporaryDirectory()
+  {
+    std::random_device device;
+    _path = (fs::temp_directory_path() / ("unet-training-tool-tests-" + std::to_string(device()))).string();
+    fs::create_directories(_path);
+  }
+  ~TemporaryDirectory()
+  {
+    std::error_code errorCode;
+    fs::remove_all(_path, errorCode);
+  }
+  TemporaryDirectory(TemporaryDirectory const&) = delete;
+  TemporaryDirectory& operator=(TemporaryDirectory const&) = delete;
+
+  auto path() const -> std::string const&
+  {
+    return _path;
+  }
+  auto write(std::string const& name, std::string const& content) const -> std::string
+  {
+    auto const filePath = _path + "/" + name;
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    file << content;
+    return filePath;
+  }
+  static auto read(std::string const& filePath) -> std::string
+  {
+    std::ifstream file(filePath, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+private:
+  std::string _path;
+};
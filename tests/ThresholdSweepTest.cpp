@@ -0,0 +1,58 @@
+#include "ThresholdSweep.hpp"
+#include "TemporaryDirectory.hpp"
+
+#include <gtest/gtest.h>
+
+namespace {
+auto row(std::initializer_list<uint8_t> values) -> cv::Mat
+{
+  return cv::Mat(std::vector<uint8_t>(values), true).reshape(1, 1);
+}
+} /// end namespace anonymous
+
+TEST(ThresholdSweep, SweepsQuantizedLevels)
+{
+  TemporaryDirectory directory;
+  auto const cachePath = directory.path() + "/probabilities.cache";
+  {
+    ProbabilityCacheWriter writer(cachePath, 1, "key");
+    /// Two pixels of the class at levels 255 and 128, two others at 127 and 0
+    ASSERT_TRUE(writer.append(ProbabilitySample{"sample", row({1, 1, 0, 0}), {row({255, 128, 127, 0})}}));
+    ASSERT_TRUE(writer.close());
+  }
+  ProbabilityCacheReader cache;
+  ASSERT_TRUE(cache.open(cachePath));
+  EXPECT_EQ(cache.key(), "key");
+  ASSERT_EQ(cache.size(), 1u);
+
+  std::atomic<bool> isCanceled{false};
+  auto const sweeps = ThresholdSweep::sweep(cache, {"cat"}, 2, isCanceled);
+  ASSERT_EQ(sweeps.size(), 1u);
+  auto const& sweep = sweeps.front();
+  EXPECT_EQ(sweep.className, "cat");
+  ASSERT_EQ(sweep.points.size(), static_cast<size_t>(ThresholdSweep::levelsCount - 1));
+
+  /// Level L holds the probabilities from (L - 0.5) / 255, it is reported as the threshold of L
+  auto const& best = sweep.points[sweep.bestF1];
+  EXPECT_EQ(sweep.bestF1, 127u);
+  EXPECT_FLOAT_EQ(best.threshold, 127.5f / 255.0f);
+  EXPECT_EQ(best.metrics.truePositives, 2u);
+  EXPECT_EQ(best.metrics.falsePositives, 0u);
+  EXPECT_EQ(sweep.bestIou, sweep.bestF1);
+
+  auto const& lowest = sweep.points.front();
+  EXPECT_FLOAT_EQ(lowest.threshold, 0.5f / 255.0f);
+  EXPECT_EQ(lowest.metrics.falsePositives, 1u);
+  auto const& highest = sweep.points.back();
+  EXPECT_EQ(highest.metrics.truePositives, 1u);
+  EXPECT_EQ(highest.metrics.falseNegatives, 1u);
+}
+
+TEST(ThresholdSweep, QuantizesByRounding)
+{
+  auto const levels = ProbabilityCacheWriter::quantize(cv::Mat(std::vector<float>{0.0f, 0.6f / 255.0f, 0.499f, 1.0f}, true).reshape(1, 1));
+  EXPECT_EQ(levels.at<uint8_t>(0, 0), 0);
+  EXPECT_EQ(levels.at<uint8_t>(0, 1), 1);
+  EXPECT_EQ(levels.at<uint8_t>(0, 2), 127);
+  EXPECT_EQ(levels.at<uint8_t>(0, 3), 255);
+}
@@ -0,0 +1,71 @@
+#include "TrainingLog.hpp"
+
+#include <gtest/gtest.h>
+
+#include <locale>
+#include <stdexcept>
+
+TEST(TrainingLog, ParsesKnownPairs)
+{
+  TrainingMetrics metrics;
+  ASSERT_TRUE(TrainingLog::parse("Epoch 3/200 iter=120 Loss: 0.25 mIoU 0.5 img/s 12.5", metrics));
+  EXPECT_EQ(metrics.epoch, 3u);
+  EXPECT_EQ(metrics.epochsCount, 200u);
+  EXPECT_EQ(metrics.iteration, 120u);
+  EXPECT_DOUBLE_EQ(*metrics.loss, 0.25);
+  EXPECT_DOUBLE_EQ(*metrics.iou, 0.5);
+  EXPECT_DOUBLE_EQ(*metrics.imagesPerSecond, 12.5);
+}
+
+TEST(TrainingLog, KeepsValuesMissingInTheLine)
+{
+  TrainingMetrics metrics;
+  ASSERT_TRUE(TrainingLog::parse("epoch 1/10 loss 0.5", metrics));
+  ASSERT_TRUE(TrainingLog::parse("loss 0.25", metrics));
+  EXPECT_EQ(metrics.epoch, 1u);
+  EXPECT_EQ(metrics.epochsCount, 10u);
+  EXPECT_DOUBLE_EQ(*metrics.loss, 0.25);
+}
+
+TEST(TrainingLog, IgnoresLinesWithoutValues)
+{
+  TrainingMetrics metrics;
+  EXPECT_FALSE(TrainingLog::parse("Loading weights from model.pt", metrics));
+  EXPECT_TRUE(metrics.isEmpty());
+}
+
+TEST(TrainingLog, KeepsEpochsCountOnZeroTotal)
+{
+  TrainingMetrics metrics;
+  metrics.epochsCount = 50;
+  ASSERT_TRUE(TrainingLog::parse("epoch 2/0", metrics));
+  EXPECT_EQ(metrics.epoch, 2u);
+  EXPECT_EQ(metrics.epochsCount, 50u);
+}
+
+TEST(TrainingLog, DropsOutOfRangeCounts)
+{
+  TrainingMetrics metrics;
+  ASSERT_TRUE(TrainingLog::parse("epoch 99999999999 loss 1.0", metrics));
+  EXPECT_FALSE(metrics.epoch);
+  EXPECT_FALSE(TrainingLog::parse("epoch -1", metrics));
+}
+
+TEST(TrainingLog, ParsesInTheCLocale)
+{
+  std::locale commaLocale;
+  try
+  {
+    commaLocale = std::locale("de_DE.UTF-8");
+  }
+  catch (std::runtime_error const&)
+  {
+    GTEST_SKIP() << "no de_DE locale";
+  }
+  auto const previousLocale = std::locale::global(commaLocale);
+  TrainingMetrics metrics;
+  auto const isParsed = TrainingLog::parse("loss 0.125", metrics);
+  std::locale::global(previousLocale);
+  ASSERT_TRUE(isParsed);
+  EXPECT_DOUBLE_EQ(*metrics.loss, 0.125);
+}
@@ -0,0 +1,71 @@
+#include "ValidationMetrics.hpp"
+
+#include <gtest/gtest.h>
+
+namespace {
+auto mask(std::initializer_list<uint8_t> values) -> cv::Mat
+{
+  return cv::Mat(std::vector<uint8_t>(values), true).reshape(1, 2);
+}
+
+auto indexOptions() -> ValidationOptions
+{
+  ValidationOptions options;
+  options.classNames = {"cat", "dog"};
+  options.isClassIndexMasks = true;
+  return options;
+}
+} /// end namespace anonymous
+
+TEST(ValidationMetrics, CountsPixelsPerClass)
+{
+  std::vector<ClassMetrics> classes;
+  std::vector<uint64_t> confusion;
+  ValidationMetrics::accumulate({mask({255, 255, 0, 0}), mask({0, 0, 0, 255})}, mask({1, 0, 2, 2}), indexOptions(), classes, confusion);
+
+  ASSERT_EQ(classes.size(), 2u);
+  EXPECT_EQ(classes[0].truePositives, 1u);
+  EXPECT_EQ(classes[0].falsePositives, 1u);
+  EXPECT_EQ(classes[0].falseNegatives, 0u);
+  EXPECT_EQ(classes[1].truePositives, 1u);
+  EXPECT_EQ(classes[1].falsePositives, 0u);
+  EXPECT_EQ(classes[1].falseNegatives, 1u);
+  EXPECT_DOUBLE_EQ(classes[0].iou(), 0.5);
+  EXPECT_DOUBLE_EQ(classes[1].dice(), 2.0 / 3.0);
+  /// Rows are the truth, columns the prediction
+  EXPECT_EQ(confusion, (std::vector<uint64_t>{0, 1, 0,
+                                              0, 1, 0,
+                                              1, 0, 1}));
+}
+
+TEST(ValidationMetrics, CountsOverlappingPredictionsAsTheFirstClass)
+{
+  std::vector<ClassMetrics> classes;
+  std::vector<uint64_t> confusion;
+  ValidationMetrics::accumulate({mask({0, 0, 255, 0}), mask({0, 0, 255, 0})}, mask({0, 0, 2, 0}), indexOptions(), classes, confusion);
+
+  EXPECT_EQ(classes[1].truePositives, 1u);
+  EXPECT_EQ(confusion[2 * 3 + 1], 1u);
+  EXPECT_EQ(confusion[2 * 3 + 2], 0u);
+}
+
+TEST(ValidationMetrics, MissingOutputsAreNeverPredicted)
+{
+  std::vector<ClassMetrics> classes;
+  std::vector<uint64_t> confusion;
+  ValidationMetrics::accumulate({mask({255, 0, 0, 0})}, mask({1, 2, 2, 0}), indexOptions(), classes, confusion);
+
+  EXPECT_EQ(classes[1].truePositives, 0u);
+  EXPECT_EQ(classes[1].falseNegatives, 2u);
+}
+
+TEST(ValidationMetrics, RatiosOfEmptySetsAreOne)
+{
+  ClassMetrics metrics;
+  EXPECT_DOUBLE_EQ(metrics.iou(), 1.0);
+  EXPECT_DOUBLE_EQ(metrics.precision(), 1.0);
+  EXPECT_DOUBLE_EQ(metrics.recall(), 1.0);
+  metrics.truePositives = 3;
+  metrics.falsePositives = 1;
+  EXPECT_DOUBLE_EQ(metrics.precision(), 0.75);
+}